@@ -0,0 +1,39 @@
+#pragma once
+
+#include "oracle_helpers.h"
+
+#include "fmt/format.h"
+
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace sqlplusplus {
+
+// Exit code that ctest reports as a skipped test.
+constexpr int kSkipExitCode = 77;
+
+// Reads the connection from SQLPLUSPLUS_TEST_CONNECT, formatted as user/password@connstring.
+inline std::optional<OracleConnectionOptions> benchConnectOptions() {
+    auto var = ::getenv("SQLPLUSPLUS_TEST_CONNECT");
+    if (var == nullptr) {
+        fmt::print(stderr, "SQLPLUSPLUS_TEST_CONNECT isn't set, skipping\n");
+        return std::nullopt;
+    }
+
+    std::string_view value(var);
+    auto slash = value.find('/');
+    auto at = value.rfind('@');
+    if (slash == std::string_view::npos || at == std::string_view::npos || at < slash) {
+        throw std::runtime_error("SQLPLUSPLUS_TEST_CONNECT must be user/password@connstring");
+    }
+
+    OracleConnectionOptions opts;
+    opts.username = std::string(value.substr(0, slash));
+    opts.password = std::string(value.substr(slash + 1, at - slash - 1));
+    opts.connString = std::string(value.substr(at + 1));
+    return opts;
+}
+
+} // namespace sqlplusplus
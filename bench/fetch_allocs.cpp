@@ -0,0 +1,93 @@
+#include "bench_connect.h"
+#include "oracle_helpers.h"
+
+#include "fmt/format.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+
+using namespace sqlplusplus;
+
+namespace {
+
+std::atomic<uint64_t> allocations = 0;
+
+constexpr uint64_t kRows = 200000;
+constexpr auto kQuery =
+    "select cast(level as number(18)), cast(level as binary_double), 'row ' || level, "
+    "systimestamp from dual connect by level <= 200000";
+
+} // namespace
+
+// Counts every C++ heap allocation in the process. ODPI allocates with malloc, so only
+// allocations made by our own code show up here.
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// Fetches a query with one column of each common native type and reads every value,
+// counting the allocations made after the first row. The fetch and value accessors are
+// expected to make none.
+int main() try {
+    auto connOpts = benchConnectOptions();
+    if (!connOpts) {
+        return kSkipExitCode;
+    }
+
+    auto ctx = OracleContext::make();
+    auto conn = OracleConnection::make(ctx.get(), *connOpts);
+    auto stmt = conn.prepareStatement(kQuery);
+    stmt.setFetchArraySize(1000);
+    stmt.execute();
+
+    // The first fetch allocates the define buffers.
+    if (!stmt.fetch()) {
+        fmt::print(stderr, "query returned no rows\n");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto before = allocations.load(std::memory_order_relaxed);
+    uint64_t rows = 0;
+    int64_t intSum = 0;
+    double doubleSum = 0;
+    size_t textBytes = 0;
+    int64_t years = 0;
+    do {
+        intSum += stmt.getColumnValue(1).as<int64_t>();
+        doubleSum += stmt.getColumnValue(2).as<double>();
+        textBytes += stmt.getColumnValue(3).as<std::string_view>().size();
+        years += stmt.getColumnValue(4).as<dpiTimestamp*>()->year;
+        ++rows;
+    } while (stmt.fetch());
+    auto made = allocations.load(std::memory_order_relaxed) - before;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    fmt::print("{} rows in {:.3f}s, {} allocations ({:.4f} per row), checksum {}\n",
+               rows, elapsed.count(), made, static_cast<double>(made) / rows,
+               intSum + static_cast<int64_t>(doubleSum) + textBytes + years);
+    if (rows != kRows) {
+        fmt::print(stderr, "fetched {} rows, expected {}\n", rows, kRows);
+        return 1;
+    }
+    return made == 0 ? 0 : 1;
+} catch (const OracleException& e) {
+    fmt::print(stderr, "Fatal error {}: {}\n", e.context(), e.what());
+    return 1;
+}
@@ -0,0 +1,99 @@
+#include "value_format.h"
+
+#include "fmt/format.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+using namespace sqlplusplus;
+
+namespace {
+
+constexpr uint64_t kIterations = 5000000;
+constexpr size_t kBufferSize = kMaxIntervalLength > kMaxTimestampLength ? kMaxIntervalLength : kMaxTimestampLength;
+
+// Formats a value that changes on every iteration, so the work can't be hoisted out of the
+// loop, and prints the time per call. The output lengths are summed into the returned
+// checksum to keep the calls from being optimized away.
+template <typename Format>
+uint64_t timeFormat(std::string_view name, Format format) {
+    char buf[kBufferSize];
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < kIterations; ++i) {
+        checksum += format(buf, i) + static_cast<unsigned char>(buf[0]);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("{:<18} {:>7.1f} ns/call\n", name, elapsed.count() / kIterations);
+    return checksum;
+}
+
+// Returns whether format writes expected, printing the difference if it doesn't.
+template <typename Format>
+bool check(std::string_view name, Format format, std::string_view expected) {
+    char buf[kBufferSize];
+    std::string_view actual(buf, format(buf));
+    if (actual != expected) {
+        fmt::print(stderr, "{} wrote {}, expected {}\n", name, actual, expected);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// Times the temporal formatters used for every fetched DATE, TIMESTAMP and INTERVAL value.
+// Needs no database, so it always runs; it fails only if a formatter writes a wrong value.
+int main() {
+    const TemporalFormat withZone{6, true};
+    const TemporalFormat millis{3, false};
+
+    bool ok = check("formatTimestamp", [&](char* out) {
+        return formatTimestamp(out, dpiTimestamp{2021, 3, 5, 4, 7, 9, 0, 5, 30}, withZone);
+    }, "2021-03-05T04:07:09.000000+05:30");
+    ok &= check("formatIntervalDS", [](char* out) {
+        return formatIntervalDS(out, dpiIntervalDS{3, 4, 5, 6, 500000000}, 3);
+    }, "P3DT04H05M06.500S");
+    ok &= check("formatIntervalYM", [](char* out) {
+        return formatIntervalYM(out, dpiIntervalYM{2, 3});
+    }, "P2Y03M");
+    if (!ok) {
+        return 1;
+    }
+
+    uint64_t checksum = 0;
+    checksum += timeFormat("formatTimestamp", [&](char* out, uint64_t i) {
+        const dpiTimestamp ts{static_cast<int16_t>(1900 + i % 200), static_cast<uint8_t>(1 + i % 12),
+                              static_cast<uint8_t>(1 + i % 28), static_cast<uint8_t>(i % 24),
+                              static_cast<uint8_t>(i % 60), static_cast<uint8_t>(i % 60),
+                              static_cast<uint32_t>(i % 1000000000), 0, 0};
+        return formatTimestamp(out, ts, millis);
+    });
+    checksum += timeFormat("  with time zone", [&](char* out, uint64_t i) {
+        const dpiTimestamp ts{static_cast<int16_t>(1900 + i % 200), static_cast<uint8_t>(1 + i % 12),
+                              static_cast<uint8_t>(1 + i % 28), static_cast<uint8_t>(i % 24),
+                              static_cast<uint8_t>(i % 60), static_cast<uint8_t>(i % 60),
+                              static_cast<uint32_t>(i % 1000000000), static_cast<int8_t>(i % 27 - 13),
+                              static_cast<int8_t>(i % 2 * 30)};
+        return formatTimestamp(out, ts, withZone);
+    });
+    checksum += timeFormat("formatIntervalDS", [](char* out, uint64_t i) {
+        const auto sign = i % 2 == 0 ? 1 : -1;
+        const dpiIntervalDS interval{static_cast<int32_t>(sign * static_cast<int32_t>(i % 100000)),
+                                     static_cast<int32_t>(sign * static_cast<int32_t>(i % 24)),
+                                     static_cast<int32_t>(sign * static_cast<int32_t>(i % 60)),
+                                     static_cast<int32_t>(sign * static_cast<int32_t>(i % 60)),
+                                     static_cast<int32_t>(sign * static_cast<int32_t>(i % 1000000000))};
+        return formatIntervalDS(out, interval, kMaxFractionalDigits);
+    });
+    checksum += timeFormat("formatIntervalYM", [](char* out, uint64_t i) {
+        const auto sign = i % 2 == 0 ? 1 : -1;
+        const dpiIntervalYM interval{static_cast<int32_t>(sign * static_cast<int32_t>(i % 10000)),
+                                     static_cast<int32_t>(sign * static_cast<int32_t>(i % 12))};
+        return formatIntervalYM(out, interval);
+    });
+    fmt::print("checksum {}\n", checksum);
+    return 0;
+}
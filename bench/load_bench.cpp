@@ -0,0 +1,78 @@
+#include "bench_connect.h"
+#include "oracle_helpers.h"
+#include "table_load.h"
+
+#include "fmt/format.h"
+#include "fmt/os.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace sqlplusplus;
+
+namespace {
+
+constexpr uint64_t kRows = 1000000;
+constexpr auto kTable = "sqlplusplus_load_bench";
+
+// Writes a CSV file with a header and kRows rows of a number, a short string and a
+// decimal, and returns its path.
+std::string writeCsv() {
+    auto path = fmt::format("/tmp/sqlplusplus_load_bench_{}.csv", ::getpid());
+    auto out = fmt::output_file(path);
+    out.print("ID,NAME,AMOUNT\n");
+    for (uint64_t row = 1; row <= kRows; ++row) {
+        out.print("{},name {},{}.{:02}\n", row, row % 1000, row % 100000, row % 100);
+    }
+    return path;
+}
+
+void execute(OracleConnection& conn, std::string_view sql) {
+    conn.prepareStatement(sql).execute();
+}
+
+void runLoad(OracleConnection& conn, const std::string& path, std::string_view mode, const TableLoadOptions& opts) {
+    execute(conn, fmt::format("truncate table {}", kTable));
+    const auto stats = loadCsv(conn, kTable, path, CsvOptions{}, opts, std::cerr);
+    fmt::print("{:<24} {:>9} rows {:>8.3f}s {:>10.0f} rows/s {:>5} commits\n",
+               mode, stats.rows, stats.seconds, stats.rows / stats.seconds, stats.commits);
+}
+
+} // namespace
+
+// Loads the same CSV file conventionally and with direct-path inserts, with and without
+// NOLOGGING, into a table that's created for the run and dropped afterwards.
+int main() try {
+    auto connOpts = benchConnectOptions();
+    if (!connOpts) {
+        return kSkipExitCode;
+    }
+
+    auto ctx = OracleContext::make();
+    auto conn = OracleConnection::make(ctx.get(), *connOpts);
+    const auto path = writeCsv();
+    execute(conn, fmt::format("create table {} (id number(10), name varchar2(20), amount number(10, 2))", kTable));
+
+    int status = 0;
+    try {
+        TableLoadOptions opts;
+        runLoad(conn, path, "conventional", opts);
+        opts.directPath = true;
+        runLoad(conn, path, "direct path", opts);
+        opts.noLogging = true;
+        runLoad(conn, path, "direct path, nologging", opts);
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "{}\n", e.what());
+        status = 1;
+    }
+
+    execute(conn, fmt::format("drop table {} purge", kTable));
+    std::remove(path.c_str());
+    return status;
+} catch (const OracleException& e) {
+    fmt::print(stderr, "Fatal error {}: {}\n", e.context(), e.what());
+    return 1;
+}
@@ -0,0 +1,108 @@
+#include "bench_connect.h"
+#include "oracle_helpers.h"
+
+#include "fmt/format.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace sqlplusplus;
+
+namespace {
+
+// Far more threads than pool sessions, so most acquireConnection calls wait for a session
+// another thread is releasing.
+constexpr int kThreads = 32;
+constexpr int kIterations = 25;
+constexpr int64_t kRowsPerQuery = 500;
+constexpr auto kQuery = "select cast(level as number(18)) from dual connect by level <= 500";
+
+int64_t sumQuery(OracleConnection& conn) {
+    auto stmt = conn.prepareStatement(kQuery);
+    stmt.execute();
+    int64_t sum = 0;
+    while (stmt.fetch()) {
+        sum += stmt.getColumnValue(1).as<int64_t>();
+    }
+    return sum;
+}
+
+// Runs queries on pooled sessions from every thread at once and checks each result.
+int runPoolStress(OracleConnectionPool& pool) {
+    constexpr int64_t expected = kRowsPerQuery * (kRowsPerQuery + 1) / 2;
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < kIterations; ++j) {
+                try {
+                    auto conn = pool.acquireConnection();
+                    if (auto sum = sumQuery(conn); sum != expected) {
+                        fmt::print(stderr, "query returned {}, expected {}\n", sum, expected);
+                        ++failures;
+                    }
+                } catch (const OracleException& e) {
+                    fmt::print(stderr, "error {}: {}\n", e.context(), e.what());
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return failures;
+}
+
+// A statement used from a thread that doesn't own its connection must throw, and must work
+// once the connection has been claimed by that thread.
+int runOwnershipCheck(OracleConnectionPool& pool) {
+    auto conn = pool.acquireConnection();
+    auto stmt = conn.prepareStatement(kQuery);
+    int failures = 0;
+    std::thread([&] {
+        try {
+            stmt.execute();
+            fmt::print(stderr, "statement executed by a thread that doesn't own it\n");
+            ++failures;
+        } catch (const OracleException&) {
+        }
+
+        conn.claim();
+        try {
+            stmt.execute();
+            while (stmt.fetch()) {
+            }
+        } catch (const OracleException& e) {
+            fmt::print(stderr, "error after claiming {}: {}\n", e.context(), e.what());
+            ++failures;
+        }
+    }).join();
+    conn.claim();
+    return failures;
+}
+
+} // namespace
+
+int main() try {
+    auto connOpts = benchConnectOptions();
+    if (!connOpts) {
+        return kSkipExitCode;
+    }
+
+    auto ctx = OracleContext::make();
+    auto pool = OracleConnectionPool::make(ctx.get(), *connOpts);
+    auto failures = runPoolStress(pool) + runOwnershipCheck(pool);
+    if (failures > 0) {
+        fmt::print(stderr, "{} failures\n", failures);
+        return 1;
+    }
+    fmt::print("{} threads ran {} queries each on {} sessions\n",
+               kThreads, kIterations, OracleConnectionPoolOptions{}.maxSessions);
+    return 0;
+} catch (const OracleException& e) {
+    fmt::print(stderr, "Fatal error {}: {}\n", e.context(), e.what());
+    return 1;
+}
@@ -0,0 +1,389 @@
+#include "arrow_reader.h"
+
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// Message header types and field types, as numbered in Arrow's Message.fbs and Schema.fbs.
+constexpr uint8_t kSchemaMessage = 1;
+constexpr uint8_t kDictionaryBatchMessage = 2;
+constexpr uint8_t kRecordBatchMessage = 3;
+
+enum class FlatType : uint8_t {
+    Null = 1, Int = 2, FloatingPoint = 3, Binary = 4, Utf8 = 5, Bool = 6, Decimal = 7, Date = 8,
+    Timestamp = 10, LargeBinary = 19, LargeUtf8 = 20,
+};
+
+[[noreturn]] void malformed() {
+    throw std::runtime_error("malformed arrow metadata");
+}
+
+// Just enough of the flatbuffers wire format to walk Arrow's metadata. Tables start with
+// an offset back to their vtable, which holds the offset of each field within the table
+// or 0 when the field has its default value.
+class FlatBuffer {
+public:
+    explicit FlatBuffer(std::string_view buf) : _buf(buf) {}
+
+    template <typename T>
+    T read(size_t pos) const {
+        if (pos > _buf.size() || _buf.size() - pos < sizeof(T)) {
+            malformed();
+        }
+        T out;
+        std::memcpy(&out, _buf.data() + pos, sizeof(T));
+        return out;
+    }
+
+    size_t root() const {
+        return read<uint32_t>(0);
+    }
+
+    // Returns the position of the field's value in table, or 0 if it isn't present.
+    size_t field(size_t table, uint16_t id) const {
+        const auto vtable = static_cast<size_t>(static_cast<int64_t>(table) - read<int32_t>(table));
+        const auto vtableSize = read<uint16_t>(vtable);
+        const size_t entry = 4 + 2 * static_cast<size_t>(id);
+        if (entry + 2 > vtableSize) {
+            return 0;
+        }
+        const auto offset = read<uint16_t>(vtable + entry);
+        return offset == 0 ? 0 : table + offset;
+    }
+
+    template <typename T>
+    T scalar(size_t table, uint16_t id, T defaultValue) const {
+        const auto pos = field(table, id);
+        return pos == 0 ? defaultValue : read<T>(pos);
+    }
+
+    // Follows the offset stored in a table, string or vector field; 0 if it isn't present.
+    size_t indirect(size_t table, uint16_t id) const {
+        const auto pos = field(table, id);
+        return pos == 0 ? 0 : pos + read<uint32_t>(pos);
+    }
+
+    std::string_view string(size_t table, uint16_t id) const {
+        const auto pos = indirect(table, id);
+        if (pos == 0) {
+            return {};
+        }
+        const auto length = read<uint32_t>(pos);
+        if (_buf.size() - pos - 4 < length) {
+            malformed();
+        }
+        return _buf.substr(pos + 4, length);
+    }
+
+    uint32_t vectorLength(size_t vector) const {
+        return vector == 0 ? 0 : read<uint32_t>(vector);
+    }
+
+    // The table stored at index idx of a vector of tables.
+    size_t tableAt(size_t vector, uint32_t idx) const {
+        const auto pos = vector + 4 + 4 * static_cast<size_t>(idx);
+        return pos + read<uint32_t>(pos);
+    }
+
+    // The start of the struct at index idx of a vector of structs.
+    size_t structAt(size_t vector, uint32_t idx, size_t structSize) const {
+        return vector + 4 + structSize * idx;
+    }
+
+private:
+    std::string_view _buf;
+};
+
+ArrowField parseField(const FlatBuffer& fb, size_t table) {
+    ArrowField out;
+    out.name = std::string(fb.string(table, 0));
+    if (fb.field(table, 4) != 0) {
+        throw std::runtime_error(fmt::format("column {} is dictionary encoded, which isn't supported", out.name));
+    }
+    if (fb.vectorLength(fb.indirect(table, 5)) != 0) {
+        throw std::runtime_error(fmt::format("column {} has a nested type, which isn't supported", out.name));
+    }
+
+    const auto typeType = static_cast<FlatType>(fb.scalar<uint8_t>(table, 2, 0));
+    const auto type = fb.indirect(table, 3);
+    if (type == 0 && typeType != FlatType::Null) {
+        malformed();
+    }
+    switch (typeType) {
+    case FlatType::Null:
+        out.type = ArrowField::Type::Null;
+        break;
+    case FlatType::Int:
+        out.type = ArrowField::Type::Int;
+        out.bitWidth = fb.scalar<int32_t>(type, 0, 0);
+        out.isSigned = fb.scalar<uint8_t>(type, 1, 0) != 0;
+        if (out.bitWidth != 8 && out.bitWidth != 16 && out.bitWidth != 32 && out.bitWidth != 64) {
+            malformed();
+        }
+        break;
+    case FlatType::FloatingPoint: {
+        out.type = ArrowField::Type::FloatingPoint;
+        const auto precision = fb.scalar<int16_t>(type, 0, 0);
+        if (precision == 0) {
+            throw std::runtime_error(fmt::format("column {} has half-precision floats, which aren't supported", out.name));
+        }
+        out.bitWidth = precision == 1 ? 32 : 64;
+        break;
+    }
+    case FlatType::Binary:
+        out.type = ArrowField::Type::Binary;
+        break;
+    case FlatType::Utf8:
+        out.type = ArrowField::Type::Utf8;
+        break;
+    case FlatType::LargeBinary:
+        out.type = ArrowField::Type::LargeBinary;
+        break;
+    case FlatType::LargeUtf8:
+        out.type = ArrowField::Type::LargeUtf8;
+        break;
+    case FlatType::Bool:
+        out.type = ArrowField::Type::Bool;
+        break;
+    case FlatType::Decimal:
+        out.type = ArrowField::Type::Decimal;
+        out.precision = fb.scalar<int32_t>(type, 0, 0);
+        out.scale = fb.scalar<int32_t>(type, 1, 0);
+        out.bitWidth = fb.scalar<int32_t>(type, 2, 128);
+        if (out.bitWidth != 128) {
+            throw std::runtime_error(fmt::format("column {} has {}-bit decimals, only 128-bit ones are supported",
+                                                 out.name, out.bitWidth));
+        }
+        if (out.precision < 1 || out.precision > kMaxNumberPrecision) {
+            throw std::runtime_error(fmt::format("column {} has decimal precision {}, which isn't between 1 and {}",
+                                                 out.name, out.precision, kMaxNumberPrecision));
+        }
+        if (out.scale < kMinNumberScale || out.scale > kMaxNumberScale) {
+            throw std::runtime_error(fmt::format("column {} has decimal scale {}, which isn't between {} and {}",
+                                                 out.name, out.scale, kMinNumberScale, kMaxNumberScale));
+        }
+        break;
+    case FlatType::Date:
+        out.type = ArrowField::Type::Date;
+        // DateUnit is DAY = 0 or MILLISECOND = 1, the default.
+        out.unit = fb.scalar<int16_t>(type, 0, 1) == 0 ? ArrowField::TimeUnit::Day
+                                                       : ArrowField::TimeUnit::Millisecond;
+        break;
+    case FlatType::Timestamp: {
+        out.type = ArrowField::Type::Timestamp;
+        const auto unit = fb.scalar<int16_t>(type, 0, 0);
+        if (unit < 0 || unit > 3) {
+            malformed();
+        }
+        out.unit = static_cast<ArrowField::TimeUnit>(unit);
+        out.hasTimezone = !fb.string(type, 1).empty();
+        break;
+    }
+    default:
+        throw std::runtime_error(fmt::format("column {} has arrow type {}, which isn't supported",
+                                             out.name, static_cast<int>(typeType)));
+    }
+    return out;
+}
+
+// Variable-width values are read through their offsets, which must stay inside the data.
+template <typename OffsetType>
+void checkOffsets(const ArrowArray& array) {
+    OffsetType previous = 0;
+    for (uint64_t idx = 0; array.length != 0 && idx <= array.length; ++idx) {
+        const auto offset = array.valueAt<OffsetType>(idx);
+        if (offset < previous || static_cast<uint64_t>(offset) > array.dataSize) {
+            malformed();
+        }
+        previous = offset;
+    }
+}
+
+size_t numBuffers(ArrowField::Type type) {
+    switch (type) {
+    case ArrowField::Type::Null:
+        return 0;
+    case ArrowField::Type::Binary:
+    case ArrowField::Type::Utf8:
+    case ArrowField::Type::LargeBinary:
+    case ArrowField::Type::LargeUtf8:
+        return 3;
+    default:
+        return 2;
+    }
+}
+} // namespace
+
+ArrowStreamReader::ArrowStreamReader(const std::string& path) : _file(path), _contents(_file.contents()) {
+    _file.adviseSequential();
+    // The file format is the stream format between a magic header and a footer.
+    if (_contents.substr(0, 6) == "ARROW1") {
+        _pos = 8;
+    }
+
+    auto schema = _nextMessage();
+    if (!schema || schema->headerType != kSchemaMessage) {
+        throw std::runtime_error(fmt::format("{} doesn't start with an arrow schema", path));
+    }
+
+    FlatBuffer fb(schema->metadata);
+    if (fb.scalar<int16_t>(schema->header, 0, 0) != 0) {
+        throw std::runtime_error("big-endian arrow data isn't supported");
+    }
+    const auto fields = fb.indirect(schema->header, 1);
+    for (uint32_t idx = 0; idx < fb.vectorLength(fields); ++idx) {
+        _fields.push_back(parseField(fb, fb.tableAt(fields, idx)));
+    }
+    if (_fields.empty()) {
+        throw std::runtime_error(fmt::format("{} has no columns", path));
+    }
+}
+
+std::optional<ArrowStreamReader::Message> ArrowStreamReader::_nextMessage() {
+    FlatBuffer file(_contents);
+    if (_pos + 4 > _contents.size()) {
+        return std::nullopt;
+    }
+    // Streams since Arrow 0.15 put a continuation marker before the metadata length.
+    auto length = file.read<int32_t>(_pos);
+    _pos += 4;
+    if (length == -1) {
+        length = file.read<int32_t>(_pos);
+        _pos += 4;
+    }
+    if (length == 0) {
+        _pos = _contents.size();
+        return std::nullopt;
+    }
+    if (length < 0 || static_cast<size_t>(length) > _contents.size() - _pos) {
+        malformed();
+    }
+
+    Message out;
+    out.metadata = _contents.substr(_pos, static_cast<size_t>(length));
+    _pos += static_cast<size_t>(length);
+
+    FlatBuffer fb(out.metadata);
+    const auto message = fb.root();
+    out.headerType = fb.scalar<uint8_t>(message, 1, 0);
+    out.header = fb.indirect(message, 2);
+    const auto bodyLength = fb.scalar<int64_t>(message, 3, 0);
+    if (out.header == 0 || bodyLength < 0 || static_cast<uint64_t>(bodyLength) > _contents.size() - _pos) {
+        malformed();
+    }
+    out.body = _contents.substr(_pos, static_cast<size_t>(bodyLength));
+    _pos += static_cast<size_t>(bodyLength);
+    return out;
+}
+
+std::optional<ArrowRecordBatch> ArrowStreamReader::next() {
+    for (;;) {
+        auto message = _nextMessage();
+        if (!message) {
+            return std::nullopt;
+        }
+        if (message->headerType == kDictionaryBatchMessage) {
+            throw std::runtime_error("arrow dictionaries aren't supported");
+        }
+        if (message->headerType != kRecordBatchMessage) {
+            continue;
+        }
+
+        FlatBuffer fb(message->metadata);
+        const auto header = message->header;
+        if (fb.field(header, 3) != 0) {
+            throw std::runtime_error("compressed arrow record batches aren't supported");
+        }
+
+        ArrowRecordBatch out;
+        out.numRows = static_cast<uint64_t>(fb.scalar<int64_t>(header, 0, 0));
+        const auto nodes = fb.indirect(header, 1);
+        const auto buffers = fb.indirect(header, 2);
+        if (fb.vectorLength(nodes) != _fields.size()) {
+            malformed();
+        }
+
+        // Field nodes are {length, null count} and buffers {offset, length}, both int64 pairs.
+        constexpr size_t kStructSize = 16;
+        uint32_t nextBuffer = 0;
+        auto buffer = [&](size_t& size) -> const uint8_t* {
+            if (nextBuffer >= fb.vectorLength(buffers)) {
+                malformed();
+            }
+            const auto pos = fb.structAt(buffers, nextBuffer++, kStructSize);
+            const auto offset = fb.read<int64_t>(pos);
+            const auto length = fb.read<int64_t>(pos + 8);
+            if (offset < 0 || length < 0 || static_cast<uint64_t>(offset) > message->body.size() ||
+                static_cast<uint64_t>(length) > message->body.size() - static_cast<uint64_t>(offset)) {
+                malformed();
+            }
+            size = static_cast<size_t>(length);
+            return length == 0 ? nullptr
+                               : reinterpret_cast<const uint8_t*>(message->body.data()) + offset;
+        };
+
+        for (uint32_t idx = 0; idx < _fields.size(); ++idx) {
+            const auto& field = _fields[idx];
+            auto& array = out.columns.emplace_back();
+            const auto node = fb.structAt(nodes, idx, kStructSize);
+            array.length = static_cast<uint64_t>(fb.read<int64_t>(node));
+            array.nullCount = static_cast<uint64_t>(fb.read<int64_t>(node + 8));
+            if (array.length != out.numRows) {
+                malformed();
+            }
+
+            const auto count = numBuffers(field.type);
+            if (count == 0) {
+                continue;
+            }
+            size_t validitySize;
+            array.validity = buffer(validitySize);
+            if (array.validity != nullptr && validitySize < (array.length + 7) / 8) {
+                malformed();
+            }
+            array.values = buffer(array.valuesSize);
+            if (count == 3) {
+                array.data = buffer(array.dataSize);
+            }
+
+            // Check the buffers are big enough for every value they're read for.
+            size_t needed = 0;
+            switch (field.type) {
+            case ArrowField::Type::Bool:
+                needed = (array.length + 7) / 8;
+                break;
+            case ArrowField::Type::Binary:
+            case ArrowField::Type::Utf8:
+                needed = array.length == 0 ? 0 : (array.length + 1) * 4;
+                break;
+            case ArrowField::Type::LargeBinary:
+            case ArrowField::Type::LargeUtf8:
+                needed = array.length == 0 ? 0 : (array.length + 1) * 8;
+                break;
+            case ArrowField::Type::Date:
+                needed = array.length * (field.unit == ArrowField::TimeUnit::Day ? 4 : 8);
+                break;
+            case ArrowField::Type::Timestamp:
+                needed = array.length * 8;
+                break;
+            default:
+                needed = array.length * static_cast<size_t>(field.bitWidth) / 8;
+                break;
+            }
+            if (array.valuesSize < needed) {
+                malformed();
+            }
+            if (field.type == ArrowField::Type::LargeBinary || field.type == ArrowField::Type::LargeUtf8) {
+                checkOffsets<int64_t>(array);
+            } else if (field.type == ArrowField::Type::Binary || field.type == ArrowField::Type::Utf8) {
+                checkOffsets<int32_t>(array);
+            }
+        }
+        return out;
+    }
+}
+
+} // namespace sqlplusplus
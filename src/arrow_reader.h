@@ -0,0 +1,112 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sqlplusplus {
+
+// Decimal fields are loaded into NUMBER columns, fields outside NUMBER's precision and
+// scale are rejected when the schema is read.
+constexpr int32_t kMaxNumberPrecision = 38;
+constexpr int32_t kMinNumberScale = -84;
+constexpr int32_t kMaxNumberScale = 127;
+
+// The flat column types the reader supports. Nested, dictionary-encoded and compressed
+// data isn't supported.
+struct ArrowField {
+    enum class Type { Null, Int, FloatingPoint, Binary, Utf8, Bool, Decimal, Date, Timestamp, LargeBinary, LargeUtf8 };
+    // Units of Timestamp values, as numbered by Arrow. Dates are in days or milliseconds.
+    enum class TimeUnit { Second = 0, Millisecond = 1, Microsecond = 2, Nanosecond = 3, Day };
+
+    std::string name;
+    Type type = Type::Null;
+    // Int: 8, 16, 32 or 64. FloatingPoint: 32 or 64. Decimal: 128.
+    int32_t bitWidth = 0;
+    bool isSigned = true;
+    TimeUnit unit = TimeUnit::Millisecond;
+    int32_t precision = 0;
+    int32_t scale = 0;
+    bool hasTimezone = false;
+};
+
+// One column of a record batch, pointing into the mapped file.
+struct ArrowArray {
+    uint64_t length = 0;
+    uint64_t nullCount = 0;
+    // One bit per value, least significant first. Null when every value is valid.
+    const uint8_t* validity = nullptr;
+    // The fixed-width values, or the offsets of variable-width ones.
+    const uint8_t* values = nullptr;
+    size_t valuesSize = 0;
+    // The bytes of variable-width values.
+    const uint8_t* data = nullptr;
+    size_t dataSize = 0;
+
+    bool isValid(uint64_t idx) const noexcept {
+        return validity == nullptr || (validity[idx / 8] >> (idx % 8) & 1) != 0;
+    }
+
+    template <typename T>
+    T valueAt(uint64_t idx) const noexcept {
+        T out;
+        std::memcpy(&out, values + idx * sizeof(T), sizeof(T));
+        return out;
+    }
+
+    // The bytes of a Binary/Utf8 value, OffsetType is int64_t for the Large variants.
+    template <typename OffsetType>
+    std::string_view bytesAt(uint64_t idx) const noexcept {
+        const auto begin = valueAt<OffsetType>(idx);
+        const auto end = valueAt<OffsetType>(idx + 1);
+        return std::string_view(reinterpret_cast<const char*>(data) + begin, static_cast<size_t>(end - begin));
+    }
+};
+
+struct ArrowRecordBatch {
+    uint64_t numRows = 0;
+    std::vector<ArrowArray> columns;
+};
+
+// Reads an Arrow IPC stream, or an Arrow file by skipping its magic and ignoring its
+// footer. The flatbuffer metadata is parsed directly, with every offset bounds checked,
+// and column buffers are used in place in the mapped file.
+class ArrowStreamReader {
+public:
+    // Reads the schema. Throws std::runtime_error for a malformed file or unsupported types.
+    explicit ArrowStreamReader(const std::string& path);
+
+    const std::vector<ArrowField>& fields() const noexcept {
+        return _fields;
+    }
+
+    size_t fileSize() const noexcept {
+        return _file.size();
+    }
+
+    // Returns nullopt after the last record batch. The arrays stay valid as long as the reader.
+    std::optional<ArrowRecordBatch> next();
+
+private:
+    struct Message {
+        uint8_t headerType = 0;
+        std::string_view metadata;
+        size_t header = 0;
+        std::string_view body;
+    };
+
+    std::optional<Message> _nextMessage();
+
+    MappedFile _file;
+    std::string_view _contents;
+    size_t _pos = 0;
+    std::vector<ArrowField> _fields;
+};
+
+} // namespace sqlplusplus
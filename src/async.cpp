@@ -0,0 +1,54 @@
+#include "async.h"
+
+#include <algorithm>
+
+namespace sqlplusplus {
+
+WorkerPool::WorkerPool(size_t numThreads) {
+    _threads.reserve(numThreads);
+    for (size_t idx = 0; idx < numThreads; ++idx) {
+        _threads.emplace_back([this] { _run(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeup.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+    _wakeup.notify_one();
+}
+
+WorkerPool& WorkerPool::shared() {
+    static WorkerPool pool(std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8));
+    return pool;
+}
+
+void WorkerPool::_run() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeup.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_jobs.empty()) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,331 @@
+#pragma once
+
+#include "oracle_helpers.h"
+#include "result_set.h"
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlplusplus {
+
+// A fixed set of threads that run the blocking ODPI calls made on behalf of coroutines.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t numThreads);
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    // Finishes the queued jobs before joining the threads.
+    ~WorkerPool();
+
+    void submit(std::function<void()> job);
+
+    // The pool used when callers don't supply one, sized to the machine but kept small
+    // since its threads spend nearly all their time waiting on the network.
+    static WorkerPool& shared();
+
+private:
+    void _run();
+
+    std::mutex _mutex;
+    std::condition_variable _wakeup;
+    std::deque<std::function<void()>> _jobs;
+    bool _stopping = false;
+    std::vector<std::thread> _threads;
+};
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+class TaskPromiseBase {
+public:
+    std::suspend_always initial_suspend() noexcept {
+        return {};
+    }
+
+    // Hands control straight back to whoever awaited the task.
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            return handle.promise()._continuation;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept {
+        return {};
+    }
+
+    void unhandled_exception() noexcept {
+        _error = std::current_exception();
+    }
+
+    void setContinuation(std::coroutine_handle<> continuation) noexcept {
+        _continuation = continuation;
+    }
+
+protected:
+    void _rethrowIfFailed() const {
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+    }
+
+private:
+    std::coroutine_handle<> _continuation = std::noop_coroutine();
+    std::exception_ptr _error;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value) {
+        _value.emplace(std::forward<U>(value));
+    }
+
+    T result() {
+        _rethrowIfFailed();
+        return std::move(*_value);
+    }
+
+private:
+    std::optional<T> _value;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        _rethrowIfFailed();
+    }
+};
+
+// Fire-and-forget coroutine used to drive a Task from non-coroutine code.
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+} // namespace detail
+
+// A lazily started coroutine producing a T. It starts running when it's awaited and
+// resumes its awaiter when it finishes, on whichever thread it finished on.
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (_handle) {
+                _handle.destroy();
+            }
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        _handle.promise().setContinuation(awaiter);
+        return _handle;
+    }
+
+    T await_resume() {
+        return _handle.promise().result();
+    }
+
+private:
+    friend promise_type;
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : _handle(handle) {}
+
+    std::coroutine_handle<promise_type> _handle;
+};
+
+template <typename T>
+Task<T> detail::TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> detail::TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Starts task on the calling thread and returns a future that's ready once it finishes.
+template <typename T>
+std::future<T> startTask(Task<T> task) {
+    std::promise<T> done;
+    auto result = done.get_future();
+    [](Task<T> task, std::promise<T> done) -> detail::DetachedTask {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await task;
+                done.set_value();
+            } else {
+                done.set_value(co_await task);
+            }
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    }(std::move(task), std::move(done));
+    return result;
+}
+
+// Runs task to completion, blocking the calling thread until it's done.
+template <typename T>
+T syncWait(Task<T> task) {
+    return startTask(std::move(task)).get();
+}
+
+// Starts task on the calling thread without waiting for it to finish. The task must
+// handle its own errors, an exception escaping it terminates the program.
+inline void spawn(Task<void> task) {
+    [](Task<void> task) -> detail::DetachedTask {
+        co_await task;
+    }(std::move(task));
+}
+
+// Awaitable that runs fn on a pool thread and resumes the awaiting coroutine there once
+// it returns, rethrowing anything fn threw.
+template <typename Fn>
+class BlockingCall {
+public:
+    using Result = std::invoke_result_t<Fn&>;
+
+    BlockingCall(WorkerPool& pool, Fn fn) : _pool(pool), _fn(std::move(fn)) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiter) {
+        _pool.submit([this, awaiter] {
+            try {
+                if constexpr (std::is_void_v<Result>) {
+                    _fn();
+                } else {
+                    _result.emplace(_fn());
+                }
+            } catch (...) {
+                _error = std::current_exception();
+            }
+            awaiter.resume();
+        });
+    }
+
+    Result await_resume() {
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+        if constexpr (!std::is_void_v<Result>) {
+            return std::move(*_result);
+        }
+    }
+
+private:
+    struct Empty {};
+
+    WorkerPool& _pool;
+    Fn _fn;
+    std::conditional_t<std::is_void_v<Result>, Empty, std::optional<Result>> _result;
+    std::exception_ptr _error;
+};
+
+template <typename Fn>
+BlockingCall<Fn> runBlocking(WorkerPool& pool, Fn fn) {
+    return BlockingCall<Fn>(pool, std::move(fn));
+}
+
+// Coroutines hop between pool threads at every await, so the awaitables that use a
+// connection claim it (see OracleConnection::claim) on the thread that runs the call.
+// Anything else awaited while a connection is in use must not touch that connection.
+
+inline auto acquireConnectionAsync(OracleConnectionPool& connections, WorkerPool& pool = WorkerPool::shared()) {
+    return runBlocking(pool, [&connections] {
+        return connections.acquireConnection();
+    });
+}
+
+inline auto prepareAsync(OracleConnection& conn, std::string_view sql, WorkerPool& pool = WorkerPool::shared()) {
+    return runBlocking(pool, [&conn, sql] {
+        conn.claim();
+        return conn.prepareStatement(sql);
+    });
+}
+
+// conn is the connection stmt was prepared on.
+inline auto executeAsync(OracleConnection& conn, OracleStatement& stmt, WorkerPool& pool = WorkerPool::shared()) {
+    return runBlocking(pool, [&conn, &stmt] {
+        conn.claim();
+        stmt.execute();
+    });
+}
+
+// Fetches up to maxRows more rows into results and returns how many were fetched, fewer
+// than maxRows means the statement has no more rows. conn is the connection stmt was
+// prepared on.
+inline auto fetchBlockAsync(OracleConnection& conn,
+                            OracleStatement& stmt,
+                            ResultSet& results,
+                            uint32_t maxRows,
+                            WorkerPool& pool = WorkerPool::shared()) {
+    return runBlocking(pool, [&conn, &stmt, &results, maxRows] {
+        conn.claim();
+        uint32_t fetched = 0;
+        while (fetched < maxRows && stmt.fetch()) {
+            results.appendRow(stmt);
+            ++fetched;
+        }
+        return fetched;
+    });
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,212 @@
+#include "background_jobs.h"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+constexpr size_t kMaxListedSqlLength = 60;
+
+std::string_view stateName(BackgroundJobs::State state) {
+    switch (state) {
+    case BackgroundJobs::State::Queued:
+        return "queued";
+    case BackgroundJobs::State::Running:
+        return "running";
+    case BackgroundJobs::State::Done:
+        return "done";
+    case BackgroundJobs::State::Failed:
+        return "failed";
+    }
+    return "unknown";
+}
+
+bool isFinished(BackgroundJobs::State state) {
+    return state == BackgroundJobs::State::Done || state == BackgroundJobs::State::Failed;
+}
+} // namespace
+
+BackgroundJobs::BackgroundJobs(OracleConnectionPool& sessions) :
+    _sessions(sessions),
+    _maxRunning(sessions.maxSessions())
+{}
+
+BackgroundJobs::~BackgroundJobs() {
+    shutdown();
+}
+
+uint32_t BackgroundJobs::start(std::string sql, const TemporalFormatSettings& temporal) {
+    auto job = std::make_unique<Job>();
+    job->id = _nextId++;
+    job->sql = std::move(sql);
+    auto& started = *_jobs.emplace(job->id, std::move(job)).first->second;
+    _admit(started, temporal);
+    return started.id;
+}
+
+void BackgroundJobs::_admit(Job& job, const TemporalFormatSettings& temporal) {
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        if (_running == _maxRunning) {
+            _queued.push_back(QueuedJob{&job, temporal});
+            return;
+        }
+        ++_running;
+    }
+    spawn(_run(job, temporal));
+}
+
+void BackgroundJobs::_startNext() {
+    QueuedJob next;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        if (_queued.empty()) {
+            --_running;
+            return;
+        }
+        next = _queued.front();
+        _queued.pop_front();
+    }
+    spawn(_run(*next.job, next.temporal));
+}
+
+Task<void> BackgroundJobs::_run(Job& job, TemporalFormatSettings temporal) {
+    {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.state = State::Running;
+    }
+
+    std::string error;
+    try {
+        if (job.cancelled) {
+            throw std::runtime_error("job cancelled");
+        }
+        auto conn = co_await acquireConnectionAsync(_sessions, _workers);
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (job.cancelled) {
+                throw std::runtime_error("job cancelled");
+            }
+            job.conn = conn;
+        }
+
+        auto stmt = co_await prepareAsync(conn, job.sql, _workers);
+        co_await executeAsync(conn, stmt, _workers);
+        if (stmt.numColumns() == 0) {
+            co_await runBlocking(_workers, [&conn] {
+                conn.claim();
+                conn.commit();
+            });
+        } else {
+            job.results.reset(stmt, temporal);
+            uint32_t fetched;
+            do {
+                fetched = co_await fetchBlockAsync(conn, stmt, job.results, kRowsPerBlock, _workers);
+                job.rowsFetched = job.results.numRows();
+            } while (fetched == kRowsPerBlock && !job.cancelled);
+        }
+    } catch (const OracleException& e) {
+        error = fmt::format("{}: {}", e.context(), e.what());
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.conn.reset();
+    }
+    // Hands this job's slot on before finishing, once every job has finished the shell
+    // may destroy this object.
+    _startNext();
+
+    // Nothing may touch job once the lock is dropped, the shell can remove it as soon as
+    // it sees the new state.
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.state = error.empty() ? State::Done : State::Failed;
+    job.error = std::move(error);
+    job.ended = Job::Clock::now();
+    job.finished.notify_all();
+}
+
+void BackgroundJobs::printJobs(std::ostream& out) const {
+    if (_jobs.empty()) {
+        out << "No background jobs" << std::endl;
+        return;
+    }
+
+    ResultSet listing;
+    const auto idCol = listing.addColumn("JOB", ResultSet::ColumnType::Int64);
+    const auto stateCol = listing.addColumn("STATE", ResultSet::ColumnType::Text);
+    const auto rowsCol = listing.addColumn("ROWS", ResultSet::ColumnType::Int64);
+    const auto elapsedCol = listing.addColumn("ELAPSED", ResultSet::ColumnType::Text);
+    const auto rateCol = listing.addColumn("ROWS/S", ResultSet::ColumnType::Int64);
+    const auto sqlCol = listing.addColumn("SQL", ResultSet::ColumnType::Text);
+
+    const auto now = Job::Clock::now();
+    for (const auto& [id, job] : _jobs) {
+        State state;
+        Job::Clock::time_point ended;
+        {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            state = job->state;
+            ended = isFinished(state) ? job->ended : now;
+        }
+        const auto rows = job->rowsFetched.load();
+        const std::chrono::duration<double> elapsed = ended - job->started;
+
+        listing.appendInt64(idCol, id);
+        listing.appendText(stateCol, stateName(state));
+        listing.appendInt64(rowsCol, static_cast<int64_t>(rows));
+        listing.appendText(elapsedCol, fmt::format("{:.1f}s", elapsed.count()));
+        if (elapsed.count() > 0) {
+            listing.appendInt64(rateCol, static_cast<int64_t>(rows / elapsed.count()));
+        } else {
+            listing.appendNull(rateCol);
+        }
+        listing.appendText(sqlCol, std::string_view(job->sql).substr(0, kMaxListedSqlLength));
+        listing.finishRow();
+    }
+    listing.render(out, listing.allRows());
+}
+
+std::unique_ptr<BackgroundJobs::Job> BackgroundJobs::wait(uint32_t id) {
+    auto it = _jobs.find(id);
+    if (it == _jobs.end()) {
+        throw std::runtime_error(fmt::format("no background job {}", id));
+    }
+
+    auto& job = *it->second;
+    {
+        std::unique_lock<std::mutex> lock(job.mutex);
+        job.finished.wait(lock, [&job] { return isFinished(job.state); });
+    }
+
+    auto out = std::move(it->second);
+    _jobs.erase(it);
+    return out;
+}
+
+void BackgroundJobs::shutdown() {
+    for (auto& [id, job] : _jobs) {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->cancelled = true;
+        if (job->conn) {
+            try {
+                job->conn->breakExecution();
+            } catch (const OracleException&) {
+                // The job is finishing anyway, it reports its own errors.
+            }
+        }
+    }
+
+    for (auto& [id, job] : _jobs) {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->finished.wait(lock, [&job] { return isFinished(job->state); });
+    }
+}
+
+} // namespace sqlplusplus
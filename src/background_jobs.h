@@ -0,0 +1,108 @@
+#pragma once
+
+#include "async.h"
+#include "oracle_helpers.h"
+#include "result_set.h"
+#include "value_format.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+// Statements started with a trailing '&' in the shell. Each job runs on its own session
+// from the pool, and spools every row it fetches into a ResultSet that's handed over
+// when the job is brought to the foreground.
+//
+// Jobs don't see the shell's bind variables or transaction, statements that aren't
+// queries are committed on their own session once they succeed.
+//
+// At most as many jobs run as the pool has sessions, later ones are queued until a running
+// job finishes. A job waiting for a session blocks a worker thread, so with more jobs
+// than workers every worker could end up waiting on sessions held by jobs that need a
+// worker to continue.
+class BackgroundJobs {
+public:
+    enum class State { Queued, Running, Done, Failed };
+
+    struct Job {
+        using Clock = std::chrono::steady_clock;
+
+        uint32_t id = 0;
+        std::string sql;
+        Clock::time_point started = Clock::now();
+        // Updated after every block so .jobs can report progress while the job runs.
+        std::atomic<uint64_t> rowsFetched = 0;
+        // Set by shutdown, the job stops at the next block it fetches.
+        std::atomic<bool> cancelled = false;
+
+        // Everything below is guarded by mutex.
+        mutable std::mutex mutex;
+        std::condition_variable finished;
+        State state = State::Queued;
+        Clock::time_point ended;
+        std::string error;
+        // Set while the job holds a session, so that it can be interrupted.
+        std::optional<OracleConnection> conn;
+
+        // Only touched by the job until it finishes.
+        ResultSet results;
+    };
+
+    static constexpr uint32_t kRowsPerBlock = 1000;
+
+    explicit BackgroundJobs(OracleConnectionPool& sessions);
+    BackgroundJobs(const BackgroundJobs&) = delete;
+    BackgroundJobs& operator=(const BackgroundJobs&) = delete;
+    ~BackgroundJobs();
+
+    // Starts sql in the background and returns the job's id.
+    uint32_t start(std::string sql, const TemporalFormatSettings& temporal);
+
+    // Prints one line per job with its state, rows fetched so far, elapsed time and rate.
+    void printJobs(std::ostream& out) const;
+
+    // Waits for job id to finish and removes it from the list. Throws std::runtime_error
+    // if there's no such job.
+    std::unique_ptr<Job> wait(uint32_t id);
+
+    // Interrupts every running job, cancels the queued ones and waits for them all to finish.
+    void shutdown();
+
+private:
+    struct QueuedJob {
+        Job* job = nullptr;
+        TemporalFormatSettings temporal;
+    };
+
+    // Runs job now if fewer than _maxRunning jobs are running, queues it otherwise.
+    void _admit(Job& job, const TemporalFormatSettings& temporal);
+    // Called by a finishing job to start the next queued one, if any.
+    void _startNext();
+    Task<void> _run(Job& job, TemporalFormatSettings temporal);
+
+    OracleConnectionPool& _sessions;
+    const uint32_t _maxRunning;
+    std::mutex _queueMutex;
+    // Guarded by _queueMutex.
+    uint32_t _running = 0;
+    std::deque<QueuedJob> _queued;
+    uint32_t _nextId = 1;
+    // Jobs are only added and removed by the shell's thread, but the job's own fields are
+    // read by .jobs while the job's coroutine updates them.
+    std::map<uint32_t, std::unique_ptr<Job>> _jobs;
+    // Declared last so its threads are joined before the jobs go away.
+    WorkerPool _workers{_maxRunning};
+};
+
+} // namespace sqlplusplus
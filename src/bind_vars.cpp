@@ -0,0 +1,192 @@
+#include "bind_vars.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// Unquoted bind names are case-insensitive and ODPI reports them in upper case.
+std::string normalizeName(std::string_view name) {
+    if (!name.empty() && name.front() == ':') {
+        name.remove_prefix(1);
+    }
+    if (name.empty()) {
+        throw std::runtime_error("bind variable name must not be empty");
+    }
+    std::string out(name);
+    std::transform(out.begin(), out.end(), out.begin(), [](unsigned char ch) { return std::toupper(ch); });
+    return out;
+}
+
+std::string_view trim(std::string_view str) {
+    const auto begin = str.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    const auto end = str.find_last_not_of(" \t\r\n");
+    return str.substr(begin, end - begin + 1);
+}
+
+bool isNumberType(dpiOracleTypeNum typeNum) {
+    return typeNum == DPI_ORACLE_TYPE_NUMBER || typeNum == DPI_ORACLE_TYPE_NATIVE_INT ||
+        typeNum == DPI_ORACLE_TYPE_NATIVE_DOUBLE || typeNum == DPI_ORACLE_TYPE_NATIVE_FLOAT;
+}
+
+bool isStringType(dpiOracleTypeNum typeNum) {
+    return typeNum == DPI_ORACLE_TYPE_VARCHAR || typeNum == DPI_ORACLE_TYPE_NVARCHAR ||
+        typeNum == DPI_ORACLE_TYPE_CHAR || typeNum == DPI_ORACLE_TYPE_NCHAR;
+}
+} // namespace
+
+std::vector<std::string> parseListValues(std::string_view spec) {
+    std::vector<std::string> values;
+    spec = trim(spec);
+    if (!spec.empty() && spec.front() == '@') {
+        auto path = std::string(trim(spec.substr(1)));
+        std::ifstream in(path);
+        if (!in) {
+            throw std::runtime_error(fmt::format("could not open {} for reading", path));
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            auto value = trim(line);
+            if (!value.empty()) {
+                values.emplace_back(value);
+            }
+        }
+        return values;
+    }
+
+    size_t start = 0;
+    while (start <= spec.size()) {
+        auto end = std::min(spec.size(), spec.find(',', start));
+        auto value = trim(spec.substr(start, end - start));
+        if (!value.empty()) {
+            values.emplace_back(value);
+        }
+        start = end + 1;
+    }
+    return values;
+}
+
+void BindVariables::setScalar(std::string_view name, std::string value) {
+    auto& var = _vars[normalizeName(name)];
+    var.scalar = std::move(value);
+    var.list.reset();
+    var.variable.reset();
+}
+
+size_t BindVariables::setList(OracleConnection& conn,
+                              std::string_view name,
+                              std::string_view typeName,
+                              const std::vector<std::string>& values) {
+    auto type = conn.getObjectType(typeName);
+    if (!type.isCollection()) {
+        throw std::runtime_error(fmt::format("{} is not a collection type", typeName));
+    }
+
+    const auto elementType = type.info().elementTypeInfo.oracleTypeNum;
+    const bool numeric = isNumberType(elementType);
+    if (!numeric && !isStringType(elementType)) {
+        throw std::runtime_error(fmt::format("{} must be a collection of numbers or strings", typeName));
+    }
+
+    // Elements are appended on the client, the whole collection is only sent to the
+    // server once when it's bound.
+    auto collection = type.createObject();
+    dpiData data;
+    data.isNull = 0;
+    for (const auto& value : values) {
+        char* end = nullptr;
+        errno = 0;
+        const auto intValue = numeric ? std::strtoll(value.c_str(), &end, 10) : 0;
+        if (numeric && errno == 0 && end != value.c_str() && *end == '\0') {
+            data.value.asInt64 = intValue;
+            collection.appendElement(DPI_NATIVE_TYPE_INT64, data);
+        } else {
+            data.value.asBytes.ptr = const_cast<char*>(value.data());
+            data.value.asBytes.length = static_cast<uint32_t>(value.size());
+            data.value.asBytes.encoding = nullptr;
+            collection.appendElement(DPI_NATIVE_TYPE_BYTES, data);
+        }
+    }
+
+    auto& var = _vars[normalizeName(name)];
+    var.scalar.clear();
+    var.list.emplace(ListValue{std::move(type), std::move(collection), values.size()});
+    var.variable.reset();
+    return values.size();
+}
+
+bool BindVariables::unset(std::string_view name) {
+    return _vars.erase(normalizeName(name)) != 0;
+}
+
+OracleVariable BindVariables::makeVariable(OracleConnection& conn, const Value& value) {
+    OracleConnection::VariableOpts varopts;
+    varopts.maxArraySize = 1;
+    varopts.isArray = false;
+    if (value.list) {
+        varopts.dbTypeNum = DPI_ORACLE_TYPE_OBJECT;
+        varopts.nativeTypeNum = DPI_NATIVE_TYPE_OBJECT;
+        varopts.opts = OracleConnection::VariableOpts::ObjectOpts{value.list->type.get()};
+        return conn.newArrayVariable(varopts);
+    }
+
+    varopts.dbTypeNum = DPI_ORACLE_TYPE_VARCHAR;
+    varopts.nativeTypeNum = DPI_NATIVE_TYPE_BYTES;
+    varopts.opts = OracleConnection::VariableOpts::ByteBufferOpts{
+        static_cast<uint32_t>(std::max<size_t>(1, value.scalar.size())), true};
+    return conn.newArrayVariable(varopts);
+}
+
+void BindVariables::fillVariable(const Value& value) {
+    if (value.list) {
+        value.variable->setFrom(0, value.list->collection);
+    } else {
+        value.variable->setFrom(0, value.scalar);
+    }
+}
+
+void BindVariables::bindTo(OracleConnection& conn, OracleStatement& stmt) const {
+    for (const auto& bindName : stmt.bindNames()) {
+        auto it = _vars.find(normalizeName(bindName));
+        if (it == _vars.end()) {
+            throw std::runtime_error(fmt::format("no value set for bind variable :{}, use .var to set one", bindName));
+        }
+
+        const auto& value = it->second;
+        if (!value.variable) {
+            value.variable.emplace(makeVariable(conn, value));
+        }
+        // Binds are IN OUT, so a PL/SQL block assigning to the name changes the variable.
+        fillVariable(value);
+        stmt.bindByName(bindName, *value.variable);
+    }
+}
+
+void BindVariables::print(std::ostream& out) const {
+    if (_vars.empty()) {
+        out << "No bind variables set" << std::endl;
+        return;
+    }
+    for (const auto& [name, value] : _vars) {
+        if (value.list) {
+            out << ":" << name << " = " << value.list->type.schema() << "." << value.list->type.name()
+                << " with " << value.list->size << " elements\n";
+        } else {
+            out << ":" << name << " = '" << value.scalar << "'\n";
+        }
+    }
+    out << std::flush;
+}
+
+} // namespace sqlplusplus
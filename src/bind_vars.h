@@ -0,0 +1,60 @@
+#pragma once
+
+#include "oracle_helpers.h"
+
+#include <iosfwd>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sqlplusplus {
+
+// Client-side bind variables set with .var and bound by name to every statement that
+// references them.
+class BindVariables {
+public:
+    void setScalar(std::string_view name, std::string value);
+
+    // Builds a collection of typeName (a TABLE OF NUMBER or VARCHAR2 type, such as
+    // SYS.ODCINUMBERLIST or SYS.ODCIVARCHAR2LIST) from values so that the whole list is
+    // sent as a single bind and can be used with TABLE(:name). Returns the number of elements.
+    size_t setList(OracleConnection& conn,
+                   std::string_view name,
+                   std::string_view typeName,
+                   const std::vector<std::string>& values);
+
+    bool unset(std::string_view name);
+
+    // Binds every variable referenced by stmt, throws if one of them hasn't been set.
+    void bindTo(OracleConnection& conn, OracleStatement& stmt) const;
+
+    void print(std::ostream& out) const;
+
+private:
+    struct ListValue {
+        OracleObjectType type;
+        OracleObject collection;
+        size_t size;
+    };
+
+    struct Value {
+        std::string scalar;
+        std::optional<ListValue> list;
+        // Created the first time the value is bound, then reused by every statement that
+        // binds it until the value changes. It's refilled from the value before each bind.
+        mutable std::optional<OracleVariable> variable;
+    };
+
+    static OracleVariable makeVariable(OracleConnection& conn, const Value& value);
+    static void fillVariable(const Value& value);
+
+    std::map<std::string, Value> _vars;
+};
+
+// Parses the values for a list variable, either "@path" to read one value per line from
+// a file or a comma-separated list.
+std::vector<std::string> parseListValues(std::string_view spec);
+
+} // namespace sqlplusplus
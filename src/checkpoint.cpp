@@ -0,0 +1,145 @@
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// Values may hold SQL text, so line breaks and backslashes are escaped.
+std::string escape(std::string_view value) {
+    std::string out;
+    for (auto ch : value) {
+        switch (ch) {
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        default:
+            out.push_back(ch);
+            break;
+        }
+    }
+    return out;
+}
+
+std::string unescape(std::string_view value) {
+    std::string out;
+    for (size_t idx = 0; idx < value.size(); ++idx) {
+        if (value[idx] != '\\' || idx + 1 == value.size()) {
+            out.push_back(value[idx]);
+            continue;
+        }
+        const auto next = value[++idx];
+        out.push_back(next == 'n' ? '\n' : next == 'r' ? '\r' : next);
+    }
+    return out;
+}
+} // namespace
+
+std::string Checkpoint::pathFor(const std::string& dataPath) {
+    return dataPath + ".checkpoint";
+}
+
+Checkpoint::Checkpoint(std::string path) : _path(std::move(path)) {
+    auto* file = std::fopen(_path.c_str(), "rb");
+    if (file == nullptr) {
+        if (errno == ENOENT) {
+            return;
+        }
+        throw std::runtime_error(fmt::format("could not open {}: {}", _path, std::strerror(errno)));
+    }
+
+    std::string contents;
+    char buf[4096];
+    size_t read;
+    while ((read = std::fread(buf, 1, sizeof(buf), file)) != 0) {
+        contents.append(buf, read);
+    }
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed) {
+        throw std::runtime_error(fmt::format("error reading {}", _path));
+    }
+
+    std::string_view text(contents);
+    while (!text.empty()) {
+        const auto end = std::min(text.size(), text.find('\n'));
+        const auto line = text.substr(0, end);
+        text.remove_prefix(std::min(text.size(), end + 1));
+        const auto equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            throw std::runtime_error(fmt::format("{} is not a checkpoint file", _path));
+        }
+        _values.insert_or_assign(std::string(line.substr(0, equals)), unescape(line.substr(equals + 1)));
+    }
+    _resumed = true;
+}
+
+void Checkpoint::expect(std::string_view key, std::string_view value) {
+    if (_resumed && get(key) != value) {
+        throw std::runtime_error(fmt::format(
+                "{} was written by a different run ({} doesn't match), remove it to start over", _path, key));
+    }
+    set(key, std::string(value));
+}
+
+std::string Checkpoint::get(std::string_view key) const {
+    auto it = _values.find(key);
+    return it == _values.end() ? std::string() : it->second;
+}
+
+uint64_t Checkpoint::getNumber(std::string_view key) const {
+    return std::strtoull(get(key).c_str(), nullptr, 10);
+}
+
+void Checkpoint::set(std::string_view key, std::string value) {
+    _values.insert_or_assign(std::string(key), std::move(value));
+}
+
+void Checkpoint::set(std::string_view key, uint64_t value) {
+    set(key, std::to_string(value));
+}
+
+void Checkpoint::save() {
+    std::string contents;
+    for (const auto& [key, value] : _values) {
+        fmt::format_to(std::back_inserter(contents), "{}={}\n", key, escape(value));
+    }
+
+    const auto tempPath = _path + ".tmp";
+    auto* file = std::fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error(fmt::format("could not open {} for writing: {}", tempPath, std::strerror(errno)));
+    }
+    const bool written = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size() &&
+        std::fflush(file) == 0 && ::fsync(fileno(file)) == 0;
+    const auto err = errno;
+    if (std::fclose(file) != 0 || !written) {
+        throw std::runtime_error(fmt::format("error writing {}: {}", tempPath, std::strerror(err)));
+    }
+    if (std::rename(tempPath.c_str(), _path.c_str()) != 0) {
+        throw std::runtime_error(fmt::format("could not replace {}: {}", _path, std::strerror(errno)));
+    }
+}
+
+void Checkpoint::remove() {
+    if (std::remove(_path.c_str()) != 0 && errno != ENOENT) {
+        throw std::runtime_error(fmt::format("could not remove {}: {}", _path, std::strerror(errno)));
+    }
+}
+
+} // namespace sqlplusplus
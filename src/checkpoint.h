@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+// The progress of a long export or load, kept as key=value lines in a small file next to
+// its data file so that rerunning the same command carries on after the last completed
+// chunk instead of starting over.
+class Checkpoint {
+public:
+    // Where the checkpoint for an export or load of dataPath is kept.
+    static std::string pathFor(const std::string& dataPath);
+
+    // Reads the checkpoint at path if there is one. Throws std::runtime_error if it
+    // exists but can't be read.
+    explicit Checkpoint(std::string path);
+
+    // Whether an earlier run left this checkpoint behind.
+    bool resumed() const noexcept {
+        return _resumed;
+    }
+
+    const std::string& path() const noexcept {
+        return _path;
+    }
+
+    // Records a value that identifies the operation, such as the table loaded. Throws
+    // std::runtime_error if the checkpoint being resumed has a different value, as it
+    // then belongs to some other run.
+    void expect(std::string_view key, std::string_view value);
+
+    // Empty or 0 when the key isn't set.
+    std::string get(std::string_view key) const;
+    uint64_t getNumber(std::string_view key) const;
+
+    void set(std::string_view key, std::string value);
+    void set(std::string_view key, uint64_t value);
+
+    // Writes the values to a temporary file, syncs it and renames it over the checkpoint,
+    // so a crash leaves either the previous or the new checkpoint complete.
+    void save();
+    // Deletes the checkpoint once the operation has finished.
+    void remove();
+
+private:
+    std::string _path;
+    std::map<std::string, std::string, std::less<>> _values;
+    bool _resumed = false;
+};
+
+} // namespace sqlplusplus
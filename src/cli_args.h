@@ -1,5 +1,6 @@
-#include <vector>
+#include <stdexcept>
 #include <string_view>
+#include <vector>
 
 namespace sqlplusplus {
 
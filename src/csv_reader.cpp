@@ -0,0 +1,258 @@
+#include "csv_reader.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// Each thread parses about this much of a window. Offsets within a chunk must fit in 31 bits.
+constexpr size_t kChunkSize = 16 << 20;
+
+// Runs fn(idx) for every idx below count, spread over up to numThreads threads including
+// the calling one.
+template <typename Fn>
+void parallelFor(size_t count, size_t numThreads, Fn fn) {
+    std::atomic<size_t> nextIdx{0};
+    auto worker = [&] {
+        for (auto idx = nextIdx++; idx < count; idx = nextIdx++) {
+            fn(idx);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t idx = 1; idx < std::min(numThreads, count); ++idx) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+} // namespace
+
+uint32_t CsvBatch::maxSize(size_t column, size_t firstRow, size_t endRow) const noexcept {
+    uint32_t out = 0;
+    const auto& fields = _columns[column];
+    for (auto row = firstRow; row < endRow; ++row) {
+        out = std::max(out, fields[row].size & ~kOwnedBit);
+    }
+    return out;
+}
+
+CsvReader::CsvReader(const std::string& path, CsvOptions opts)
+    : _file(path),
+      _text(_file.contents()),
+      _opts(opts),
+      _numThreads(std::max(1u, std::thread::hardware_concurrency()))
+{
+    _file.adviseSequential();
+    if (_text.substr(0, 3) == "\xEF\xBB\xBF") {
+        _pos = 3;
+    }
+    while (_pos < _text.size() && (_text[_pos] == '\n' || _text[_pos] == '\r')) {
+        _line += _text[_pos++] == '\n';
+    }
+    if (_pos == _text.size()) {
+        throw std::runtime_error(fmt::format("{} has no rows", path));
+    }
+
+    // With no columns known yet, the first row sets how many there are.
+    const auto firstRowEnd = _rowEnd(_pos, false);
+    CsvBatch first;
+    first._chunk = _text.substr(_pos, firstRowEnd - _pos);
+    std::string error;
+    _parseChunk(first, error);
+    if (!error.empty()) {
+        throw std::runtime_error(fmt::format("line {}: {}", _line, error));
+    }
+
+    for (size_t column = 0; column < first._columns.size(); ++column) {
+        if (_opts.header) {
+            _columnNames.emplace_back(first.value(column, 0));
+        } else {
+            _columnNames.push_back(fmt::format("COLUMN{}", column + 1));
+        }
+    }
+    if (_opts.header) {
+        _pos = firstRowEnd;
+        _line += first._numLines;
+    }
+}
+
+std::optional<std::vector<CsvBatch>> CsvReader::next() {
+    if (_pos >= _text.size()) {
+        return std::nullopt;
+    }
+
+    // Split the window evenly, then move each split point to the end of the row it lands
+    // in. Whether a split point is inside a quoted value follows from the number of
+    // quotes before it, which the threads count for their part of the window in parallel.
+    const auto windowEnd = std::min(_text.size(), _pos + _numThreads * kChunkSize);
+    const auto rangeSize = (windowEnd - _pos + _numThreads - 1) / _numThreads;
+    std::vector<size_t> quotes(_numThreads);
+    parallelFor(_numThreads, _numThreads, [&](size_t idx) {
+        const auto begin = std::min(windowEnd, _pos + idx * rangeSize);
+        const auto end = std::min(windowEnd, begin + rangeSize);
+        quotes[idx] = countChar(_text.substr(begin, end - begin), '"');
+    });
+
+    std::vector<size_t> bounds = {_pos};
+    bool inQuotes = false;
+    for (size_t idx = 1; idx <= _numThreads; ++idx) {
+        inQuotes ^= (quotes[idx - 1] & 1) != 0;
+        const auto split = std::min(windowEnd, _pos + idx * rangeSize);
+        const auto bound = split == _text.size() ? split : _rowEnd(split, inQuotes);
+        bounds.push_back(std::max(bound, bounds.back()));
+    }
+
+    std::vector<CsvBatch> batches(_numThreads);
+    std::vector<std::string> errors(_numThreads);
+    parallelFor(_numThreads, _numThreads, [&](size_t idx) {
+        batches[idx]._chunk = _text.substr(bounds[idx], bounds[idx + 1] - bounds[idx]);
+        _parseChunk(batches[idx], errors[idx]);
+    });
+
+    std::vector<CsvBatch> out;
+    for (size_t idx = 0; idx < _numThreads; ++idx) {
+        auto& batch = batches[idx];
+        batch._firstLine = _line;
+        batch._fileOffset = bounds[idx];
+        if (!errors[idx].empty()) {
+            throw std::runtime_error(fmt::format("line {}: {}", _line + batch._numLines, errors[idx]));
+        }
+        _line += batch._numLines;
+        if (batch.numRows() != 0) {
+            out.push_back(std::move(batch));
+        }
+    }
+    _pos = bounds.back();
+    return out;
+}
+
+void CsvReader::resumeAt(CsvBatch::Position position) {
+    if (position.offset < _pos || position.offset > _text.size() || position.line < _line) {
+        throw std::runtime_error(fmt::format("can't resume reading at offset {}", position.offset));
+    }
+    _pos = static_cast<size_t>(position.offset);
+    _line = position.line;
+}
+
+size_t CsvReader::_rowEnd(size_t pos, bool inQuotes) const noexcept {
+    for (;;) {
+        pos = findFirstOf(_text, '"', '\n', '\n', pos);
+        if (pos == std::string_view::npos) {
+            return _text.size();
+        }
+        if (_text[pos] == '"') {
+            inQuotes = !inQuotes;
+        } else if (!inQuotes) {
+            return pos + 1;
+        }
+        ++pos;
+    }
+}
+
+// On error, error is set and batch._numLines is the line of the chunk the error is on.
+void CsvReader::_parseChunk(CsvBatch& batch, std::string& error) const {
+    const auto text = batch._chunk;
+    const auto delimiter = _opts.delimiter;
+    const auto expected = numColumns();
+    batch._columns.resize(expected);
+
+    size_t pos = 0;
+    uint32_t line = 0;
+    auto fail = [&](std::string message) {
+        error = std::move(message);
+        batch._numLines = line;
+    };
+
+    while (pos < text.size()) {
+        if (text[pos] == '\n' || text.substr(pos, 2) == "\r\n") {
+            pos += text[pos] == '\r' ? 2 : 1;
+            ++line;
+            continue;
+        }
+
+        const auto rowLine = line;
+        const auto rowOffset = pos;
+        size_t column = 0;
+        for (;;) {
+            CsvBatch::Field field;
+            if (pos < text.size() && text[pos] == '"') {
+                const auto start = ++pos;
+                const auto unescapedStart = batch._unescaped.size();
+                bool owned = false;
+                size_t close;
+                for (;;) {
+                    close = text.find('"', pos);
+                    if (close == std::string_view::npos) {
+                        return fail("quoted value has no closing quote");
+                    }
+                    if (close + 1 < text.size() && text[close + 1] == '"') {
+                        batch._unescaped.append(text.substr(pos, close + 1 - pos));
+                        owned = true;
+                        pos = close + 2;
+                        continue;
+                    }
+                    break;
+                }
+
+                line += static_cast<uint32_t>(countChar(text.substr(start, close - start), '\n'));
+                if (owned) {
+                    batch._unescaped.append(text.substr(pos, close - pos));
+                    const auto size = batch._unescaped.size() - unescapedStart;
+                    field = {static_cast<uint32_t>(unescapedStart), static_cast<uint32_t>(size) | CsvBatch::kOwnedBit};
+                } else {
+                    field = {static_cast<uint32_t>(start), static_cast<uint32_t>(close - start)};
+                }
+                pos = close + 1;
+                if (pos < text.size() && text[pos] != delimiter && text[pos] != '\n' && text[pos] != '\r') {
+                    return fail("unexpected character after quoted value");
+                }
+            } else {
+                const auto end = std::min(text.size(), findFirstOf(text, delimiter, '\n', '\r', pos));
+                field = {static_cast<uint32_t>(pos), static_cast<uint32_t>(end - pos)};
+                pos = end;
+            }
+
+            if (expected == 0 && column == batch._columns.size()) {
+                batch._columns.emplace_back();
+            } else if (column >= batch._columns.size()) {
+                return fail(fmt::format("expected {} fields, found more", expected));
+            }
+            batch._columns[column++].push_back(field);
+
+            if (pos < text.size() && text[pos] == delimiter) {
+                ++pos;
+                continue;
+            }
+            break;
+        }
+
+        if (column != batch._columns.size()) {
+            return fail(fmt::format("expected {} fields, found {}", batch._columns.size(), column));
+        }
+        batch._lines.push_back(rowLine);
+        batch._offsets.push_back(static_cast<uint32_t>(rowOffset));
+
+        if (text.substr(pos, 2) == "\r\n") {
+            pos += 2;
+            ++line;
+        } else if (pos < text.size() && text[pos] == '\n') {
+            ++pos;
+            ++line;
+        } else if (pos < text.size()) {
+            // A bare carriage return.
+            ++pos;
+        }
+    }
+    batch._numLines = line;
+}
+
+} // namespace sqlplusplus
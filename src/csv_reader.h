@@ -0,0 +1,129 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sqlplusplus {
+
+struct CsvOptions {
+    char delimiter = ',';
+    // Whether the first line holds the column names.
+    bool header = true;
+};
+
+// The rows parsed from one chunk of a CSV file, stored by column so a column's values can
+// be copied into a bind variable in one pass. Values point into the mapped file, except
+// quoted values with doubled quotes which are unescaped into the batch.
+class CsvBatch {
+public:
+    size_t numRows() const noexcept {
+        return _lines.size();
+    }
+
+    std::string_view value(size_t column, size_t row) const noexcept {
+        const auto& field = _columns[column][row];
+        const auto* base = (field.size & kOwnedBit) != 0 ? _unescaped.data() : _chunk.data();
+        return std::string_view(base + field.offset, field.size & ~kOwnedBit);
+    }
+
+    // Empty fields are loaded as NULL, as Oracle doesn't distinguish them.
+    bool isNull(size_t column, size_t row) const noexcept {
+        return (_columns[column][row].size & ~kOwnedBit) == 0;
+    }
+
+    // The line of the file the row starts on, counting from 1.
+    uint64_t line(size_t row) const noexcept {
+        return _firstLine + _lines[row];
+    }
+
+    // The longest value in the given rows of column.
+    uint32_t maxSize(size_t column, size_t firstRow, size_t endRow) const noexcept;
+
+    struct Position {
+        uint64_t offset;
+        uint64_t line;
+    };
+
+    // Where in the file the row starts. For row == numRows() this is the end of the chunk,
+    // where the rows of the next batch start.
+    Position position(size_t row) const noexcept {
+        if (row == numRows()) {
+            return {_fileOffset + _chunk.size(), _firstLine + _numLines};
+        }
+        return {_fileOffset + _offsets[row], line(row)};
+    }
+
+private:
+    friend class CsvReader;
+
+    static constexpr uint32_t kOwnedBit = 1u << 31;
+
+    // Offsets are relative to the start of the chunk, or to _unescaped for owned values.
+    struct Field {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    std::string_view _chunk;
+    std::string _unescaped;
+    std::vector<std::vector<Field>> _columns;
+    // Line and offset of each row relative to the start of the chunk.
+    std::vector<uint32_t> _lines;
+    std::vector<uint32_t> _offsets;
+    uint64_t _firstLine = 1;
+    uint64_t _fileOffset = 0;
+    // Newlines in the chunk, including those in quoted values.
+    uint32_t _numLines = 0;
+};
+
+// Reads a memory-mapped CSV file a window at a time. Each window is split into one chunk
+// per thread at row boundaries and the chunks are parsed in parallel. Finding row
+// boundaries only takes counting quotes: a newline ends a row when an even number of
+// quotes precede it, so quotes may not appear inside unquoted values.
+class CsvReader {
+public:
+    // Throws std::runtime_error if the file can't be read or has no rows.
+    CsvReader(const std::string& path, CsvOptions opts);
+
+    // The names from the header line, or COLUMN1..N without one.
+    const std::vector<std::string>& columnNames() const noexcept {
+        return _columnNames;
+    }
+
+    size_t numColumns() const noexcept {
+        return _columnNames.size();
+    }
+
+    size_t fileSize() const noexcept {
+        return _file.size();
+    }
+
+    // Parses the next window of the file into one batch per chunk, in file order. Returns
+    // nullopt at the end of the file. Throws std::runtime_error, with the line number, for
+    // a row with the wrong number of fields or a malformed quoted value.
+    std::optional<std::vector<CsvBatch>> next();
+
+    // Carries on reading from a position returned by CsvBatch::position, which must be
+    // the start of a row past the header.
+    void resumeAt(CsvBatch::Position position);
+
+private:
+    size_t _rowEnd(size_t pos, bool inQuotes) const noexcept;
+    void _parseChunk(CsvBatch& batch, std::string& error) const;
+
+    MappedFile _file;
+    std::string_view _text;
+    CsvOptions _opts;
+    std::vector<std::string> _columnNames;
+    size_t _numThreads;
+    size_t _pos = 0;
+    uint64_t _line = 1;
+};
+
+} // namespace sqlplusplus
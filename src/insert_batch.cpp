@@ -0,0 +1,344 @@
+#include "insert_batch.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// Longest string literal SQL accepts, longer values couldn't have come from a literal.
+constexpr size_t kMaxTextSize = 4000;
+
+bool isSpace(char ch) {
+    return std::isspace(static_cast<unsigned char>(ch));
+}
+
+bool isDigit(char ch) {
+    return std::isdigit(static_cast<unsigned char>(ch));
+}
+
+bool isIdentifierChar(char ch) {
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '$' || ch == '#';
+}
+
+class InsertParser {
+public:
+    explicit InsertParser(std::string_view sql) : _sql(sql) {}
+
+    std::optional<ParsedInsert> parse() {
+        if (!_keyword("insert") || !_keyword("into")) {
+            return std::nullopt;
+        }
+
+        ParsedInsert out;
+        _skipSpaces();
+        const auto targetStart = _pos;
+        if (!_tableName()) {
+            return std::nullopt;
+        }
+        _skipSpaces();
+        if (_peek() == '(' && !_columnList()) {
+            return std::nullopt;
+        }
+        out.target = _sql.substr(targetStart, _pos - targetStart);
+        out.target = out.target.substr(0, out.target.find_last_not_of(" \t\r\n") + 1);
+
+        if (!_keyword("values") || !_expect('(')) {
+            return std::nullopt;
+        }
+        for (;;) {
+            auto literal = _literal();
+            if (!literal) {
+                return std::nullopt;
+            }
+            out.values.push_back(*literal);
+            if (_expect(')')) {
+                break;
+            }
+            if (!_expect(',')) {
+                return std::nullopt;
+            }
+        }
+
+        _skipSpaces();
+        if (_pos != _sql.size()) {
+            return std::nullopt;
+        }
+        return out;
+    }
+
+private:
+    char _peek() const {
+        return _pos < _sql.size() ? _sql[_pos] : '\0';
+    }
+
+    void _skipSpaces() {
+        while (_pos < _sql.size() && isSpace(_sql[_pos])) {
+            ++_pos;
+        }
+    }
+
+    bool _expect(char ch) {
+        _skipSpaces();
+        if (_peek() != ch) {
+            return false;
+        }
+        ++_pos;
+        return true;
+    }
+
+    bool _keyword(std::string_view word) {
+        _skipSpaces();
+        const auto end = _pos + word.size();
+        if (end > _sql.size() || (end < _sql.size() && isIdentifierChar(_sql[end]))) {
+            return false;
+        }
+        for (size_t idx = 0; idx < word.size(); ++idx) {
+            if (std::tolower(static_cast<unsigned char>(_sql[_pos + idx])) != word[idx]) {
+                return false;
+            }
+        }
+        _pos = end;
+        return true;
+    }
+
+    // [schema.]table, either part may be quoted. Database links aren't handled.
+    bool _tableName() {
+        for (;;) {
+            if (_peek() == '"') {
+                auto close = _sql.find('"', _pos + 1);
+                if (close == std::string_view::npos) {
+                    return false;
+                }
+                _pos = close + 1;
+            } else {
+                const auto start = _pos;
+                while (_pos < _sql.size() && isIdentifierChar(_sql[_pos])) {
+                    ++_pos;
+                }
+                if (_pos == start) {
+                    return false;
+                }
+            }
+            if (_peek() != '.') {
+                return _peek() != '@';
+            }
+            ++_pos;
+        }
+    }
+
+    bool _columnList() {
+        ++_pos;
+        while (_pos < _sql.size()) {
+            const auto ch = _sql[_pos++];
+            if (ch == ')') {
+                return true;
+            }
+            if (ch == '"') {
+                auto close = _sql.find('"', _pos);
+                if (close == std::string_view::npos) {
+                    return false;
+                }
+                _pos = close + 1;
+            } else if (ch == '(' || ch == '\'') {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    std::optional<InsertLiteral> _literal() {
+        _skipSpaces();
+        InsertLiteral out;
+        auto ch = _peek();
+        if ((ch == 'n' || ch == 'N') && _pos + 1 < _sql.size() && _sql[_pos + 1] == '\'') {
+            ++_pos;
+            ch = '\'';
+        }
+
+        if (ch == '\'') {
+            const auto start = ++_pos;
+            for (;;) {
+                auto close = _sql.find('\'', _pos);
+                if (close == std::string_view::npos) {
+                    return std::nullopt;
+                }
+                _pos = close + 1;
+                if (_peek() != '\'') {
+                    break;
+                }
+                ++_pos;
+            }
+            out.kind = InsertLiteral::Kind::Text;
+            out.text = _sql.substr(start, _pos - 1 - start);
+            if (out.text.size() > kMaxTextSize) {
+                return std::nullopt;
+            }
+            return out;
+        }
+
+        if (isDigit(ch) || ch == '.' || ch == '-' || ch == '+') {
+            const auto start = _pos;
+            if (ch == '-' || ch == '+') {
+                ++_pos;
+            }
+            size_t digits = 0;
+            for (; isDigit(_peek()); ++_pos, ++digits);
+            if (_peek() == '.') {
+                for (++_pos; isDigit(_peek()); ++_pos, ++digits);
+            }
+            if (digits == 0) {
+                return std::nullopt;
+            }
+            if (_peek() == 'e' || _peek() == 'E') {
+                ++_pos;
+                if (_peek() == '-' || _peek() == '+') {
+                    ++_pos;
+                }
+                if (!isDigit(_peek())) {
+                    return std::nullopt;
+                }
+                for (; isDigit(_peek()); ++_pos);
+            }
+            // Anything else glued on (e.g. 1.5f or 3d) isn't a plain number.
+            if (isIdentifierChar(_peek())) {
+                return std::nullopt;
+            }
+            out.kind = InsertLiteral::Kind::Number;
+            out.text = _sql.substr(start, _pos - start);
+            return out;
+        }
+
+        if (_keyword("null")) {
+            return out;
+        }
+        return std::nullopt;
+    }
+
+    std::string_view _sql;
+    size_t _pos = 0;
+};
+
+// Writes a number literal in the form ODPI's text to NUMBER conversion accepts.
+void appendNumber(std::string& out, std::string_view text) {
+    if (text.front() == '+') {
+        text.remove_prefix(1);
+    } else if (text.front() == '-') {
+        out.push_back('-');
+        text.remove_prefix(1);
+    }
+    if (text.front() == '.') {
+        out.push_back('0');
+    }
+    out.append(text);
+}
+
+void appendUnquoted(std::string& out, std::string_view text) {
+    for (size_t pos = 0; pos < text.size();) {
+        auto quote = std::min(text.size(), text.find('\'', pos));
+        out.append(text.substr(pos, quote - pos));
+        if (quote < text.size()) {
+            out.push_back('\'');
+        }
+        // Skip both quotes of a doubled quote.
+        pos = quote + 2;
+    }
+}
+} // namespace
+
+std::optional<ParsedInsert> parseInsert(std::string_view sql) {
+    return InsertParser(sql).parse();
+}
+
+bool InsertBatch::accepts(const ParsedInsert& insert) const {
+    if (empty()) {
+        return true;
+    }
+    if (insert.target != _target || insert.values.size() != _columns.size()) {
+        return false;
+    }
+    for (size_t idx = 0; idx < _columns.size(); ++idx) {
+        const auto kind = insert.values[idx].kind;
+        const auto columnKind = _columns[idx].kind;
+        if (kind != InsertLiteral::Kind::Null && columnKind != InsertLiteral::Kind::Null && kind != columnKind) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void InsertBatch::add(const ParsedInsert& insert, uint32_t line) {
+    if (empty()) {
+        _target = std::string(insert.target);
+        _columns.assign(insert.values.size(), Column{});
+    }
+
+    for (size_t idx = 0; idx < _columns.size(); ++idx) {
+        const auto& value = insert.values[idx];
+        auto& col = _columns[idx];
+        col.nulls.push_back(value.kind == InsertLiteral::Kind::Null);
+        if (value.kind == InsertLiteral::Kind::Number) {
+            appendNumber(col.values, value.text);
+        } else if (value.kind == InsertLiteral::Kind::Text) {
+            appendUnquoted(col.values, value.text);
+        }
+        if (value.kind != InsertLiteral::Kind::Null) {
+            col.kind = value.kind;
+        }
+        col.offsets.push_back(static_cast<uint32_t>(col.values.size()));
+        col.maxSize = std::max(col.maxSize, col.offsets.back() - col.offsets[col.offsets.size() - 2]);
+    }
+    _lines.push_back(line);
+}
+
+InsertBatch::Result InsertBatch::flush(OracleConnection& conn) {
+    Result result;
+    if (empty()) {
+        return result;
+    }
+
+    std::string sql = fmt::format("insert into {} values (", _target);
+    for (size_t idx = 0; idx < _columns.size(); ++idx) {
+        fmt::format_to(std::back_inserter(sql), "{}:{}", idx == 0 ? "" : ", ", idx + 1);
+    }
+    sql.push_back(')');
+
+    const auto numRows = static_cast<uint32_t>(_lines.size());
+    auto stmt = conn.prepareStatement(sql);
+    for (size_t idx = 0; idx < _columns.size(); ++idx) {
+        const auto& col = _columns[idx];
+        OracleConnection::VariableOpts opts;
+        opts.dbTypeNum = col.kind == InsertLiteral::Kind::Number ? DPI_ORACLE_TYPE_NUMBER : DPI_ORACLE_TYPE_VARCHAR;
+        opts.maxArraySize = numRows;
+        opts.opts = OracleConnection::VariableOpts::ByteBufferOpts{std::max<uint32_t>(col.maxSize, 1), true};
+
+        // Elements start out null, so only the values need setting.
+        auto var = conn.newArrayVariable(opts);
+        const std::string_view values(col.values);
+        for (uint32_t row = 0; row < numRows; ++row) {
+            if (!col.nulls[row]) {
+                var.setFrom(row, values.substr(col.offsets[row], col.offsets[row + 1] - col.offsets[row]));
+            }
+        }
+        stmt.bindByPos(static_cast<uint32_t>(idx + 1), var);
+    }
+
+    stmt.executeMany(numRows, true);
+    result.rowsInserted = stmt.rowCount();
+    for (auto& error : stmt.batchErrors()) {
+        const auto line = _lines.at(error.info().offset);
+        result.errors.emplace_back(line, std::move(error));
+    }
+    clear();
+    return result;
+}
+
+void InsertBatch::clear() {
+    _target.clear();
+    _columns.clear();
+    _lines.clear();
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "oracle_helpers.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sqlplusplus {
+
+struct InsertLiteral {
+    enum class Kind { Null, Number, Text };
+
+    Kind kind = Kind::Null;
+    // For text, what's between the quotes with any doubled quotes still doubled.
+    std::string_view text;
+};
+
+// A single-row INSERT whose values are all literals.
+struct ParsedInsert {
+    // The table and optional column list, as written.
+    std::string_view target;
+    std::vector<InsertLiteral> values;
+};
+
+// Recognizes INSERT INTO <table> [(<columns>)] VALUES (<literals>) where every value is a
+// string, number or NULL. Returns nullopt for any other statement.
+std::optional<ParsedInsert> parseInsert(std::string_view sql);
+
+// Consecutive single-row inserts into the same target, sent as one array DML so that a
+// script of generated INSERTs doesn't take a round trip per row. Values are stored by
+// column, the way they're bound.
+class InsertBatch {
+public:
+    struct Result {
+        uint64_t rowsInserted = 0;
+        // The script line of each row that failed, with its error.
+        std::vector<std::pair<uint32_t, OracleException>> errors;
+    };
+
+    // Whether insert can be added: it targets the same table and columns as the rows
+    // already in the batch, and no column mixes numbers with text.
+    bool accepts(const ParsedInsert& insert) const;
+    void add(const ParsedInsert& insert, uint32_t line);
+
+    size_t size() const noexcept {
+        return _lines.size();
+    }
+
+    bool empty() const noexcept {
+        return _lines.empty();
+    }
+
+    // Inserts every row with executeMany. Rows that fail don't stop the others, they're
+    // returned in the result. Throws if the statement can't be run at all.
+    Result flush(OracleConnection& conn);
+    void clear();
+
+private:
+    struct Column {
+        InsertLiteral::Kind kind = InsertLiteral::Kind::Null;
+        std::string values;
+        std::vector<uint32_t> offsets = {0};
+        std::vector<uint8_t> nulls;
+        uint32_t maxSize = 0;
+    };
+
+    std::string _target;
+    std::vector<Column> _columns;
+    std::vector<uint32_t> _lines;
+};
+
+} // namespace sqlplusplus
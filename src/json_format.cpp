@@ -0,0 +1,106 @@
+#include "json_format.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// OSON values don't carry a precision, so DATEs show whole seconds and TIMESTAMPs show
+// microseconds unless .set fsprecision says otherwise.
+TemporalFormat nodeFormat(const dpiJsonNode& node, const TemporalFormatSettings& temporal) {
+    TemporalFormat format;
+    if (temporal.fractionalDigits >= 0) {
+        format.fractionalDigits = static_cast<uint8_t>(std::min<int>(temporal.fractionalDigits, kMaxFractionalDigits));
+    } else if (node.oracleTypeNum == DPI_ORACLE_TYPE_DATE) {
+        format.fractionalDigits = 0;
+    }
+    format.showTimezone = temporal.timezone == TemporalFormatSettings::Timezone::Always;
+    return format;
+}
+
+void appendQuoted(std::string& out, const char* value, size_t length) {
+    out.push_back('"');
+    out.append(value, length);
+    out.push_back('"');
+}
+} // namespace
+
+void appendJson(std::string& out, const dpiJsonNode& node, const TemporalFormatSettings& temporal) {
+    const auto* value = node.value;
+    switch (node.nativeTypeNum) {
+    case DPI_NATIVE_TYPE_NULL:
+        out.append("null");
+        break;
+    case DPI_NATIVE_TYPE_JSON_OBJECT: {
+        const auto& obj = value->asJsonObject;
+        out.push_back('{');
+        for (uint32_t idx = 0; idx < obj.numFields; ++idx) {
+            if (idx != 0) {
+                out.push_back(',');
+            }
+            appendJsonString(out, std::string_view(obj.fieldNames[idx], obj.fieldNameLengths[idx]));
+            out.push_back(':');
+            appendJson(out, obj.fields[idx], temporal);
+        }
+        out.push_back('}');
+        break;
+    }
+    case DPI_NATIVE_TYPE_JSON_ARRAY: {
+        const auto& arr = value->asJsonArray;
+        out.push_back('[');
+        for (uint32_t idx = 0; idx < arr.numElements; ++idx) {
+            if (idx != 0) {
+                out.push_back(',');
+            }
+            appendJson(out, arr.elements[idx], temporal);
+        }
+        out.push_back(']');
+        break;
+    }
+    case DPI_NATIVE_TYPE_BYTES: {
+        auto bytes = std::string_view(value->asBytes.ptr, value->asBytes.length);
+        if (node.oracleTypeNum == DPI_ORACLE_TYPE_NUMBER) {
+            out.append(bytes);
+        } else if (node.oracleTypeNum == DPI_ORACLE_TYPE_RAW) {
+            out.push_back('"');
+            appendHex(out, bytes);
+            out.push_back('"');
+        } else {
+            appendJsonString(out, bytes);
+        }
+        break;
+    }
+    case DPI_NATIVE_TYPE_DOUBLE:
+        appendJsonNumber(out, value->asDouble);
+        break;
+    case DPI_NATIVE_TYPE_FLOAT:
+        appendJsonNumber(out, value->asFloat);
+        break;
+    case DPI_NATIVE_TYPE_BOOLEAN:
+        out.append(value->asBoolean ? "true" : "false");
+        break;
+    case DPI_NATIVE_TYPE_TIMESTAMP: {
+        char buf[kMaxTimestampLength];
+        appendQuoted(out, buf, formatTimestamp(buf, value->asTimestamp, nodeFormat(node, temporal)));
+        break;
+    }
+    case DPI_NATIVE_TYPE_INTERVAL_DS: {
+        char buf[kMaxIntervalLength];
+        appendQuoted(out, buf, formatIntervalDS(buf, value->asIntervalDS, nodeFormat(node, temporal).fractionalDigits));
+        break;
+    }
+    case DPI_NATIVE_TYPE_INTERVAL_YM: {
+        char buf[kMaxIntervalLength];
+        appendQuoted(out, buf, formatIntervalYM(buf, value->asIntervalYM));
+        break;
+    }
+    default:
+        out.append("\"unsupported type\"");
+    }
+}
+
+} // namespace sqlplusplus
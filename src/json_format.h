@@ -0,0 +1,18 @@
+#pragma once
+
+#include "dpi.h"
+#include "value_format.h"
+
+#include <string>
+
+namespace sqlplusplus {
+
+// Options to decode JSON column values with before passing them to appendJson. Numbers
+// are decoded as their decimal text so they're copied with full precision.
+constexpr uint32_t kJsonDecodeOptions = DPI_JSON_OPT_NUMBER_AS_STRING;
+
+// Appends the decoded (OSON) tree as compact JSON text, e.g. {"a":[1,"x",null]}. Dates,
+// timestamps and intervals are written as ISO-8601 strings and RAW values as hex strings.
+void appendJson(std::string& out, const dpiJsonNode& node, const TemporalFormatSettings& temporal);
+
+} // namespace sqlplusplus
@@ -0,0 +1,190 @@
+#include "lob_upload.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// Every write is a round trip, so each one sends as many whole chunks as fit in this.
+constexpr uint64_t kTargetWriteSize = 4 << 20;
+// Set before the row is locked, a failed upload rolls back to it.
+constexpr auto kUploadSavepoint = "sqlplusplus_putlob";
+
+bool isLobType(dpiOracleTypeNum oracleType) {
+    return oracleType == DPI_ORACLE_TYPE_BLOB || oracleType == DPI_ORACLE_TYPE_CLOB ||
+        oracleType == DPI_ORACLE_TYPE_NCLOB;
+}
+
+bool isContinuationByte(char ch) {
+    return (static_cast<unsigned char>(ch) & 0xc0) == 0x80;
+}
+
+// Writes to a CLOB must not split a UTF-8 sequence. Returns the length of the longest
+// prefix of data no longer than maxBytes that ends on a boundary.
+size_t utf8PrefixLength(std::string_view data, size_t maxBytes) {
+    if (maxBytes >= data.size()) {
+        return data.size();
+    }
+    auto end = maxBytes;
+    while (end > 0 && isContinuationByte(data[end])) {
+        --end;
+    }
+    // Not valid UTF-8, let the server complain about it.
+    return end == 0 ? maxBytes : end;
+}
+
+// CLOB and NCLOB offsets are in UCS-2 code units, so a character outside the Basic
+// Multilingual Plane (a 4-byte UTF-8 sequence) counts as two.
+uint64_t countUtf16Units(std::string_view data) {
+    uint64_t units = 0;
+    for (auto ch : data) {
+        units += !isContinuationByte(ch) + (static_cast<unsigned char>(ch) >= 0xf0);
+    }
+    return units;
+}
+
+// Rolls back the row lock and any empty_blob()/empty_clob() update unless the upload
+// gets as far as committing. Only the upload's own changes are undone, and when the
+// session already had a transaction open the upload becomes part of it instead of
+// committing it.
+class UploadTransaction {
+public:
+    explicit UploadTransaction(OracleConnection& conn) :
+        _conn(conn),
+        _joined(conn.transactionInProgress())
+    {
+        _conn.prepareStatement(fmt::format("savepoint {}", kUploadSavepoint)).execute();
+    }
+
+    UploadTransaction(const UploadTransaction&) = delete;
+    UploadTransaction& operator=(const UploadTransaction&) = delete;
+
+    ~UploadTransaction() {
+        if (!_committed) {
+            try {
+                _conn.prepareStatement(fmt::format("rollback to savepoint {}", kUploadSavepoint)).execute();
+            } catch (const OracleException&) {
+                // The original error is more useful than this one.
+            }
+        }
+    }
+
+    // Returns whether the upload was committed, rather than left in the open transaction.
+    bool commit() {
+        if (!_joined) {
+            _conn.commit();
+        }
+        _committed = true;
+        return !_joined;
+    }
+
+private:
+    OracleConnection& _conn;
+    const bool _joined;
+    bool _committed = false;
+};
+
+// Keeps the LOB open while it's written and closes it however the writes end.
+class OpenLobResource {
+public:
+    explicit OpenLobResource(OracleLob& lob) : _lob(lob) {
+        _lob.openResource();
+    }
+
+    OpenLobResource(const OpenLobResource&) = delete;
+    OpenLobResource& operator=(const OpenLobResource&) = delete;
+
+    ~OpenLobResource() {
+        if (!_closed) {
+            try {
+                _lob.closeResource();
+            } catch (const OracleException&) {
+                // A write already failed, which is the error worth reporting.
+            }
+        }
+    }
+
+    void close() {
+        _closed = true;
+        _lob.closeResource();
+    }
+
+private:
+    OracleLob& _lob;
+    bool _closed = false;
+};
+} // namespace
+
+LobUploadStats uploadLob(OracleConnection& conn,
+                         std::string_view table,
+                         std::string_view column,
+                         std::string_view where,
+                         const std::string& path) {
+    MappedFile file(path);
+    file.adviseSequential();
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto selectSql = fmt::format("select {} from {} where {} for update", column, table, where);
+    auto selectLocator = [&] {
+        auto stmt = conn.prepareStatement(selectSql);
+        // Both rows land in the same fetch, so checking for a second one doesn't
+        // overwrite the first row's locator.
+        stmt.setFetchArraySize(2);
+        stmt.execute();
+        if (!stmt.fetch()) {
+            throw std::runtime_error(fmt::format("no rows in {} matched {}", table, where));
+        }
+        if (!isLobType(stmt.getColumnInfo(1).oracleType())) {
+            throw std::runtime_error(fmt::format("{} is not a BLOB, CLOB or NCLOB column", column));
+        }
+        return stmt;
+    };
+
+    UploadTransaction transaction(conn);
+    auto stmt = selectLocator();
+    const auto lobType = stmt.getColumnInfo(1).oracleType();
+    if (stmt.getColumnValue(1).isNull()) {
+        auto init = conn.prepareStatement(fmt::format("update {} set {} = {} where {}",
+                                                      table,
+                                                      column,
+                                                      lobType == DPI_ORACLE_TYPE_BLOB ? "empty_blob()" : "empty_clob()",
+                                                      where));
+        init.execute();
+        stmt = selectLocator();
+    }
+    OracleLob lob(stmt.context(), stmt.getColumnValue(1).as<dpiLob*>());
+    if (stmt.fetch()) {
+        throw std::runtime_error(fmt::format("more than one row in {} matched {}", table, where));
+    }
+
+    const bool isBlob = lobType == DPI_ORACLE_TYPE_BLOB;
+    const uint64_t chunkSize = std::max<uint32_t>(lob.chunkSize(), 1);
+    const auto writeSize = std::max(chunkSize, kTargetWriteSize / chunkSize * chunkSize);
+
+    LobUploadStats stats;
+    lob.trim(0);
+    OpenLobResource openLob(lob);
+    auto data = file.contents();
+    uint64_t offset = 1;
+    while (!data.empty()) {
+        const auto length = isBlob ? std::min<size_t>(writeSize, data.size()) : utf8PrefixLength(data, writeSize);
+        const auto piece = data.substr(0, length);
+        lob.writeBytes(offset, piece);
+        offset += isBlob ? length : countUtf16Units(piece);
+        data.remove_prefix(length);
+        ++stats.writes;
+    }
+    openLob.close();
+    stats.committed = transaction.commit();
+
+    stats.bytes = file.size();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "oracle_helpers.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+struct LobUploadStats {
+    uint64_t bytes = 0;
+    uint64_t writes = 0;
+    // False when the upload was left in a transaction the session already had open.
+    bool committed = false;
+    double seconds = 0;
+};
+
+// Replaces the contents of the BLOB/CLOB column in the one row of table matching where
+// with the contents of the file at path. A null column is initialized to an empty LOB
+// first. The upload is committed, unless the session already has a transaction open, in
+// which case it becomes part of that transaction and is left for the user to commit. If
+// the upload fails only its own changes are rolled back.
+LobUploadStats uploadLob(OracleConnection& conn,
+                         std::string_view table,
+                         std::string_view column,
+                         std::string_view where,
+                         const std::string& path);
+
+} // namespace sqlplusplus
@@ -0,0 +1,633 @@
+#include "local_query.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+using Column = ResultSet::Column;
+using ColumnType = ResultSet::ColumnType;
+using RowIndex = ResultSet::RowIndex;
+using Selection = ResultSet::Selection;
+using Op = LocalPredicate::Op;
+
+// Below this many rows a single-threaded sort is faster than starting threads.
+constexpr size_t kParallelSortThreshold = 1 << 16;
+constexpr size_t kDefaultDisplayRows = 20;
+
+// The comparison kernels write a 0/1 mask for every row in the column rather than
+// branching per row so that the compiler can vectorize them.
+template <typename T, typename R, typename Cmp>
+void compareKernel(const T* values, const uint8_t* nulls, size_t count, R rhs, Cmp cmp, uint8_t* mask) {
+    for (size_t idx = 0; idx < count; ++idx) {
+        mask[idx] = static_cast<uint8_t>(cmp(values[idx], rhs) & (nulls[idx] == 0));
+    }
+}
+
+template <typename T, typename R>
+void compareColumn(const T* values, const uint8_t* nulls, size_t count, R rhs, Op op, uint8_t* mask) {
+    switch (op) {
+    case Op::Equal:
+        compareKernel(values, nulls, count, rhs, std::equal_to<>{}, mask);
+        break;
+    case Op::NotEqual:
+        compareKernel(values, nulls, count, rhs, std::not_equal_to<>{}, mask);
+        break;
+    case Op::Less:
+        compareKernel(values, nulls, count, rhs, std::less<>{}, mask);
+        break;
+    case Op::LessEqual:
+        compareKernel(values, nulls, count, rhs, std::less_equal<>{}, mask);
+        break;
+    case Op::Greater:
+        compareKernel(values, nulls, count, rhs, std::greater<>{}, mask);
+        break;
+    case Op::GreaterEqual:
+        compareKernel(values, nulls, count, rhs, std::greater_equal<>{}, mask);
+        break;
+    default:
+        throw std::runtime_error("operator is not supported for numeric columns");
+    }
+}
+
+std::optional<int64_t> parseInt64(const std::string& str) {
+    if (str.empty()) {
+        return std::nullopt;
+    }
+    char* end = nullptr;
+    errno = 0;
+    auto val = std::strtoll(str.c_str(), &end, 10);
+    if (errno == ERANGE || *end != '\0') {
+        return std::nullopt;
+    }
+    return val;
+}
+
+std::optional<uint64_t> parseUInt64(const std::string& str) {
+    if (str.empty() || str.front() == '-') {
+        return std::nullopt;
+    }
+    char* end = nullptr;
+    errno = 0;
+    auto val = std::strtoull(str.c_str(), &end, 10);
+    if (errno == ERANGE || *end != '\0') {
+        return std::nullopt;
+    }
+    return val;
+}
+
+double parseDouble(const std::string& str) {
+    char* end = nullptr;
+    auto val = std::strtod(str.c_str(), &end);
+    if (str.empty() || *end != '\0') {
+        throw std::runtime_error(fmt::format("\"{}\" is not a number", str));
+    }
+    return val;
+}
+
+void textKernel(const Column& col, size_t count, std::string_view rhs, Op op, uint8_t* mask) {
+    auto apply = [&](auto cmp) {
+        for (size_t idx = 0; idx < count; ++idx) {
+            auto row = static_cast<RowIndex>(idx);
+            mask[idx] = static_cast<uint8_t>(!col.isNull(row) && cmp(col.textAt(row)));
+        }
+    };
+
+    switch (op) {
+    case Op::Equal:
+        apply([&](std::string_view v) { return v == rhs; });
+        break;
+    case Op::NotEqual:
+        apply([&](std::string_view v) { return v != rhs; });
+        break;
+    case Op::Less:
+        apply([&](std::string_view v) { return v < rhs; });
+        break;
+    case Op::LessEqual:
+        apply([&](std::string_view v) { return v <= rhs; });
+        break;
+    case Op::Greater:
+        apply([&](std::string_view v) { return v > rhs; });
+        break;
+    case Op::GreaterEqual:
+        apply([&](std::string_view v) { return v >= rhs; });
+        break;
+    case Op::Contains:
+        apply([&](std::string_view v) { return v.find(rhs) != std::string_view::npos; });
+        break;
+    default:
+        throw std::runtime_error("unsupported operator for text column");
+    }
+}
+
+template <typename KeyFn>
+auto makeRowLess(const Column& col, KeyFn key, bool descending) {
+    return [&col, key, descending](RowIndex lhs, RowIndex rhs) {
+        const bool lhsNull = col.isNull(lhs);
+        const bool rhsNull = col.isNull(rhs);
+        if (lhsNull || rhsNull) {
+            return !lhsNull && rhsNull;
+        }
+        return descending ? key(rhs) < key(lhs) : key(lhs) < key(rhs);
+    };
+}
+
+template <typename Fn>
+void withRowLess(const Column& col, bool descending, Fn&& fn) {
+    switch (col.type) {
+    case ColumnType::Int64:
+        fn(makeRowLess(col, [&col](RowIndex row) { return col.ints[row]; }, descending));
+        break;
+    case ColumnType::UInt64:
+        fn(makeRowLess(col, [&col](RowIndex row) { return col.uints[row]; }, descending));
+        break;
+    case ColumnType::Double:
+        fn(makeRowLess(col, [&col](RowIndex row) { return col.doubles[row]; }, descending));
+        break;
+    case ColumnType::Text:
+        fn(makeRowLess(col, [&col](RowIndex row) { return col.textAt(row); }, descending));
+        break;
+    }
+}
+
+template <typename Less>
+void parallelSort(Selection& rows, Less less) {
+    const size_t hwThreads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t numChunks = std::min(hwThreads, rows.size() / (kParallelSortThreshold / 2));
+    if (rows.size() < kParallelSortThreshold || numChunks < 2) {
+        std::stable_sort(rows.begin(), rows.end(), less);
+        return;
+    }
+
+    std::vector<size_t> bounds(numChunks + 1);
+    for (size_t idx = 0; idx <= numChunks; ++idx) {
+        bounds[idx] = rows.size() * idx / numChunks;
+    }
+
+    const auto begin = rows.begin();
+    std::vector<std::thread> workers;
+    workers.reserve(numChunks);
+    for (size_t idx = 0; idx < numChunks; ++idx) {
+        workers.emplace_back([=] {
+            std::stable_sort(begin + bounds[idx], begin + bounds[idx + 1], less);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Merge neighbouring sorted chunks pairwise until there's only one left.
+    for (size_t width = 1; width < numChunks; width *= 2) {
+        workers.clear();
+        for (size_t idx = 0; idx + width < numChunks; idx += 2 * width) {
+            auto first = begin + bounds[idx];
+            auto middle = begin + bounds[idx + width];
+            auto last = begin + bounds[std::min(idx + 2 * width, numChunks)];
+            workers.emplace_back([=] { std::inplace_merge(first, middle, last, less); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+}
+
+// Assigns a group number to every row in `rows` (in first-seen order) and records the
+// first row of every group.
+template <typename Key, typename KeyFn>
+size_t assignGroups(const Column& col,
+                    const Selection& rows,
+                    KeyFn key,
+                    std::vector<size_t>& groupOf,
+                    Selection& firstRows) {
+    std::unordered_map<Key, size_t> groups;
+    std::optional<size_t> nullGroup;
+    groupOf.resize(rows.size());
+    for (size_t idx = 0; idx < rows.size(); ++idx) {
+        const auto row = rows[idx];
+        if (col.isNull(row)) {
+            if (!nullGroup) {
+                nullGroup = firstRows.size();
+                firstRows.push_back(row);
+            }
+            groupOf[idx] = *nullGroup;
+            continue;
+        }
+        auto [it, inserted] = groups.try_emplace(key(row), firstRows.size());
+        if (inserted) {
+            firstRows.push_back(row);
+        }
+        groupOf[idx] = it->second;
+    }
+    return firstRows.size();
+}
+
+void appendValueFrom(ResultSet& out, size_t outColumn, const Column& col, RowIndex row) {
+    if (col.isNull(row)) {
+        out.appendNull(outColumn);
+        return;
+    }
+    switch (col.type) {
+    case ColumnType::Int64:
+        out.appendInt64(outColumn, col.ints[row]);
+        break;
+    case ColumnType::UInt64:
+        out.appendUInt64(outColumn, col.uints[row]);
+        break;
+    case ColumnType::Double:
+        out.appendDouble(outColumn, col.doubles[row]);
+        break;
+    case ColumnType::Text:
+        out.appendText(outColumn, col.textAt(row));
+        break;
+    }
+}
+
+struct Accumulator {
+    int64_t intValue = 0;
+    uint64_t uintValue = 0;
+    double doubleValue = 0;
+    bool seen = false;
+};
+
+std::vector<std::string> tokenize(std::string_view stage) {
+    std::vector<std::string> tokens;
+    size_t pos = 0;
+    while (pos < stage.size()) {
+        if (std::isspace(static_cast<unsigned char>(stage[pos]))) {
+            ++pos;
+            continue;
+        }
+        std::string token;
+        if (stage[pos] == '\'' || stage[pos] == '"') {
+            const auto quote = stage[pos++];
+            auto end = stage.find(quote, pos);
+            if (end == std::string_view::npos) {
+                throw std::runtime_error("unterminated quoted value in local query");
+            }
+            token = std::string(stage.substr(pos, end - pos));
+            pos = end + 1;
+        } else {
+            auto end = pos;
+            while (end < stage.size() && !std::isspace(static_cast<unsigned char>(stage[end]))) {
+                ++end;
+            }
+            token = std::string(stage.substr(pos, end - pos));
+            pos = end;
+        }
+        tokens.push_back(std::move(token));
+    }
+    return tokens;
+}
+
+std::string toLower(std::string_view str) {
+    std::string out(str);
+    std::transform(out.begin(), out.end(), out.begin(), [](unsigned char ch) { return std::tolower(ch); });
+    return out;
+}
+
+Op parseOp(std::string_view op) {
+    if (op == "=" || op == "==") {
+        return Op::Equal;
+    } else if (op == "!=" || op == "<>") {
+        return Op::NotEqual;
+    } else if (op == "<") {
+        return Op::Less;
+    } else if (op == "<=") {
+        return Op::LessEqual;
+    } else if (op == ">") {
+        return Op::Greater;
+    } else if (op == ">=") {
+        return Op::GreaterEqual;
+    } else if (op == "~") {
+        return Op::Contains;
+    } else if (op == "isnull") {
+        return Op::IsNull;
+    } else if (op == "notnull") {
+        return Op::NotNull;
+    }
+    throw std::runtime_error(fmt::format("unknown filter operator \"{}\"", op));
+}
+
+size_t parseCount(const std::string& token) {
+    auto count = parseInt64(token);
+    if (!count || *count < 0) {
+        throw std::runtime_error(fmt::format("\"{}\" is not a valid row count", token));
+    }
+    return static_cast<size_t>(*count);
+}
+
+bool parseDirection(const std::vector<std::string>& tokens, size_t idx, bool defaultDescending) {
+    if (idx >= tokens.size()) {
+        return defaultDescending;
+    }
+    auto dir = toLower(tokens[idx]);
+    if (dir == "desc") {
+        return true;
+    } else if (dir == "asc") {
+        return false;
+    }
+    throw std::runtime_error(fmt::format("expected asc or desc, got \"{}\"", tokens[idx]));
+}
+
+LocalAggregate parseAggregate(const ResultSet& rs, const std::string& token) {
+    auto lowered = toLower(token);
+    if (lowered == "count") {
+        return LocalAggregate{LocalAggregate::Kind::Count, 0};
+    }
+
+    auto open = token.find('(');
+    if (open == std::string::npos || token.back() != ')') {
+        throw std::runtime_error(fmt::format("invalid aggregate \"{}\"", token));
+    }
+    auto fn = lowered.substr(0, open);
+    auto column = rs.columnIndex(std::string_view(token).substr(open + 1, token.size() - open - 2));
+    if (fn == "sum") {
+        return LocalAggregate{LocalAggregate::Kind::Sum, column};
+    } else if (fn == "min") {
+        return LocalAggregate{LocalAggregate::Kind::Min, column};
+    } else if (fn == "max") {
+        return LocalAggregate{LocalAggregate::Kind::Max, column};
+    } else if (fn == "count") {
+        return LocalAggregate{LocalAggregate::Kind::CountValues, column};
+    }
+    throw std::runtime_error(fmt::format("unknown aggregate function \"{}\"", fn));
+}
+} // namespace
+
+Selection filterRows(const ResultSet& rs, const Selection& rows, const LocalPredicate& pred) {
+    const auto& col = rs.columns().at(pred.column);
+    const size_t numRows = rs.numRows();
+    std::vector<uint8_t> mask(numRows);
+
+    switch (pred.op) {
+    case Op::IsNull:
+        std::copy(col.nulls.begin(), col.nulls.end(), mask.begin());
+        break;
+    case Op::NotNull:
+        std::transform(col.nulls.begin(), col.nulls.end(), mask.begin(), [](uint8_t v) {
+            return static_cast<uint8_t>(v ^ 1);
+        });
+        break;
+    default:
+        if (col.type == ColumnType::Text) {
+            textKernel(col, numRows, pred.value, pred.op, mask.data());
+        } else if (pred.op == Op::Contains) {
+            throw std::runtime_error(fmt::format("~ is only supported for text columns, {} is numeric", col.name));
+        } else if (auto intValue = parseInt64(pred.value); intValue && col.type == ColumnType::Int64) {
+            compareColumn(col.ints.data(), col.nulls.data(), numRows, *intValue, pred.op, mask.data());
+        } else if (col.type == ColumnType::Int64) {
+            compareColumn(col.ints.data(), col.nulls.data(), numRows, parseDouble(pred.value), pred.op, mask.data());
+        } else if (auto uintValue = parseUInt64(pred.value); uintValue && col.type == ColumnType::UInt64) {
+            compareColumn(col.uints.data(), col.nulls.data(), numRows, *uintValue, pred.op, mask.data());
+        } else if (col.type == ColumnType::UInt64) {
+            compareColumn(col.uints.data(), col.nulls.data(), numRows, parseDouble(pred.value), pred.op, mask.data());
+        } else {
+            compareColumn(col.doubles.data(), col.nulls.data(), numRows, parseDouble(pred.value), pred.op, mask.data());
+        }
+    }
+
+    Selection out(rows.size());
+    size_t outIdx = 0;
+    for (auto row : rows) {
+        out[outIdx] = row;
+        outIdx += mask[row];
+    }
+    out.resize(outIdx);
+    return out;
+}
+
+void sortRows(const ResultSet& rs, Selection& rows, size_t column, bool descending) {
+    withRowLess(rs.columns().at(column), descending, [&](auto less) {
+        parallelSort(rows, less);
+    });
+}
+
+void topRows(const ResultSet& rs, Selection& rows, size_t count, size_t column, bool descending) {
+    if (count >= rows.size()) {
+        sortRows(rs, rows, column, descending);
+        return;
+    }
+
+    withRowLess(rs.columns().at(column), descending, [&](auto less) {
+        std::partial_sort(rows.begin(), rows.begin() + count, rows.end(), less);
+    });
+    rows.resize(count);
+}
+
+ResultSet groupRows(const ResultSet& rs,
+                    const Selection& rows,
+                    size_t keyColumn,
+                    const std::vector<LocalAggregate>& aggregates) {
+    const auto& keyCol = rs.columns().at(keyColumn);
+    std::vector<size_t> groupOf;
+    Selection firstRows;
+    size_t numGroups = 0;
+    switch (keyCol.type) {
+    case ColumnType::Int64:
+        numGroups = assignGroups<int64_t>(
+                keyCol, rows, [&](RowIndex row) { return keyCol.ints[row]; }, groupOf, firstRows);
+        break;
+    case ColumnType::UInt64:
+        numGroups = assignGroups<uint64_t>(
+                keyCol, rows, [&](RowIndex row) { return keyCol.uints[row]; }, groupOf, firstRows);
+        break;
+    case ColumnType::Double:
+        numGroups = assignGroups<double>(
+                keyCol, rows, [&](RowIndex row) { return keyCol.doubles[row]; }, groupOf, firstRows);
+        break;
+    case ColumnType::Text:
+        numGroups = assignGroups<std::string_view>(
+                keyCol, rows, [&](RowIndex row) { return keyCol.textAt(row); }, groupOf, firstRows);
+        break;
+    }
+
+    ResultSet out;
+    out.addColumn(keyCol.name, keyCol.type);
+    for (const auto& agg : aggregates) {
+        const auto& srcCol = rs.columns().at(agg.column);
+        switch (agg.kind) {
+        case LocalAggregate::Kind::Count:
+            out.addColumn("COUNT", ColumnType::Int64);
+            break;
+        case LocalAggregate::Kind::CountValues:
+            out.addColumn(fmt::format("COUNT({})", srcCol.name), ColumnType::Int64);
+            break;
+        case LocalAggregate::Kind::Sum:
+        case LocalAggregate::Kind::Min:
+        case LocalAggregate::Kind::Max: {
+            if (!srcCol.isNumeric()) {
+                throw std::runtime_error(fmt::format("cannot aggregate text column {}", srcCol.name));
+            }
+            constexpr std::string_view kNames[] = {"COUNT", "SUM", "MIN", "MAX"};
+            out.addColumn(fmt::format("{}({})", kNames[static_cast<size_t>(agg.kind)], srcCol.name), srcCol.type);
+            break;
+        }
+        }
+    }
+
+    std::vector<std::vector<Accumulator>> accs(aggregates.size(), std::vector<Accumulator>(numGroups));
+    for (size_t aggIdx = 0; aggIdx < aggregates.size(); ++aggIdx) {
+        const auto& agg = aggregates[aggIdx];
+        const auto& srcCol = rs.columns().at(agg.column);
+        const bool isInt = srcCol.type == ColumnType::Int64;
+        const bool isUInt = srcCol.type == ColumnType::UInt64;
+        auto& aggAccs = accs[aggIdx];
+        for (size_t idx = 0; idx < rows.size(); ++idx) {
+            const auto row = rows[idx];
+            auto& acc = aggAccs[groupOf[idx]];
+            if (agg.kind == LocalAggregate::Kind::Count) {
+                acc.intValue++;
+                continue;
+            }
+            if (srcCol.isNull(row)) {
+                continue;
+            }
+            if (agg.kind == LocalAggregate::Kind::CountValues) {
+                acc.intValue++;
+                continue;
+            }
+            const auto intValue = isInt ? srcCol.ints[row] : 0;
+            const auto uintValue = isUInt ? srcCol.uints[row] : 0;
+            const auto doubleValue = isInt || isUInt ? 0 : srcCol.doubles[row];
+            switch (agg.kind) {
+            case LocalAggregate::Kind::Sum:
+                acc.intValue += intValue;
+                acc.uintValue += uintValue;
+                acc.doubleValue += doubleValue;
+                break;
+            case LocalAggregate::Kind::Min:
+                acc.intValue = acc.seen ? std::min(acc.intValue, intValue) : intValue;
+                acc.uintValue = acc.seen ? std::min(acc.uintValue, uintValue) : uintValue;
+                acc.doubleValue = acc.seen ? std::min(acc.doubleValue, doubleValue) : doubleValue;
+                break;
+            case LocalAggregate::Kind::Max:
+                acc.intValue = acc.seen ? std::max(acc.intValue, intValue) : intValue;
+                acc.uintValue = acc.seen ? std::max(acc.uintValue, uintValue) : uintValue;
+                acc.doubleValue = acc.seen ? std::max(acc.doubleValue, doubleValue) : doubleValue;
+                break;
+            case LocalAggregate::Kind::Count:
+            case LocalAggregate::Kind::CountValues:
+                break;
+            }
+            acc.seen = true;
+        }
+    }
+
+    for (size_t group = 0; group < numGroups; ++group) {
+        appendValueFrom(out, 0, keyCol, firstRows[group]);
+        for (size_t aggIdx = 0; aggIdx < aggregates.size(); ++aggIdx) {
+            const auto& acc = accs[aggIdx][group];
+            const auto outCol = aggIdx + 1;
+            const auto kind = aggregates[aggIdx].kind;
+            if (kind == LocalAggregate::Kind::Count || kind == LocalAggregate::Kind::CountValues) {
+                out.appendInt64(outCol, acc.intValue);
+            } else if (!acc.seen) {
+                out.appendNull(outCol);
+            } else if (out.columns()[outCol].type == ColumnType::Int64) {
+                out.appendInt64(outCol, acc.intValue);
+            } else if (out.columns()[outCol].type == ColumnType::UInt64) {
+                out.appendUInt64(outCol, acc.uintValue);
+            } else {
+                out.appendDouble(outCol, acc.doubleValue);
+            }
+        }
+        out.finishRow();
+    }
+
+    return out;
+}
+
+void runLocalQuery(const ResultSet& rs, std::string_view pipeline, std::ostream& out) {
+    if (rs.empty()) {
+        throw std::runtime_error("there is no result set to query locally");
+    }
+
+    const ResultSet* current = &rs;
+    ResultSet grouped;
+    Selection rows = rs.allRows();
+    std::optional<size_t> displayLimit;
+
+    size_t stageStart = 0;
+    while (stageStart <= pipeline.size()) {
+        auto stageEnd = pipeline.find('|', stageStart);
+        if (stageEnd == std::string_view::npos) {
+            stageEnd = pipeline.size();
+        }
+        auto tokens = tokenize(pipeline.substr(stageStart, stageEnd - stageStart));
+        stageStart = stageEnd + 1;
+        if (tokens.empty()) {
+            throw std::runtime_error("empty stage in local query");
+        }
+
+        auto stage = toLower(tokens[0]);
+        if (stage == "filter") {
+            if (tokens.size() < 3) {
+                throw std::runtime_error("filter requires a column, an operator and a value");
+            }
+            LocalPredicate pred;
+            pred.column = current->columnIndex(tokens[1]);
+            pred.op = parseOp(toLower(tokens[2]));
+            if (pred.op != Op::IsNull && pred.op != Op::NotNull) {
+                if (tokens.size() != 4) {
+                    throw std::runtime_error("filter requires a column, an operator and a value");
+                }
+                pred.value = tokens[3];
+            }
+            rows = filterRows(*current, rows, pred);
+        } else if (stage == "sort") {
+            if (tokens.size() < 2) {
+                throw std::runtime_error("sort requires a column");
+            }
+            sortRows(*current, rows, current->columnIndex(tokens[1]), parseDirection(tokens, 2, false));
+        } else if (stage == "top") {
+            if (tokens.size() < 3) {
+                throw std::runtime_error("top requires a row count and a column");
+            }
+            auto count = parseCount(tokens[1]);
+            topRows(*current, rows, count, current->columnIndex(tokens[2]), parseDirection(tokens, 3, true));
+            displayLimit = count;
+        } else if (stage == "limit") {
+            if (tokens.size() != 2) {
+                throw std::runtime_error("limit requires a row count");
+            }
+            auto count = parseCount(tokens[1]);
+            rows.resize(std::min(rows.size(), count));
+            displayLimit = count;
+        } else if (stage == "group") {
+            if (tokens.size() < 2) {
+                throw std::runtime_error("group requires a column");
+            }
+            std::vector<LocalAggregate> aggregates;
+            for (size_t idx = 2; idx < tokens.size(); ++idx) {
+                aggregates.push_back(parseAggregate(*current, tokens[idx]));
+            }
+            if (aggregates.empty()) {
+                aggregates.push_back(LocalAggregate{LocalAggregate::Kind::Count, 0});
+            }
+            auto result = groupRows(*current, rows, current->columnIndex(tokens[1]), aggregates);
+            grouped = std::move(result);
+            current = &grouped;
+            rows = grouped.allRows();
+        } else {
+            throw std::runtime_error(fmt::format("unknown local query stage \"{}\"", tokens[0]));
+        }
+    }
+
+    const auto totalRows = rows.size();
+    rows.resize(std::min(totalRows, displayLimit.value_or(kDefaultDisplayRows)));
+    current->render(out, rows);
+    out << fmt::format("{} rows matched, showing {}", totalRows, rows.size()) << std::endl;
+}
+
+} // namespace sqlplusplus
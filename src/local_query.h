@@ -0,0 +1,49 @@
+#pragma once
+
+#include "result_set.h"
+
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sqlplusplus {
+
+struct LocalPredicate {
+    enum class Op { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual, Contains, IsNull, NotNull };
+
+    size_t column = 0;
+    Op op = Op::Equal;
+    std::string value;
+};
+
+struct LocalAggregate {
+    // Count is a bare count of the rows, CountValues is count(column), which like SQL
+    // skips the rows where column is null.
+    enum class Kind { Count, Sum, Min, Max, CountValues };
+
+    Kind kind = Kind::Count;
+    size_t column = 0;
+};
+
+// Returns the rows from `rows` for which the predicate is true, preserving their order.
+ResultSet::Selection filterRows(const ResultSet& rs, const ResultSet::Selection& rows, const LocalPredicate& pred);
+
+// Sorts `rows` by the values in `column`. Nulls always sort last. Large selections are
+// sorted in parallel chunks which are then merged.
+void sortRows(const ResultSet& rs, ResultSet::Selection& rows, size_t column, bool descending);
+
+// Keeps only the `count` rows with the largest (or smallest) values in `column`, in order.
+void topRows(const ResultSet& rs, ResultSet::Selection& rows, size_t count, size_t column, bool descending);
+
+ResultSet groupRows(const ResultSet& rs,
+                    const ResultSet::Selection& rows,
+                    size_t keyColumn,
+                    const std::vector<LocalAggregate>& aggregates);
+
+// Parses and runs a pipeline of local operations separated by '|', e.g.
+//   filter AMOUNT > 100 | sort AMOUNT desc | top 10 AMOUNT
+// and renders the result to `out`.
+void runLocalQuery(const ResultSet& rs, std::string_view pipeline, std::ostream& out);
+
+} // namespace sqlplusplus
@@ -1,8 +1,19 @@
 
+#include "background_jobs.h"
+#include "bind_vars.h"
 #include "cli_args.h"
 #include "dpi.h"
+#include "lob_upload.h"
+#include "local_query.h"
 #include "oracle_helpers.h"
-#include "table.h"
+#include "result_search.h"
+#include "result_set.h"
+#include "schema_dump.h"
+#include "script_runner.h"
+#include "server_output.h"
+#include "soda.h"
+#include "table_load.h"
+#include "text_export.h"
 
 #include "fmt/format.h"
 #include "linenoise.h"
@@ -11,11 +22,14 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <numeric>
 #include <optional>
-#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -59,82 +73,62 @@ struct LinenoiseMaskGuard {
 
 std::function<std::vector<std::string>(std::string_view cmd)> generateCompletions;
 
-bool fetchAndPrintResults(OracleStatement& stmt, int maxResults) {
-    if (!stmt.fetch()) {
-        std::cout << "No rows returned" << std::endl;
-        return false;
-    }
-    Table table(stmt.numColumns());
-    
-    table.addRow();
-    for (int idx = 1; idx <= stmt.numColumns(); ++idx) {
-        auto colInfo = stmt.getColumnInfo(idx);
-        table.setColumnValue(0, idx - 1, colInfo.name());
-    }
+// Options that can be changed with .set
+struct ShellSettings {
+    TemporalFormatSettings temporal;
+} settings;
+
+// Set while .set serveroutput is on, DBMS_OUTPUT lines are printed after every statement.
+std::optional<ServerOutput> serverOutput;
 
+// Fetches up to maxResults rows from stmt into results and prints them. Returns whether
+// the statement may have more rows to fetch.
+bool fetchAndPrintResults(OracleStatement& stmt, int maxResults, ResultSet& results) {
+    const auto firstRow = results.numRows();
     int resCounter = 0;
     bool moreResults = true;
-    while(resCounter < maxResults && moreResults) {
+    while (resCounter < maxResults && (moreResults = stmt.fetch())) {
+        results.appendRow(stmt);
         resCounter++;
-        auto rowIdx = table.addRow();
-        std::set<int> nulColumns;
-        for (auto col = 1; col <= stmt.numColumns(); ++col) {
-            auto colValue = stmt.getColumnValue(col);
-            std::string colValueStr;
-            if (colValue.isNull()) {
-                nulColumns.insert(col - 1);
-                colValueStr = "<null>";
-            }
-            switch(colValue.nativeType()) {
-            case DPI_NATIVE_TYPE_BOOLEAN:
-                colValueStr = colValue.as<bool>() ? "TRUE" : "FALSE";
-                break;
-            case DPI_NATIVE_TYPE_BYTES:
-                colValueStr = fmt::format("\"{}\"", colValue.as<std::string_view>());
-                break;
-            case DPI_NATIVE_TYPE_DOUBLE:
-                colValueStr = fmt::format("{}", colValue.as<double>());
-                break;
-            case DPI_NATIVE_TYPE_INT64:
-                colValueStr = fmt::format("{}", colValue.as<int64_t>());
-                break;
-            case DPI_NATIVE_TYPE_UINT64:
-                colValueStr = fmt::format("{}", colValue.as<uint64_t>());
-                break;
-            case DPI_NATIVE_TYPE_FLOAT:
-                colValueStr = fmt::format("{}", colValue.as<float>());
-                break;
-            case DPI_NATIVE_TYPE_TIMESTAMP: {
-                auto ts = colValue.as<dpiTimestamp*>();
-                colValueStr =fmt::format("{}-{}-{} {}:{}:{}.{} Z{}",
-                            ts->year,
-                            ts->month,
-                            ts->day,
-                            ts->hour,
-                            ts->minute,
-                            ts->second,
-                            ts->fsecond,
-                            ts->tzHourOffset);
-                break;
-                                            }
-            default:
-                colValueStr = "unsupported type";
-            }
-            table.setColumnValue(rowIdx, col - 1, colValueStr);
-        }
-        /*
-        for (const auto& col: nulColumns) {
-            table.row(resCounter + 1).cell(col).format().font_style({tabulate::FontStyle::italic});
-        }*/
+    }
 
-        moreResults = stmt.fetch();
+    if (resCounter == 0) {
+        std::cout << "No rows returned" << std::endl;
+        return false;
     }
 
-    table.render(std::cout);
+    ResultSet::Selection rows(resCounter);
+    std::iota(rows.begin(), rows.end(), firstRow);
+    results.render(std::cout, rows);
     std::cout << "Fetched " << resCounter << " rows" << std::endl;
     return moreResults;
 }
 
+// Columnar copy of every row fetched for the most recent statement, used by .local
+ResultSet lastResult;
+
+// Sessions for work that runs beside the shell's own connection, set up once the shell
+// has connected. Sessions are only opened when something needs one.
+std::unique_ptr<OracleConnectionPool> sessionPool;
+
+// Statements run with a trailing '&'.
+std::optional<BackgroundJobs> backgroundJobs;
+
+// The text without its leading spaces.
+std::string_view skipSpaces(std::string_view text) {
+    return text.substr(std::min(text.size(), text.find_first_not_of(' ')));
+}
+
+// Removes the next space-separated word from the front of cmdLine and returns it, or an
+// empty view once only spaces are left.
+std::string_view nextWord(std::string_view& cmdLine) {
+    cmdLine = skipSpaces(cmdLine);
+    auto end = std::min(cmdLine.size(), cmdLine.find(' '));
+    auto word = cmdLine.substr(0, end);
+    cmdLine = cmdLine.substr(end);
+    return word;
+}
+
 class Command;
 tsl::htrie_map<char, Command*>& getCommandMap() {
     static tsl::htrie_map<char, Command*> globalMap;
@@ -163,17 +157,16 @@ public:
         return kName;
     }
 
+    // Oracle identifiers are at most 128 bytes.
+    constexpr static uint32_t kMaxTableNameSize = 128;
+
     bool run(OracleConnection& conn, std::string_view tableName) override {
         if (tableName.empty()) {
             throw std::runtime_error("describe command requires a table name");
         }
-        OracleConnection::VariableOpts varopts;
-        varopts.dbTypeNum = DPI_ORACLE_TYPE_CHAR;
-        varopts.nativeTypeNum = DPI_NATIVE_TYPE_BYTES;
-        varopts.opts = OracleConnection::VariableOpts::ByteBufferOpts{
-            static_cast<uint32_t>(tableName.size()), false};
-        varopts.maxArraySize = 1;
-        auto var = conn.newArrayVariable(varopts);
+        if (tableName.size() > kMaxTableNameSize) {
+            throw std::runtime_error("table name is too long");
+        }
 
         std::string tableNameUpper;
         tableNameUpper.reserve(tableName.size());
@@ -185,21 +178,36 @@ public:
             return std::toupper(ch);
         });
 
-        var.setFrom(0, tableNameUpper);
-
-        constexpr auto describeStmtStr = \
-            "select column_name as \"Name\", "
-            "nullable as \"Null?\", "
-            "concat(concat(concat(data_type,'('),data_length),')') as \"Type\" "
-            "from all_tab_columns where table_name = :1";
+        // The statement and its bind variable are set up on first use and reused after that.
+        if (!_describeStatement) {
+            constexpr auto describeStmtStr = \
+                "select column_name as \"Name\", "
+                "nullable as \"Null?\", "
+                "concat(concat(concat(data_type,'('),data_length),')') as \"Type\" "
+                "from all_tab_columns where table_name = :1";
+
+            OracleConnection::VariableOpts varopts;
+            varopts.dbTypeNum = DPI_ORACLE_TYPE_VARCHAR;
+            varopts.nativeTypeNum = DPI_NATIVE_TYPE_BYTES;
+            varopts.opts = OracleConnection::VariableOpts::ByteBufferOpts{kMaxTableNameSize, true};
+            varopts.maxArraySize = 1;
+            _tableNameVar.emplace(conn.newArrayVariable(varopts));
+            _describeStatement.emplace(conn.prepareStatement(describeStmtStr));
+            _describeStatement->bindByPos(1, *_tableNameVar);
+        }
 
-        auto describeStatement = conn.prepareStatement(describeStmtStr);
-        describeStatement.bindByPos(1, var);
-        describeStatement.execute();
-        fetchAndPrintResults(describeStatement, std::numeric_limits<int>::max());
+        _tableNameVar->setFrom(0, tableNameUpper);
+        _describeStatement->execute();
+        ResultSet results;
+        results.reset(*_describeStatement, settings.temporal);
+        fetchAndPrintResults(*_describeStatement, std::numeric_limits<int>::max(), results);
 
         return true;
     }
+
+private:
+    std::optional<OracleVariable> _tableNameVar;
+    std::optional<OracleStatement> _describeStatement;
 } cmdDescribe;
 
 class ExitCommand : public Command {
@@ -232,7 +240,7 @@ public:
             return true;
         }
 
-        if (!fetchAndPrintResults(*_activeStatement, 20)) {
+        if (!fetchAndPrintResults(*_activeStatement, 20, lastResult)) {
             _activeStatement = std::nullopt;
         }
         return true;
@@ -242,10 +250,713 @@ public:
         _activeStatement = std::move(stmt);
     }
 
+    void clearActiveStatement() {
+        _activeStatement = std::nullopt;
+    }
+
+    // Fetches every remaining row of the active statement into results without printing them.
+    size_t fetchRemaining(ResultSet& results) {
+        if (!_activeStatement) {
+            return 0;
+        }
+
+        size_t fetched = 0;
+        while (_activeStatement->fetch()) {
+            results.appendRow(*_activeStatement);
+            ++fetched;
+        }
+        _activeStatement = std::nullopt;
+        return fetched;
+    }
+
 private:
     std::optional<OracleStatement> _activeStatement;
 } moreRowsCmd;
 
+class LocalCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".local");
+    LocalCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        if (cmdLine.empty()) {
+            throw std::runtime_error(
+                    "local command requires \"fetch\" or a pipeline of filter/sort/group/top/limit stages");
+        }
+
+        if (cmdLine == "fetch") {
+            auto fetched = moreRowsCmd.fetchRemaining(lastResult);
+            std::cout << "Fetched " << fetched << " more rows, "
+                      << lastResult.numRows() << " rows available locally" << std::endl;
+            return true;
+        }
+
+        runLocalQuery(lastResult, cmdLine, std::cout);
+        return true;
+    }
+} localCmd;
+
+class GrepCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".grep");
+    constexpr static size_t kMaxDisplayRows = 100;
+    GrepCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // Patterns wrapped in slashes (e.g. /^AB[0-9]+$/) are treated as regular expressions,
+    // anything else is searched for as a literal string.
+    bool run(OracleConnection& conn, std::string_view pattern) override {
+        ResultSearchOptions opts;
+        if (pattern.size() > 2 && pattern.front() == '/' && pattern.back() == '/') {
+            opts.regex = true;
+            pattern = pattern.substr(1, pattern.size() - 2);
+        }
+
+        auto rows = searchRows(lastResult, pattern, opts);
+        const auto matched = rows.size();
+        if (matched == 0) {
+            std::cout << "No matching rows" << std::endl;
+            return true;
+        }
+
+        rows.resize(std::min(matched, kMaxDisplayRows));
+        lastResult.render(std::cout, rows);
+        std::cout << matched << " of " << lastResult.numRows() << " rows matched";
+        if (matched > rows.size()) {
+            std::cout << ", showing first " << rows.size();
+        }
+        std::cout << std::endl;
+        return true;
+    }
+} grepCmd;
+
+class ExportCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".export");
+    ExportCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .export [raw] [checkpoint] [key=<column>] <file> <query>
+    //
+    // checkpoint makes the export restartable, which needs key=<column> or a query with an
+    // ORDER BY. key= also lets a restarted export skip the rows already written on the
+    // server (see TextExportOptions).
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        TextExportOptions opts;
+        opts.temporal = settings.temporal;
+
+        auto path = nextWord(cmdLine);
+        for (;; path = nextWord(cmdLine)) {
+            if (path == "raw") {
+                opts.rawText = true;
+            } else if (path == "checkpoint") {
+                opts.checkpoint = true;
+            } else if (path.substr(0, 4) == "key=" && path.size() > 4) {
+                opts.keyColumn = std::string(path.substr(4));
+            } else {
+                break;
+            }
+        }
+        cmdLine = skipSpaces(cmdLine);
+        if (path.empty() || cmdLine.empty()) {
+            throw std::runtime_error("export command requires a file name and a query");
+        }
+
+        auto stats = exportQuery(conn, cmdLine, std::string(path), opts);
+        std::cout << fmt::format("Exported {} rows ({:.1f} MB) to {} in {:.2f}s",
+                                 stats.rows, stats.bytes / (1024.0 * 1024.0), path, stats.seconds);
+        if (stats.resumedRows != 0) {
+            std::cout << fmt::format(", resumed after {} rows", stats.resumedRows);
+        }
+        std::cout << std::endl;
+        return true;
+    }
+} exportCmd;
+
+class DeltaCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".delta");
+    DeltaCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .delta [raw] [versions] <state file> <file> <table>
+    //
+    // Exports the rows of table changed since the last .delta with the same state file.
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        TextExportOptions opts;
+        opts.temporal = settings.temporal;
+        bool versions = false;
+
+        auto word = nextWord(cmdLine);
+        for (;; word = nextWord(cmdLine)) {
+            if (word == "raw") {
+                opts.rawText = true;
+            } else if (word == "versions") {
+                versions = true;
+            } else {
+                break;
+            }
+        }
+
+        auto statePath = word;
+        auto path = nextWord(cmdLine);
+        auto table = nextWord(cmdLine);
+        if (statePath.empty() || path.empty() || table.empty()) {
+            throw std::runtime_error("delta command requires a state file, a file name and a table name");
+        }
+
+        auto stats = exportDelta(conn, table, std::string(path), std::string(statePath), versions, opts);
+        if (stats.fromScn == 0) {
+            std::cout << fmt::format("Exported all {} rows of {} as of SCN {}", stats.rows.rows, table, stats.toScn);
+        } else {
+            std::cout << fmt::format("Exported {} {} of {} from SCN {} to {}", stats.rows.rows,
+                                     versions ? "row versions" : "changed rows", table, stats.fromScn, stats.toScn);
+        }
+        std::cout << fmt::format(" ({:.1f} MB) to {} in {:.2f}s",
+                                 stats.rows.bytes / (1024.0 * 1024.0), path, stats.rows.seconds)
+                  << std::endl;
+        return true;
+    }
+} deltaCmd;
+
+BindVariables bindVariables;
+
+class VarCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".var");
+    VarCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .var                                       list variables
+    // .var <name> = <value>                      set a string variable
+    // .var <name> list <type> <v1,v2,...|@file>  set a collection variable
+    // .var unset <name>
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        if (cmdLine.empty()) {
+            bindVariables.print(std::cout);
+            return true;
+        }
+
+        auto varName = nextWord(cmdLine);
+        if (varName == "unset") {
+            auto unsetName = nextWord(cmdLine);
+            if (!bindVariables.unset(unsetName)) {
+                std::cout << "No bind variable named " << unsetName << std::endl;
+            }
+            return true;
+        }
+
+        auto kind = nextWord(cmdLine);
+        if (kind == "=") {
+            bindVariables.setScalar(varName, std::string(skipSpaces(cmdLine)));
+        } else if (kind == "list") {
+            auto typeName = nextWord(cmdLine);
+            if (typeName.empty()) {
+                throw std::runtime_error("list variables require a collection type name");
+            }
+            auto count = bindVariables.setList(conn, varName, typeName, parseListValues(skipSpaces(cmdLine)));
+            std::cout << "Set :" << varName << " to a " << typeName << " with " << count << " elements" << std::endl;
+        } else {
+            throw std::runtime_error("expected .var <name> = <value> or .var <name> list <type> <values>");
+        }
+        return true;
+    }
+} varCmd;
+
+class SetCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".set");
+    SetCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        if (cmdLine.empty()) {
+            printSettings();
+            return true;
+        }
+
+        auto nameEnd = cmdLine.find(' ');
+        if (nameEnd == std::string_view::npos) {
+            throw std::runtime_error("set command requires a setting name and a value");
+        }
+        auto settingName = cmdLine.substr(0, nameEnd);
+        auto value = cmdLine.substr(nameEnd + 1);
+        value = skipSpaces(value);
+
+        if (settingName == "fsprecision") {
+            if (value == "auto") {
+                settings.temporal.fractionalDigits = -1;
+            } else if (value.size() == 1 && value[0] >= '0' && value[0] <= '9') {
+                settings.temporal.fractionalDigits = value[0] - '0';
+            } else {
+                throw std::runtime_error("fsprecision must be auto or a number of digits between 0 and 9");
+            }
+        } else if (settingName == "timezone") {
+            if (value == "auto") {
+                settings.temporal.timezone = TemporalFormatSettings::Timezone::Auto;
+            } else if (value == "on") {
+                settings.temporal.timezone = TemporalFormatSettings::Timezone::Always;
+            } else if (value == "off") {
+                settings.temporal.timezone = TemporalFormatSettings::Timezone::Never;
+            } else {
+                throw std::runtime_error("timezone must be one of auto, on or off");
+            }
+        } else if (settingName == "serveroutput") {
+            if (value == "on") {
+                if (!serverOutput) {
+                    serverOutput.emplace(conn);
+                }
+            } else if (value == "off") {
+                if (serverOutput) {
+                    serverOutput->disable(conn);
+                    serverOutput.reset();
+                }
+            } else {
+                throw std::runtime_error("serveroutput must be on or off");
+            }
+        } else {
+            throw std::runtime_error(fmt::format("unknown setting \"{}\"", settingName));
+        }
+        return true;
+    }
+
+private:
+    void printSettings() const {
+        const auto& temporal = settings.temporal;
+        std::cout << "fsprecision "
+                  << (temporal.fractionalDigits < 0 ? std::string("auto") : std::to_string(temporal.fractionalDigits))
+                  << "\n";
+        constexpr std::string_view timezoneNames[] = {"auto", "on", "off"};
+        std::cout << "timezone " << timezoneNames[static_cast<int>(temporal.timezone)] << "\n";
+        std::cout << "serveroutput " << (serverOutput ? "on" : "off") << std::endl;
+    }
+} setCmd;
+
+class PutLobCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".putlob");
+    PutLobCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .putlob <table> <column> [where] <condition> <file>
+    //
+    // Commits the upload, unless a transaction is already open (see uploadLob).
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        auto table = nextWord(cmdLine);
+        auto column = nextWord(cmdLine);
+        cmdLine = skipSpaces(cmdLine);
+        cmdLine = cmdLine.substr(0, cmdLine.find_last_not_of(' ') + 1);
+        auto pathStart = cmdLine.rfind(' ');
+        if (table.empty() || column.empty() || pathStart == std::string_view::npos) {
+            throw std::runtime_error("putlob command requires a table, a column, a where condition and a file name");
+        }
+        auto path = cmdLine.substr(pathStart + 1);
+        auto where = cmdLine.substr(0, pathStart);
+        if (where.size() > 6 && std::equal(where.begin(), where.begin() + 6, "where ", [](char l, char r) {
+                return std::tolower(static_cast<unsigned char>(l)) == r;
+            })) {
+            where.remove_prefix(6);
+        }
+
+        auto stats = uploadLob(conn, table, column, where, std::string(path));
+        const auto megabytes = stats.bytes / (1024.0 * 1024.0);
+        std::cout << fmt::format("Wrote {:.1f} MB to {}.{} in {} writes, {:.2f}s ({:.1f} MB/s)",
+                                 megabytes, table, column, stats.writes, stats.seconds,
+                                 stats.seconds > 0 ? megabytes / stats.seconds : 0.0)
+                  << std::endl;
+        if (!stats.committed) {
+            std::cout << "Not committed, it's part of the transaction that was already open" << std::endl;
+        }
+        return true;
+    }
+} putLobCmd;
+
+class SodaCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".soda");
+    constexpr static uint32_t kMaxDisplayDocuments = 20;
+    SodaCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .soda list
+    // .soda count <collection> [filter]
+    // .soda find <collection> [filter]
+    // .soda insert <collection> <file>         one JSON document per line
+    // .soda dump <collection> <file> [filter]
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        auto subCommand = nextWord(cmdLine);
+        if (subCommand == "list") {
+            for (const auto& collName : conn.sodaDatabase().collectionNames()) {
+                std::cout << collName << "\n";
+            }
+            std::cout << std::flush;
+            return true;
+        }
+
+        auto collection = nextWord(cmdLine);
+        if (collection.empty()) {
+            throw std::runtime_error("soda command requires list, count, find, insert or dump and a collection name");
+        }
+
+        if (subCommand == "count") {
+            auto count = conn.sodaDatabase().openCollection(collection).count(skipSpaces(cmdLine));
+            std::cout << count << " documents" << std::endl;
+        } else if (subCommand == "find") {
+            ResultSet docs;
+            auto more = findDocuments(conn, collection, skipSpaces(cmdLine), kMaxDisplayDocuments, docs);
+            if (docs.numRows() == 0) {
+                std::cout << "No documents found" << std::endl;
+                return true;
+            }
+            docs.render(std::cout, docs.allRows());
+            std::cout << "Found " << docs.numRows() << " documents";
+            if (more) {
+                std::cout << ", use .soda dump to fetch all of them";
+            }
+            std::cout << std::endl;
+        } else if (subCommand == "insert" || subCommand == "dump") {
+            auto path = nextWord(cmdLine);
+            if (path.empty()) {
+                throw std::runtime_error(fmt::format("soda {} requires a file name", subCommand));
+            }
+
+            SodaTransferStats stats;
+            if (subCommand == "insert") {
+                stats = loadDocuments(conn, collection, std::string(path), SodaLoadOptions{});
+            } else {
+                SodaDumpOptions opts;
+                opts.filter = skipSpaces(cmdLine);
+                stats = dumpDocuments(conn, collection, std::string(path), opts);
+            }
+            std::cout << fmt::format("{} {} documents ({:.1f} MB) in {:.2f}s",
+                                     subCommand == "insert" ? "Inserted" : "Dumped",
+                                     stats.documents, stats.bytes / (1024.0 * 1024.0), stats.seconds)
+                      << std::endl;
+        } else {
+            throw std::runtime_error(fmt::format("unknown soda command \"{}\"", subCommand));
+        }
+        return true;
+    }
+} sodaCmd;
+
+// Parses the row count of a batch= or commit= option, which must be a positive number.
+uint64_t parseCount(std::string_view option, std::string_view value) {
+    std::string valueStr(value);
+    char* end = nullptr;
+    const auto count = std::strtoull(valueStr.c_str(), &end, 10);
+    if (valueStr.empty() || *end != '\0' || count == 0) {
+        throw std::runtime_error(fmt::format("{} requires a positive number of rows", option));
+    }
+    return count;
+}
+
+class RunCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".run");
+    RunCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .run [nopipeline|pipelineall] [continue] [batch=<rows>] [commit=<rows>] <file>
+    // Queries are run ahead on a second session while the previous result is printed,
+    // pipelineall also does so when the script has uncommitted changes the second
+    // session can't see. continue keeps going after a statement fails. Runs of
+    // single-row INSERTs are sent batch rows at a time (batch=1 turns this off), and
+    // commit=<rows> commits every time that many batched rows have been inserted.
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        ScriptOptions opts;
+        opts.temporal = settings.temporal;
+
+        auto word = nextWord(cmdLine);
+        for (;; word = nextWord(cmdLine)) {
+            if (word == "nopipeline") {
+                opts.pipeline = ScriptOptions::Pipeline::Off;
+            } else if (word == "pipelineall") {
+                opts.pipeline = ScriptOptions::Pipeline::All;
+            } else if (word == "continue") {
+                opts.stopOnError = false;
+            } else if (word.substr(0, 6) == "batch=") {
+                opts.insertBatchSize = static_cast<uint32_t>(
+                        std::min<uint64_t>(parseCount("batch", word.substr(6)), std::numeric_limits<uint32_t>::max()));
+            } else if (word.substr(0, 7) == "commit=") {
+                opts.commitRows = parseCount("commit", word.substr(7));
+            } else {
+                break;
+            }
+        }
+        if (word.empty()) {
+            throw std::runtime_error("run command requires a script file name");
+        }
+
+        auto stats = runScript(conn, *sessionPool, std::string(word), opts, std::cout);
+        std::cout << fmt::format("Ran {} statements ({} failed, {} run ahead, {} inserts in {} batches), "
+                                 "{} rows in {:.2f}s",
+                                 stats.statements, stats.failed, stats.pipelined, stats.batchedInserts,
+                                 stats.batches, stats.rows, stats.seconds)
+                  << std::endl;
+        return true;
+    }
+} runCmd;
+
+class LoadCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".load");
+    LoadCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .load [format=csv|arrow] [delimiter=<char>|delimiter=tab] [noheader] [batch=<rows>]
+    //       [commit=<rows>] [direct] [nologging] [deferindexes] [checkpoint] <table> <file>
+    //
+    // Files ending in .arrow, .arrows or .feather are read as Arrow IPC unless a format is given.
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        CsvOptions csvOpts;
+        TableLoadOptions opts;
+        std::optional<bool> arrow;
+
+        auto word = nextWord(cmdLine);
+        for (;; word = nextWord(cmdLine)) {
+            if (word == "format=csv" || word == "format=arrow") {
+                arrow = word == "format=arrow";
+            } else if (word == "noheader") {
+                csvOpts.header = false;
+            } else if (word == "delimiter=tab") {
+                csvOpts.delimiter = '\t';
+            } else if (word.substr(0, 10) == "delimiter=" && word.size() == 11) {
+                csvOpts.delimiter = word[10];
+            } else if (word.substr(0, 6) == "batch=") {
+                opts.batchRows = static_cast<uint32_t>(std::min<uint64_t>(parseCount("batch", word.substr(6)), 1 << 20));
+            } else if (word.substr(0, 7) == "commit=") {
+                opts.commitRows = parseCount("commit", word.substr(7));
+            } else if (word == "direct") {
+                opts.directPath = true;
+            } else if (word == "nologging") {
+                opts.noLogging = true;
+            } else if (word == "deferindexes") {
+                opts.deferIndexes = true;
+            } else if (word == "checkpoint") {
+                opts.checkpoint = true;
+            } else {
+                break;
+            }
+        }
+
+        auto table = word;
+        auto path = nextWord(cmdLine);
+        if (table.empty() || path.empty()) {
+            throw std::runtime_error("load command requires a table name and a file name");
+        }
+        if (csvOpts.delimiter == '"' || csvOpts.delimiter == '\n' || csvOpts.delimiter == '\r') {
+            throw std::runtime_error("delimiter can't be a quote or a line break");
+        }
+
+        if (!arrow) {
+            const auto extension = path.substr(std::min(path.size(), path.rfind('.')));
+            arrow = extension == ".arrow" || extension == ".arrows" || extension == ".feather";
+        }
+        auto stats = *arrow ? loadArrow(conn, table, std::string(path), opts, std::cerr)
+                            : loadCsv(conn, table, std::string(path), csvOpts, opts, std::cerr);
+        std::cout << fmt::format("Loaded {} rows ({} rejected, {:.1f} MB) in {:.2f}s, {:.0f} rows/s, {}, {} commits",
+                                 stats.rows, stats.rejected, stats.bytes / (1024.0 * 1024.0), stats.seconds,
+                                 stats.seconds > 0 ? stats.rows / stats.seconds : 0.0,
+                                 opts.directPath ? "direct path" : "conventional", stats.commits)
+                  << std::endl;
+        if (stats.resumedRows != 0) {
+            std::cout << fmt::format("Resumed from a checkpoint after {} rows", stats.resumedRows) << std::endl;
+        }
+        if (stats.indexesRebuilt != 0) {
+            std::cout << fmt::format("Rebuilt {} indexes", stats.indexesRebuilt) << std::endl;
+        }
+        return true;
+    }
+} loadCmd;
+
+// Parses the sessions=<n> option of .dump and .restore.
+// More sessions than the pool has would only leave the extra threads waiting for one.
+uint32_t parseSessions(std::string_view value) {
+    const auto maxSessions = sessionPool->maxSessions();
+    std::string valueStr(value);
+    char* end = nullptr;
+    const auto count = std::strtoul(valueStr.c_str(), &end, 10);
+    if (valueStr.empty() || *end != '\0' || count == 0 || count > maxSessions) {
+        throw std::runtime_error(fmt::format("sessions requires a number from 1 to {}", maxSessions));
+    }
+    return static_cast<uint32_t>(count);
+}
+
+class DumpCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".dump");
+    DumpCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .dump [sessions=<n>] <schema> <dir>
+    //
+    // Writes the DDL of schema and the data of its tables, all as of one SCN, into dir.
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        SchemaDumpOptions opts;
+
+        auto word = nextWord(cmdLine);
+        if (word.substr(0, 9) == "sessions=") {
+            opts.sessions = parseSessions(word.substr(9));
+            word = nextWord(cmdLine);
+        }
+        auto schema = word;
+        auto dir = nextWord(cmdLine);
+        if (schema.empty() || dir.empty()) {
+            throw std::runtime_error("dump command requires a schema and a directory name");
+        }
+
+        auto stats = dumpSchema(conn, *sessionPool, schema, std::string(dir), opts, std::cerr);
+        std::cout << fmt::format("Dumped {} DDL statements and {} rows of {} tables ({:.1f} MB) "
+                                 "as of SCN {} to {} in {:.2f}s",
+                                 stats.ddlStatements, stats.rows, stats.tables, stats.bytes / (1024.0 * 1024.0),
+                                 stats.scn, dir, stats.seconds)
+                  << std::endl;
+        if (stats.failedTables != 0) {
+            std::cout << fmt::format("{} tables failed and were left out", stats.failedTables) << std::endl;
+        }
+        return true;
+    }
+} dumpCmd;
+
+class RestoreCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".restore");
+    RestoreCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .restore [sessions=<n>] <dir>
+    //
+    // Recreates a schema written by .dump in the current schema.
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        SchemaDumpOptions opts;
+
+        auto word = nextWord(cmdLine);
+        if (word.substr(0, 9) == "sessions=") {
+            opts.sessions = parseSessions(word.substr(9));
+            word = nextWord(cmdLine);
+        }
+        if (word.empty()) {
+            throw std::runtime_error("restore command requires a directory name");
+        }
+
+        auto stats = restoreSchema(conn, *sessionPool, std::string(word), opts, std::cerr);
+        std::cout << fmt::format("Restored {} rows of {} tables and ran {} DDL statements ({} failed) in {:.2f}s",
+                                 stats.rows, stats.tables, stats.ddlStatements, stats.failedStatements,
+                                 stats.seconds)
+                  << std::endl;
+        if (stats.failedTables != 0 || stats.rejected != 0) {
+            std::cout << fmt::format("{} tables failed, {} rows were rejected", stats.failedTables, stats.rejected)
+                      << std::endl;
+        }
+        return true;
+    }
+} restoreCmd;
+
+class JobsCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".jobs");
+    JobsCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        backgroundJobs->printJobs(std::cout);
+        return true;
+    }
+} jobsCmd;
+
+class ForegroundCommand : public Command {
+public:
+    constexpr static auto kName = std::string_view(".fg");
+    constexpr static ResultSet::RowIndex kMaxDisplayRows = 20;
+    ForegroundCommand() : Command(kName) {}
+
+    std::string_view name() const noexcept override {
+        return kName;
+    }
+
+    // .fg <job>
+    // Waits for the job to finish and makes its rows the last result, so the rest of them
+    // can be looked at with .local and .grep.
+    bool run(OracleConnection& conn, std::string_view cmdLine) override {
+        std::string idStr(cmdLine.substr(0, cmdLine.find(' ')));
+        char* end = nullptr;
+        const auto id = std::strtoul(idStr.c_str(), &end, 10);
+        if (idStr.empty() || *end != '\0') {
+            throw std::runtime_error("fg command requires a job number");
+        }
+
+        auto job = backgroundJobs->wait(static_cast<uint32_t>(id));
+        if (job->state == BackgroundJobs::State::Failed) {
+            std::cerr << "Job " << job->id << " failed: " << job->error << std::endl;
+            return true;
+        }
+
+        const std::chrono::duration<double> elapsed = job->ended - job->started;
+        if (job->results.empty()) {
+            std::cout << fmt::format("Job {} finished in {:.2f}s", job->id, elapsed.count()) << std::endl;
+            return true;
+        }
+
+        moreRowsCmd.clearActiveStatement();
+        lastResult = std::move(job->results);
+        const auto numRows = lastResult.numRows();
+        if (numRows == 0) {
+            std::cout << "No rows returned" << std::endl;
+            return true;
+        }
+
+        ResultSet::Selection rows(std::min(numRows, kMaxDisplayRows));
+        std::iota(rows.begin(), rows.end(), 0);
+        lastResult.render(std::cout, rows);
+        std::cout << fmt::format("Job {} fetched {} rows in {:.2f}s", job->id, numRows, elapsed.count());
+        if (numRows > rows.size()) {
+            std::cout << ", use .local or .grep to see the rest";
+        }
+        std::cout << std::endl;
+        return true;
+    }
+} fgCmd;
+
 tsl::htrie_set<char> populateReservedKeywords(OracleConnection& conn) {
     tsl::htrie_set<char> out;
     for (const auto& cmdName: getCommandMap()) {
@@ -320,6 +1031,8 @@ int main(int argc, const char** argv) try {
     });
 
     auto oracleConn = OracleConnection::make(oracleCtx.get(), connOpts);
+    sessionPool.reset(new OracleConnectionPool(OracleConnectionPool::make(oracleCtx.get(), connOpts)));
+    backgroundJobs.emplace(*sessionPool);
     auto reservedKeywords = populateReservedKeywords(oracleConn);
     generateCompletions = [&](std::string_view sv) -> std::vector<std::string> {
         std::vector<std::string> ret;
@@ -393,23 +1106,61 @@ int main(int argc, const char** argv) try {
                 }
             }
 
-            if (!cmdIt.value()->run(oracleConn, fullLine.substr(prefixEnd))) {
-                break;
+            try {
+                if (!cmdIt.value()->run(oracleConn, fullLine.substr(prefixEnd))) {
+                    break;
+                }
+            } catch(const OracleException& e) {
+                std::cerr << "Error " << e.context() << ": " << e.what() << std::endl;
+            } catch(const std::runtime_error& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+            }
+            continue;
+        }
+
+        // A trailing '&' runs the statement on a pooled session in the background.
+        if (auto lastChar = fullLine.find_last_not_of(' ');
+            lastChar != std::string::npos && fullLine[lastChar] == '&') {
+            linenoiseHistoryAdd(fullLine.c_str());
+            fullLine.resize(lastChar);
+            try {
+                auto id = backgroundJobs->start(fullLine, settings.temporal);
+                std::cout << "[" << id << "] started" << std::endl;
+            } catch(const OracleException& e) {
+                std::cerr << "Error " << e.context() << ": " << e.what() << std::endl;
             }
             continue;
         }
 
         try {
             auto activeStatement = oracleConn.prepareStatement(fullLine);
+            bindVariables.bindTo(oracleConn, activeStatement);
             activeStatement.execute();
             linenoiseHistoryAdd(fullLine.c_str());
-            fetchAndPrintResults(activeStatement, 20);
+            lastResult.reset(activeStatement, settings.temporal);
+            fetchAndPrintResults(activeStatement, 20, lastResult);
             moreRowsCmd.setActiveStatement(std::move(activeStatement));
         } catch(const OracleException& e) {
             std::cerr << "Error " << e.context() << ": " << e.what() << std::endl;
+        } catch(const std::runtime_error& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+
+        // A block that fails can still have written output before raising.
+        if (serverOutput) {
+            try {
+                serverOutput->drain(std::cout);
+            } catch(const OracleException& e) {
+                std::cerr << "Error " << e.context() << ": " << e.what() << std::endl;
+            }
         }
     }
 
+    // Interrupts anything still running, the jobs' sessions must be released before the
+    // pool and the context go away.
+    backgroundJobs.reset();
+    sessionPool.reset();
+
     if (!historyPath.empty()) {
         linenoiseHistorySave(historyPath.c_str());
     }
@@ -0,0 +1,54 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+MappedFile::MappedFile(const std::string& path) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(fmt::format("could not open {} for reading: {}", path, std::strerror(errno)));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto err = errno;
+        ::close(fd);
+        throw std::runtime_error(fmt::format("could not stat {}: {}", path, std::strerror(err)));
+    }
+
+    _size = static_cast<size_t>(st.st_size);
+    // mmap doesn't allow zero-length mappings, an empty file just has no data.
+    if (_size != 0) {
+        _data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    auto err = errno;
+    ::close(fd);
+    if (_data == MAP_FAILED) {
+        _data = nullptr;
+        throw std::runtime_error(fmt::format("could not map {}: {}", path, std::strerror(err)));
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+        ::munmap(_data, _size);
+    }
+}
+
+void MappedFile::adviseSequential() const noexcept {
+    if (_data != nullptr) {
+        ::madvise(_data, _size, MADV_SEQUENTIAL);
+    }
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+// A read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    // Throws std::runtime_error if the file can't be opened or mapped.
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    // Tells the kernel the mapping will be read front to back so it reads ahead aggressively.
+    void adviseSequential() const noexcept;
+
+    std::string_view contents() const noexcept {
+        return std::string_view(static_cast<const char*>(_data), _size);
+    }
+
+    size_t size() const noexcept {
+        return _size;
+    }
+
+private:
+    void* _data = nullptr;
+    size_t _size = 0;
+};
+
+} // namespace sqlplusplus
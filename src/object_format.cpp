@@ -0,0 +1,208 @@
+#include "object_format.h"
+
+#include <optional>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+std::string typeName(dpiOracleTypeNum oracleType) {
+    switch (oracleType) {
+    case DPI_ORACLE_TYPE_CLOB:
+        return "CLOB";
+    case DPI_ORACLE_TYPE_NCLOB:
+        return "NCLOB";
+    case DPI_ORACLE_TYPE_BLOB:
+        return "BLOB";
+    case DPI_ORACLE_TYPE_BFILE:
+        return "BFILE";
+    case DPI_ORACLE_TYPE_ROWID:
+        return "ROWID";
+    case DPI_ORACLE_TYPE_JSON:
+        return "JSON";
+    default:
+        return fmt::format("number {}", static_cast<int>(oracleType));
+    }
+}
+} // namespace
+
+ObjectFormatter::ObjectFormatter(OracleContext* ctx, TemporalFormatSettings temporal) :
+    _ctx(ctx),
+    _temporal(temporal)
+{}
+
+const ObjectFormatter::TypeDescriptor& ObjectFormatter::_describe(dpiObjectType* objType) {
+    auto it = _types.find(objType);
+    if (it != _types.end()) {
+        return *it->second;
+    }
+
+    auto desc = std::make_unique<TypeDescriptor>(OracleObjectType(_ctx, objType));
+    if (desc->type.isCollection()) {
+        desc->elementFormat = _temporal.resolve(desc->type.info().elementTypeInfo);
+    } else {
+        desc->attributes = desc->type.attributes();
+        desc->attributeFormats.reserve(desc->attributes.size());
+        for (const auto& attr : desc->attributes) {
+            desc->attributeFormats.push_back(_temporal.resolve(attr.typeInfo()));
+        }
+    }
+    return *_types.emplace(objType, std::move(desc)).first->second;
+}
+
+void ObjectFormatter::append(std::string& out, dpiObject* obj, dpiObjectType* objType, Style style) {
+    _appendObject(out, OracleObject(_ctx, obj), _describe(objType), style);
+}
+
+void ObjectFormatter::_appendObject(std::string& out,
+                                    const OracleObject& obj,
+                                    const TypeDescriptor& type,
+                                    Style style) {
+    const bool json = style == Style::Json;
+    if (!json) {
+        if (!type.type.schema().empty()) {
+            out.append(type.type.schema());
+            out.push_back('.');
+        }
+        out.append(type.type.name());
+    }
+
+    dpiData data;
+    if (type.type.isCollection()) {
+        const auto& elementInfo = type.type.info().elementTypeInfo;
+        out.push_back(json ? '[' : '(');
+        int32_t index = 0;
+        for (bool exists = obj.firstIndex(index), first = true; exists;
+             exists = obj.nextIndex(index, index), first = false) {
+            if (!first) {
+                out.append(json ? "," : ", ");
+            }
+            obj.getElementValue(index, elementInfo.defaultNativeTypeNum, data);
+            _appendValue(out, data, elementInfo.defaultNativeTypeNum, elementInfo, type.elementFormat, style,
+                         type, nullptr);
+        }
+        out.push_back(json ? ']' : ')');
+        return;
+    }
+
+    out.push_back(json ? '{' : '(');
+    for (size_t idx = 0; idx < type.attributes.size(); ++idx) {
+        const auto& attr = type.attributes[idx];
+        if (idx != 0) {
+            out.append(json ? "," : ", ");
+        }
+        if (json) {
+            appendJsonString(out, attr.name());
+            out.push_back(':');
+        }
+        obj.getAttributeValue(attr, data);
+        _appendValue(out, data, attr.typeInfo().defaultNativeTypeNum, attr.typeInfo(), type.attributeFormats[idx], style,
+                     type, &attr);
+    }
+    out.push_back(json ? '}' : ')');
+}
+
+void ObjectFormatter::_appendValue(std::string& out,
+                                   dpiData& data,
+                                   dpiNativeTypeNum nativeType,
+                                   const dpiDataTypeInfo& typeInfo,
+                                   const TemporalFormat& format,
+                                   Style style,
+                                   const TypeDescriptor& parent,
+                                   const OracleObjectAttr* attr) {
+    const bool json = style == Style::Json;
+    if (data.isNull) {
+        out.append(json ? "null" : "NULL");
+        return;
+    }
+
+    auto appendString = [&](std::string_view value) {
+        if (json) {
+            appendJsonString(out, value);
+        } else {
+            out.push_back('\'');
+            appendEscaped(out, value, 0);
+            out.push_back('\'');
+        }
+    };
+
+    switch (nativeType) {
+    case DPI_NATIVE_TYPE_INT64:
+        fmt::format_to(std::back_inserter(out), "{}", data.value.asInt64);
+        break;
+    case DPI_NATIVE_TYPE_UINT64:
+        fmt::format_to(std::back_inserter(out), "{}", data.value.asUint64);
+        break;
+    case DPI_NATIVE_TYPE_DOUBLE:
+        if (json) {
+            appendJsonNumber(out, data.value.asDouble);
+        } else {
+            fmt::format_to(std::back_inserter(out), "{}", data.value.asDouble);
+        }
+        break;
+    case DPI_NATIVE_TYPE_FLOAT:
+        if (json) {
+            appendJsonNumber(out, data.value.asFloat);
+        } else {
+            fmt::format_to(std::back_inserter(out), "{}", data.value.asFloat);
+        }
+        break;
+    case DPI_NATIVE_TYPE_BOOLEAN:
+        out.append(data.value.asBoolean ? (json ? "true" : "TRUE") : (json ? "false" : "FALSE"));
+        break;
+    case DPI_NATIVE_TYPE_BYTES: {
+        const std::string_view bytes(data.value.asBytes.ptr, data.value.asBytes.length);
+        if (typeInfo.oracleTypeNum == DPI_ORACLE_TYPE_RAW || typeInfo.oracleTypeNum == DPI_ORACLE_TYPE_LONG_RAW) {
+            out.push_back(json ? '"' : '\'');
+            appendHex(out, bytes);
+            out.push_back(json ? '"' : '\'');
+        } else {
+            appendString(bytes);
+        }
+        break;
+    }
+    case DPI_NATIVE_TYPE_TIMESTAMP: {
+        char buf[kMaxTimestampLength];
+        appendString(std::string_view(buf, formatTimestamp(buf, data.value.asTimestamp, format)));
+        break;
+    }
+    case DPI_NATIVE_TYPE_INTERVAL_DS: {
+        char buf[kMaxIntervalLength];
+        appendString(std::string_view(
+                    buf, formatIntervalDS(buf, data.value.asIntervalDS, format.fractionalDigits)));
+        break;
+    }
+    case DPI_NATIVE_TYPE_INTERVAL_YM: {
+        char buf[kMaxIntervalLength];
+        appendString(std::string_view(buf, formatIntervalYM(buf, data.value.asIntervalYM)));
+        break;
+    }
+    case DPI_NATIVE_TYPE_OBJECT: {
+        // Nested objects come back with a reference we're responsible for releasing.
+        auto nested = OracleObject::adopt(_ctx, data.value.asObject);
+        _appendObject(out, nested, _describe(typeInfo.objectType), style);
+        break;
+    }
+    default: {
+        // LOBs come back with a reference too, release it before giving up.
+        std::optional<OracleLob> lob;
+        if (nativeType == DPI_NATIVE_TYPE_LOB) {
+            lob = OracleLob::adopt(_ctx, data.value.asLOB);
+        }
+        auto typeOwner = std::string(parent.type.schema());
+        if (!typeOwner.empty()) {
+            typeOwner.push_back('.');
+        }
+        typeOwner.append(parent.type.name());
+        throw std::runtime_error(attr != nullptr
+            ? fmt::format("attribute {} of {} has type {}, which can't be rendered",
+                          attr->name(), typeOwner, typeName(typeInfo.oracleTypeNum))
+            : fmt::format("the elements of {} have type {}, which can't be rendered",
+                          typeOwner, typeName(typeInfo.oracleTypeNum)));
+    }
+    }
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "oracle_helpers.h"
+#include "value_format.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sqlplusplus {
+
+// Renders Oracle object and collection values recursively. The attribute list of every
+// object type is fetched the first time the type is seen and cached for the lifetime of
+// the formatter, so a formatter should live as long as the statement it's rendering.
+class ObjectFormatter {
+public:
+    enum class Style {
+        // SCHEMA.TYPE(1, 'text', NESTED_TYPE(...))
+        Display,
+        // {"ATTR":1,"OTHER":"text"} for objects and [1,2] for collections
+        Json,
+    };
+
+    ObjectFormatter(OracleContext* ctx, TemporalFormatSettings temporal = {});
+
+    // objType must be the type of obj, e.g. the objectType from the column's typeInfo.
+    void append(std::string& out, dpiObject* obj, dpiObjectType* objType, Style style);
+
+private:
+    struct TypeDescriptor {
+        explicit TypeDescriptor(OracleObjectType objType) : type(std::move(objType)) {}
+
+        OracleObjectType type;
+        std::vector<OracleObjectAttr> attributes;
+        std::vector<TemporalFormat> attributeFormats;
+        TemporalFormat elementFormat;
+    };
+
+    const TypeDescriptor& _describe(dpiObjectType* objType);
+    void _appendObject(std::string& out, const OracleObject& obj, const TypeDescriptor& type, Style style);
+    void _appendValue(std::string& out,
+                      dpiData& data,
+                      dpiNativeTypeNum nativeType,
+                      const dpiDataTypeInfo& typeInfo,
+                      const TemporalFormat& format,
+                      Style style,
+                      const TypeDescriptor& parent,
+                      const OracleObjectAttr* attr);
+
+    OracleContext* _ctx;
+    TemporalFormatSettings _temporal;
+    std::unordered_map<dpiObjectType*, std::unique_ptr<TypeDescriptor>> _types;
+};
+
+} // namespace sqlplusplus
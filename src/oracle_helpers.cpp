@@ -2,6 +2,7 @@
 #include "dpi.h"
 #include <stdexcept>
 #include <string_view>
+#include <utility>
 
 namespace sqlplusplus {
 
@@ -9,7 +10,11 @@ OracleException::OracleException(dpiErrorInfo info, std::string context)
     : std::runtime_error(std::string(info.message, info.messageLength)),
       _errorInfo(std::move(info)),
       _context(std::move(context))
-{}
+{
+    // The message points into ODPI's per-thread error buffer, which is overwritten by the
+    // next error on this thread, so point it at our own copy instead.
+    _errorInfo.message = what();
+}
 
 OracleException::OracleException(std::string context)
     : std::runtime_error(context),
@@ -24,25 +29,44 @@ const std::string& OracleException::context() const {
     return _context;
 }
 
+#if defined(__GNUC__) || defined(__clang__)
+#define SQLPP_COLD_NOINLINE __attribute__((noinline, cold))
+#elif defined(_MSC_VER)
+#define SQLPP_COLD_NOINLINE __declspec(noinline)
+#else
+#define SQLPP_COLD_NOINLINE
+#endif
+
 namespace {
-void checkErr(int rc, const dpiErrorInfo &errInfo, std::string context) {
-  if (rc == DPI_SUCCESS) {
-    return;
-  }
+// Contexts are plain literals and the throws live out of line, so a successful check is
+// just a compare and never allocates; these run for every fetch and every column value.
+[[noreturn]] SQLPP_COLD_NOINLINE void throwOracleError(const dpiErrorInfo& errInfo, const char* context) {
+    throw OracleException(errInfo, context);
+}
+
+[[noreturn]] SQLPP_COLD_NOINLINE void throwOracleError(const OracleContext* ctx, const char* context) {
+    throw OracleException(ctx->getLastError(), context);
+}
+
+[[noreturn]] SQLPP_COLD_NOINLINE void throwOracleError(const char* context) {
+    throw OracleException(context);
+}
 
-  throw OracleException(errInfo, std::move(context));
+inline void checkErr(int rc, const dpiErrorInfo& errInfo, const char* context) {
+    if (rc != DPI_SUCCESS) {
+        throwOracleError(errInfo, context);
+    }
 }
 
-void checkErr(int rc, const OracleContext *ctx, std::string context) {
-  if (rc == DPI_SUCCESS) {
-    return;
-  }
-  throw OracleException(ctx->getLastError(), std::move(context));
+inline void checkErr(int rc, const OracleContext* ctx, const char* context) {
+    if (rc != DPI_SUCCESS) {
+        throwOracleError(ctx, context);
+    }
 }
 
-void checkErr(bool ok, std::string context) {
+inline void checkErr(bool ok, const char* context) {
     if (!ok) {
-        throw OracleException(std::move(context));
+        throwOracleError(context);
     }
 }
 }
@@ -95,19 +119,649 @@ void OracleRowId::_initStrValue() {
     _strValue = std::string_view(strValue, strSize);
 }
 
+OracleObjectAttr::OracleObjectAttr(const OracleObjectAttr& other) :
+    _attr(other._attr),
+    _info(other._info)
+{
+    dpiObjectAttr_addRef(_attr);
+}
+
+OracleObjectAttr::OracleObjectAttr(OracleObjectAttr&& other) noexcept :
+    _attr(other._attr),
+    _info(other._info)
+{
+    other._attr = nullptr;
+}
+
+OracleObjectAttr& OracleObjectAttr::operator=(const OracleObjectAttr& other) {
+    if (_attr != nullptr) {
+        dpiObjectAttr_release(_attr);
+    }
+    _attr = other._attr;
+    _info = other._info;
+    dpiObjectAttr_addRef(_attr);
+    return *this;
+}
+
+OracleObjectAttr& OracleObjectAttr::operator=(OracleObjectAttr&& other) noexcept {
+    if (_attr != nullptr) {
+        dpiObjectAttr_release(_attr);
+        _attr = nullptr;
+    }
+    std::swap(_attr, other._attr);
+    _info = other._info;
+    return *this;
+}
+
+OracleObjectAttr::~OracleObjectAttr() {
+    if (_attr != nullptr) {
+        dpiObjectAttr_release(_attr);
+    }
+}
+
+OracleObjectType::OracleObjectType(OracleContext* ctx, dpiObjectType* objType) :
+    _ctx(ctx),
+    _objType(objType)
+{
+    dpiObjectType_addRef(_objType);
+    auto rc = dpiObjectType_getInfo(_objType, &_info);
+    if (rc != DPI_SUCCESS) {
+        dpiObjectType_release(_objType);
+    }
+    checkErr(rc, _ctx, "getting oracle object type info");
+}
+
+OracleObjectType::OracleObjectType(const OracleObjectType& other) :
+    _ctx(other._ctx),
+    _objType(other._objType),
+    _info(other._info)
+{
+    dpiObjectType_addRef(_objType);
+}
+
+OracleObjectType::OracleObjectType(OracleObjectType&& other) noexcept :
+    _ctx(other._ctx),
+    _objType(other._objType),
+    _info(other._info)
+{
+    other._objType = nullptr;
+}
+
+OracleObjectType& OracleObjectType::operator=(const OracleObjectType& other) {
+    if (_objType != nullptr) {
+        dpiObjectType_release(_objType);
+    }
+    _ctx = other._ctx;
+    _objType = other._objType;
+    _info = other._info;
+    dpiObjectType_addRef(_objType);
+    return *this;
+}
+
+OracleObjectType& OracleObjectType::operator=(OracleObjectType&& other) noexcept {
+    if (_objType != nullptr) {
+        dpiObjectType_release(_objType);
+        _objType = nullptr;
+    }
+    _ctx = other._ctx;
+    std::swap(_objType, other._objType);
+    _info = other._info;
+    return *this;
+}
+
+OracleObjectType::~OracleObjectType() {
+    if (_objType != nullptr) {
+        dpiObjectType_release(_objType);
+    }
+}
+
+std::vector<OracleObjectAttr> OracleObjectType::attributes() const {
+    std::vector<dpiObjectAttr*> handles(_info.numAttributes);
+    auto rc = dpiObjectType_getAttributes(_objType, _info.numAttributes, handles.data());
+    checkErr(rc, _ctx, "getting attributes of oracle object type");
+
+    std::vector<OracleObjectAttr> attrs;
+    attrs.reserve(handles.size());
+    for (size_t idx = 0; idx < handles.size(); ++idx) {
+        dpiObjectAttrInfo info;
+        rc = dpiObjectAttr_getInfo(handles[idx], &info);
+        if (rc != DPI_SUCCESS) {
+            for (auto remaining = idx; remaining < handles.size(); ++remaining) {
+                dpiObjectAttr_release(handles[remaining]);
+            }
+        }
+        checkErr(rc, _ctx, "getting info for oracle object attribute");
+        attrs.push_back(OracleObjectAttr(handles[idx], info));
+    }
+    return attrs;
+}
+
+OracleObject OracleObjectType::createObject() const {
+    dpiObject* obj = nullptr;
+    auto rc = dpiObjectType_createObject(_objType, &obj);
+    checkErr(rc, _ctx, "creating oracle object");
+    return OracleObject::adopt(_ctx, obj);
+}
+
+OracleObject::OracleObject(OracleContext* ctx, dpiObject* obj) :
+    _ctx(ctx),
+    _obj(obj)
+{
+    dpiObject_addRef(_obj);
+}
+
+OracleObject::OracleObject(const OracleObject& other) :
+    _ctx(other._ctx),
+    _obj(other._obj)
+{
+    dpiObject_addRef(_obj);
+}
+
+OracleObject::OracleObject(OracleObject&& other) noexcept :
+    _ctx(other._ctx),
+    _obj(other._obj)
+{
+    other._obj = nullptr;
+}
+
+OracleObject& OracleObject::operator=(const OracleObject& other) {
+    if (_obj != nullptr) {
+        dpiObject_release(_obj);
+    }
+    _ctx = other._ctx;
+    _obj = other._obj;
+    dpiObject_addRef(_obj);
+    return *this;
+}
+
+OracleObject& OracleObject::operator=(OracleObject&& other) noexcept {
+    if (_obj != nullptr) {
+        dpiObject_release(_obj);
+        _obj = nullptr;
+    }
+    _ctx = other._ctx;
+    std::swap(_obj, other._obj);
+    return *this;
+}
+
+OracleObject::~OracleObject() {
+    if (_obj != nullptr) {
+        dpiObject_release(_obj);
+    }
+}
+
+OracleObject OracleObject::adopt(OracleContext* ctx, dpiObject* obj) {
+    return OracleObject(ctx, obj, AdoptTag{});
+}
+
+void OracleObject::getAttributeValue(const OracleObjectAttr& attr, dpiData& out) const {
+    auto rc = dpiObject_getAttributeValue(_obj, attr, attr.typeInfo().defaultNativeTypeNum, &out);
+    checkErr(rc, _ctx, "getting attribute value of oracle object");
+}
+
+int32_t OracleObject::size() const {
+    int32_t size = 0;
+    auto rc = dpiObject_getSize(_obj, &size);
+    checkErr(rc, _ctx, "getting size of oracle collection");
+    return size;
+}
+
+bool OracleObject::firstIndex(int32_t& index) const {
+    int exists = 0;
+    auto rc = dpiObject_getFirstIndex(_obj, &index, &exists);
+    checkErr(rc, _ctx, "getting first index of oracle collection");
+    return exists != 0;
+}
+
+bool OracleObject::nextIndex(int32_t index, int32_t& next) const {
+    int exists = 0;
+    auto rc = dpiObject_getNextIndex(_obj, index, &next, &exists);
+    checkErr(rc, _ctx, "getting next index of oracle collection");
+    return exists != 0;
+}
+
+void OracleObject::getElementValue(int32_t index, dpiNativeTypeNum nativeType, dpiData& out) const {
+    auto rc = dpiObject_getElementValueByIndex(_obj, index, nativeType, &out);
+    checkErr(rc, _ctx, "getting element of oracle collection");
+}
+
+void OracleObject::appendElement(dpiNativeTypeNum nativeType, dpiData& value) {
+    auto rc = dpiObject_appendElement(_obj, nativeType, &value);
+    checkErr(rc, _ctx, "appending element to oracle collection");
+}
+
+OracleLob::OracleLob(OracleContext* ctx, dpiLob* lob) :
+    _ctx(ctx),
+    _lob(lob)
+{
+    dpiLob_addRef(_lob);
+}
+
+OracleLob::OracleLob(const OracleLob& other) :
+    _ctx(other._ctx),
+    _lob(other._lob)
+{
+    dpiLob_addRef(_lob);
+}
+
+OracleLob::OracleLob(OracleLob&& other) noexcept :
+    _ctx(other._ctx),
+    _lob(other._lob)
+{
+    other._lob = nullptr;
+}
+
+OracleLob& OracleLob::operator=(const OracleLob& other) {
+    if (_lob != nullptr) {
+        dpiLob_release(_lob);
+    }
+    _ctx = other._ctx;
+    _lob = other._lob;
+    dpiLob_addRef(_lob);
+    return *this;
+}
+
+OracleLob& OracleLob::operator=(OracleLob&& other) noexcept {
+    if (_lob != nullptr) {
+        dpiLob_release(_lob);
+        _lob = nullptr;
+    }
+    _ctx = other._ctx;
+    std::swap(_lob, other._lob);
+    return *this;
+}
+
+OracleLob::~OracleLob() {
+    if (_lob != nullptr) {
+        dpiLob_release(_lob);
+    }
+}
+
+OracleLob OracleLob::adopt(OracleContext* ctx, dpiLob* lob) {
+    return OracleLob(ctx, lob, AdoptTag{});
+}
+
+uint32_t OracleLob::chunkSize() const {
+    uint32_t size = 0;
+    auto rc = dpiLob_getChunkSize(_lob, &size);
+    checkErr(rc, _ctx, "error getting chunk size of oracle lob");
+    return size;
+}
+
+uint64_t OracleLob::size() const {
+    uint64_t size = 0;
+    auto rc = dpiLob_getSize(_lob, &size);
+    checkErr(rc, _ctx, "error getting size of oracle lob");
+    return size;
+}
+
+void OracleLob::trim(uint64_t newSize) {
+    auto rc = dpiLob_trim(_lob, newSize);
+    checkErr(rc, _ctx, "error trimming oracle lob");
+}
+
+void OracleLob::writeBytes(uint64_t offset, std::string_view bytes) {
+    auto rc = dpiLob_writeBytes(_lob, offset, bytes.data(), bytes.size());
+    checkErr(rc, _ctx, "error writing to oracle lob");
+}
+
+void OracleLob::openResource() {
+    auto rc = dpiLob_openResource(_lob);
+    checkErr(rc, _ctx, "error opening oracle lob");
+}
+
+void OracleLob::closeResource() {
+    auto rc = dpiLob_closeResource(_lob);
+    checkErr(rc, _ctx, "error closing oracle lob");
+}
+
+OracleJson::OracleJson(OracleContext* ctx, dpiJson* json) :
+    _ctx(ctx),
+    _json(json)
+{
+    dpiJson_addRef(_json);
+}
+
+OracleJson::OracleJson(const OracleJson& other) :
+    _ctx(other._ctx),
+    _json(other._json)
+{
+    dpiJson_addRef(_json);
+}
+
+OracleJson::OracleJson(OracleJson&& other) noexcept :
+    _ctx(other._ctx),
+    _json(other._json)
+{
+    other._json = nullptr;
+}
+
+OracleJson& OracleJson::operator=(const OracleJson& other) {
+    if (_json != nullptr) {
+        dpiJson_release(_json);
+    }
+    _ctx = other._ctx;
+    _json = other._json;
+    dpiJson_addRef(_json);
+    return *this;
+}
+
+OracleJson& OracleJson::operator=(OracleJson&& other) noexcept {
+    if (_json != nullptr) {
+        dpiJson_release(_json);
+        _json = nullptr;
+    }
+    _ctx = other._ctx;
+    std::swap(_json, other._json);
+    return *this;
+}
+
+OracleJson::~OracleJson() {
+    if (_json != nullptr) {
+        dpiJson_release(_json);
+    }
+}
+
+const dpiJsonNode& OracleJson::value(uint32_t options) const {
+    dpiJsonNode* topNode = nullptr;
+    auto rc = dpiJson_getValue(_json, options, &topNode);
+    checkErr(rc, _ctx, "error decoding oracle json value");
+    return *topNode;
+}
+
+OracleSodaDocument::OracleSodaDocument(const OracleSodaDocument& other) :
+    _ctx(other._ctx),
+    _doc(other._doc)
+{
+    dpiSodaDoc_addRef(_doc);
+}
+
+OracleSodaDocument::OracleSodaDocument(OracleSodaDocument&& other) noexcept :
+    _ctx(other._ctx),
+    _doc(other._doc)
+{
+    other._doc = nullptr;
+}
+
+OracleSodaDocument& OracleSodaDocument::operator=(const OracleSodaDocument& other) {
+    if (_doc != nullptr) {
+        dpiSodaDoc_release(_doc);
+    }
+    _ctx = other._ctx;
+    _doc = other._doc;
+    dpiSodaDoc_addRef(_doc);
+    return *this;
+}
+
+OracleSodaDocument& OracleSodaDocument::operator=(OracleSodaDocument&& other) noexcept {
+    if (_doc != nullptr) {
+        dpiSodaDoc_release(_doc);
+        _doc = nullptr;
+    }
+    _ctx = other._ctx;
+    std::swap(_doc, other._doc);
+    return *this;
+}
+
+OracleSodaDocument::~OracleSodaDocument() {
+    if (_doc != nullptr) {
+        dpiSodaDoc_release(_doc);
+    }
+}
+
+std::string_view OracleSodaDocument::key() const {
+    const char* key = nullptr;
+    uint32_t keyLength = 0;
+    auto rc = dpiSodaDoc_getKey(_doc, &key, &keyLength);
+    checkErr(rc, _ctx, "error getting soda document key");
+    return std::string_view(key, keyLength);
+}
+
+std::string_view OracleSodaDocument::content() const {
+    const char* content = nullptr;
+    uint32_t contentLength = 0;
+    const char* encoding = nullptr;
+    auto rc = dpiSodaDoc_getContent(_doc, &content, &contentLength, &encoding);
+    checkErr(rc, _ctx, "error getting soda document content");
+    return std::string_view(content, contentLength);
+}
+
+OracleSodaDocCursor::OracleSodaDocCursor(const OracleSodaDocCursor& other) :
+    _ctx(other._ctx),
+    _cursor(other._cursor)
+{
+    dpiSodaDocCursor_addRef(_cursor);
+}
+
+OracleSodaDocCursor::OracleSodaDocCursor(OracleSodaDocCursor&& other) noexcept :
+    _ctx(other._ctx),
+    _cursor(other._cursor)
+{
+    other._cursor = nullptr;
+}
+
+OracleSodaDocCursor& OracleSodaDocCursor::operator=(const OracleSodaDocCursor& other) {
+    if (_cursor != nullptr) {
+        dpiSodaDocCursor_release(_cursor);
+    }
+    _ctx = other._ctx;
+    _cursor = other._cursor;
+    dpiSodaDocCursor_addRef(_cursor);
+    return *this;
+}
+
+OracleSodaDocCursor& OracleSodaDocCursor::operator=(OracleSodaDocCursor&& other) noexcept {
+    if (_cursor != nullptr) {
+        dpiSodaDocCursor_release(_cursor);
+        _cursor = nullptr;
+    }
+    _ctx = other._ctx;
+    std::swap(_cursor, other._cursor);
+    return *this;
+}
+
+OracleSodaDocCursor::~OracleSodaDocCursor() {
+    if (_cursor != nullptr) {
+        dpiSodaDocCursor_release(_cursor);
+    }
+}
+
+std::optional<OracleSodaDocument> OracleSodaDocCursor::next() {
+    dpiSodaDoc* doc = nullptr;
+    auto rc = dpiSodaDocCursor_getNext(_cursor, DPI_SODA_FLAGS_DEFAULT, &doc);
+    checkErr(rc, _ctx, "error fetching next soda document");
+    if (doc == nullptr) {
+        return std::nullopt;
+    }
+    return OracleSodaDocument(_ctx, doc);
+}
+
+OracleSodaCollection::OracleSodaCollection(const OracleSodaCollection& other) :
+    _ctx(other._ctx),
+    _coll(other._coll)
+{
+    dpiSodaColl_addRef(_coll);
+}
+
+OracleSodaCollection::OracleSodaCollection(OracleSodaCollection&& other) noexcept :
+    _ctx(other._ctx),
+    _coll(other._coll)
+{
+    other._coll = nullptr;
+}
+
+OracleSodaCollection& OracleSodaCollection::operator=(const OracleSodaCollection& other) {
+    if (_coll != nullptr) {
+        dpiSodaColl_release(_coll);
+    }
+    _ctx = other._ctx;
+    _coll = other._coll;
+    dpiSodaColl_addRef(_coll);
+    return *this;
+}
+
+OracleSodaCollection& OracleSodaCollection::operator=(OracleSodaCollection&& other) noexcept {
+    if (_coll != nullptr) {
+        dpiSodaColl_release(_coll);
+        _coll = nullptr;
+    }
+    _ctx = other._ctx;
+    std::swap(_coll, other._coll);
+    return *this;
+}
+
+OracleSodaCollection::~OracleSodaCollection() {
+    if (_coll != nullptr) {
+        dpiSodaColl_release(_coll);
+    }
+}
+
+dpiSodaOperOptions OracleSodaCollection::_operOptions(std::string_view filter) const {
+    dpiSodaOperOptions options;
+    auto rc = dpiContext_initSodaOperOptions(_ctx->get(), &options);
+    checkErr(rc, _ctx, "error initializing soda operation options");
+    if (!filter.empty()) {
+        options.filter = filter.data();
+        options.filterLength = filter.size();
+    }
+    return options;
+}
+
+OracleSodaDocCursor OracleSodaCollection::find(const FindOpts& opts) {
+    auto options = _operOptions(opts.filter);
+    options.limit = opts.limit;
+    options.fetchArraySize = opts.fetchArraySize;
+
+    dpiSodaDocCursor* cursor = nullptr;
+    auto rc = dpiSodaColl_find(_coll, &options, DPI_SODA_FLAGS_DEFAULT, &cursor);
+    checkErr(rc, _ctx, "error finding soda documents");
+    return OracleSodaDocCursor(_ctx, cursor);
+}
+
+uint64_t OracleSodaCollection::count(std::string_view filter) {
+    auto options = _operOptions(filter);
+    uint64_t count = 0;
+    auto rc = dpiSodaColl_getDocCount(_coll, &options, DPI_SODA_FLAGS_DEFAULT, &count);
+    checkErr(rc, _ctx, "error counting soda documents");
+    return count;
+}
+
+void OracleSodaCollection::insertMany(const std::vector<OracleSodaDocument>& docs, bool atomicCommit) {
+    if (docs.empty()) {
+        return;
+    }
+
+    std::vector<dpiSodaDoc*> handles;
+    handles.reserve(docs.size());
+    for (const auto& doc : docs) {
+        handles.push_back(doc.get());
+    }
+
+    auto rc = dpiSodaColl_insertMany(_coll,
+                                     static_cast<uint32_t>(handles.size()),
+                                     handles.data(),
+                                     atomicCommit ? DPI_SODA_FLAGS_ATOMIC_COMMIT : DPI_SODA_FLAGS_DEFAULT,
+                                     nullptr);
+    checkErr(rc, _ctx, "error inserting soda documents");
+}
+
+OracleSodaDatabase::OracleSodaDatabase(const OracleSodaDatabase& other) :
+    _ctx(other._ctx),
+    _db(other._db)
+{
+    dpiSodaDb_addRef(_db);
+}
+
+OracleSodaDatabase::OracleSodaDatabase(OracleSodaDatabase&& other) noexcept :
+    _ctx(other._ctx),
+    _db(other._db)
+{
+    other._db = nullptr;
+}
+
+OracleSodaDatabase& OracleSodaDatabase::operator=(const OracleSodaDatabase& other) {
+    if (_db != nullptr) {
+        dpiSodaDb_release(_db);
+    }
+    _ctx = other._ctx;
+    _db = other._db;
+    dpiSodaDb_addRef(_db);
+    return *this;
+}
+
+OracleSodaDatabase& OracleSodaDatabase::operator=(OracleSodaDatabase&& other) noexcept {
+    if (_db != nullptr) {
+        dpiSodaDb_release(_db);
+        _db = nullptr;
+    }
+    _ctx = other._ctx;
+    std::swap(_db, other._db);
+    return *this;
+}
+
+OracleSodaDatabase::~OracleSodaDatabase() {
+    if (_db != nullptr) {
+        dpiSodaDb_release(_db);
+    }
+}
+
+std::vector<std::string> OracleSodaDatabase::collectionNames() {
+    dpiSodaCollNames names;
+    auto rc = dpiSodaDb_getCollectionNames(_db, nullptr, 0, 0, DPI_SODA_FLAGS_DEFAULT, &names);
+    checkErr(rc, _ctx, "error listing soda collections");
+
+    std::vector<std::string> ret;
+    ret.reserve(names.numNames);
+    for (uint32_t idx = 0; idx < names.numNames; ++idx) {
+        ret.emplace_back(names.names[idx], names.nameLengths[idx]);
+    }
+    dpiSodaDb_freeCollectionNames(_db, &names);
+    return ret;
+}
+
+OracleSodaCollection OracleSodaDatabase::openCollection(std::string_view name, bool create) {
+    dpiSodaColl* coll = nullptr;
+    int rc;
+    if (create) {
+        rc = dpiSodaDb_createCollection(_db, name.data(), name.size(), nullptr, 0, DPI_SODA_FLAGS_DEFAULT, &coll);
+    } else {
+        rc = dpiSodaDb_openCollection(_db, name.data(), name.size(), DPI_SODA_FLAGS_DEFAULT, &coll);
+    }
+    checkErr(rc, _ctx, "error opening soda collection");
+    if (coll == nullptr) {
+        throw OracleException("soda collection " + std::string(name) + " does not exist");
+    }
+    return OracleSodaCollection(_ctx, coll);
+}
+
+OracleSodaDocument OracleSodaDatabase::createDocument(std::string_view content) {
+    dpiSodaDoc* doc = nullptr;
+    auto rc = dpiSodaDb_createDocument(
+            _db, nullptr, 0, content.data(), content.size(), nullptr, 0, DPI_SODA_FLAGS_DEFAULT, &doc);
+    checkErr(rc, _ctx, "error creating soda document");
+    return OracleSodaDocument(_ctx, doc);
+}
 
 OracleVariable::OracleVariable(const OracleVariable& other) :
     _ctx(other._ctx),
-    _var(other._var)
+    _nativeType(other._nativeType),
+    _var(other._var),
+    _data(other._data),
+    _maxArraySize(other._maxArraySize)
 {
     dpiVar_addRef(_var);
 }
 
 OracleVariable::OracleVariable(OracleVariable&& other) noexcept :
     _ctx(other._ctx),
-    _var(other._var)
+    _nativeType(other._nativeType),
+    _var(other._var),
+    _data(other._data),
+    _maxArraySize(other._maxArraySize)
 {
     other._var = nullptr;
+    other._data = nullptr;
+    other._maxArraySize = 0;
 }
 
 OracleVariable& OracleVariable::operator=(const OracleVariable& other) {
@@ -115,7 +769,10 @@ OracleVariable& OracleVariable::operator=(const OracleVariable& other) {
         dpiVar_release(_var);
     }
     _ctx = other._ctx;
+    _nativeType = other._nativeType;
     _var = other._var;
+    _data = other._data;
+    _maxArraySize = other._maxArraySize;
     dpiVar_addRef(_var);
     return *this;
 }
@@ -126,7 +783,10 @@ OracleVariable& OracleVariable::operator=(OracleVariable&& other) noexcept {
         _var = nullptr;
     }
     _ctx = other._ctx;
+    _nativeType = other._nativeType;
     std::swap(_var, other._var);
+    _data = std::exchange(other._data, nullptr);
+    _maxArraySize = std::exchange(other._maxArraySize, 0);
     return *this;
 }
 
@@ -162,6 +822,53 @@ void OracleVariable::setFrom(uint32_t pos, const OracleRowId& rowid) {
     checkErr(rc, _ctx, "copying from row id to variable");
 }
 
+void OracleVariable::setFrom(uint32_t pos, const OracleObject& obj) {
+    auto rc = dpiVar_setFromObject(_var, pos, obj.get());
+    checkErr(rc, _ctx, "copying from object to variable");
+}
+
+dpiData* OracleVariable::_element(uint32_t pos, dpiNativeTypeNum nativeType) const {
+    checkErr(_nativeType == nativeType, "oracle variable does not hold values of this type");
+    checkErr(pos < _maxArraySize, "position is out of range for oracle variable");
+    return &_data[pos];
+}
+
+void OracleVariable::setInt64(uint32_t pos, int64_t value) {
+    dpiData_setInt64(_element(pos, DPI_NATIVE_TYPE_INT64), value);
+}
+
+void OracleVariable::setDouble(uint32_t pos, double value) {
+    dpiData_setDouble(_element(pos, DPI_NATIVE_TYPE_DOUBLE), value);
+}
+
+void OracleVariable::setTimestamp(uint32_t pos, const dpiTimestamp& value) {
+    dpiData_setTimestamp(_element(pos, DPI_NATIVE_TYPE_TIMESTAMP),
+                         value.year,
+                         value.month,
+                         value.day,
+                         value.hour,
+                         value.minute,
+                         value.second,
+                         value.fsecond,
+                         value.tzHourOffset,
+                         value.tzMinuteOffset);
+}
+
+void OracleVariable::setNull(uint32_t pos) {
+    checkErr(pos < _maxArraySize, "position is out of range for oracle variable");
+    dpiData_setNull(&_data[pos]);
+}
+
+void OracleVariable::setNumElements(uint32_t numElements) {
+    auto rc = dpiVar_setNumElementsInArray(_var, numElements);
+    checkErr(rc, _ctx, "setting number of elements in oracle variable");
+}
+
+OracleData OracleVariable::element(uint32_t pos) const {
+    checkErr(pos < _maxArraySize, "position is out of range for oracle variable");
+    return OracleData(_nativeType, &_data[pos]);
+}
+
 uint32_t OracleVariable::numElements() const {
     uint32_t res = 0;
     auto rc = dpiVar_getNumElementsInArray(_var, &res);
@@ -192,20 +899,20 @@ std::vector<OracleData> OracleVariable::returnedData(uint32_t pos) const {
     return ret;
 }
 
-const std::vector<OracleData>& OracleVariable::allocatedData() const {
-    return _allocatedData;
-}
-
+// Copies start out owned by the same thread but are claimed separately.
 OracleConnection::OracleConnection(const OracleConnection& other) :
     _ctx(other._ctx),
-    _conn(other._conn)
+    _conn(other._conn),
+    _owner(std::make_shared<OracleConnectionOwner>())
 {
+    _owner->thread.store(other._owner->thread.load(std::memory_order_relaxed), std::memory_order_relaxed);
     dpiConn_addRef(_conn);
 }
 
 OracleConnection::OracleConnection(OracleConnection&& other) noexcept :
     _ctx(other._ctx),
-    _conn(other._conn)
+    _conn(other._conn),
+    _owner(std::move(other._owner))
 {
     other._conn = nullptr;
     other._ctx = nullptr;
@@ -217,6 +924,8 @@ OracleConnection& OracleConnection::operator=(const OracleConnection& other) {
     }
     _ctx = other._ctx;
     _conn = other._conn;
+    _owner = std::make_shared<OracleConnectionOwner>();
+    _owner->thread.store(other._owner->thread.load(std::memory_order_relaxed), std::memory_order_relaxed);
     dpiConn_addRef(_conn);
     return *this;
 }
@@ -229,6 +938,7 @@ OracleConnection& OracleConnection::operator=(OracleConnection&& other) noexcept
     _ctx = nullptr;
     std::swap(_ctx, other._ctx);
     std::swap(_conn, other._conn);
+    std::swap(_owner, other._owner);
     return *this;
 }
 
@@ -238,31 +948,16 @@ OracleConnection::~OracleConnection() {
     }
 }
 
-OracleStatement::OracleStatement(const OracleStatement& other) :
-    _ctx(other._ctx),
-    _statement(other._statement)
-{
-    dpiStmt_addRef(_statement);
-}
-
 OracleStatement::OracleStatement(OracleStatement&& other) noexcept :
     _ctx(other._ctx),
-    _statement(other._statement)
+    _statement(other._statement),
+    _owner(std::move(other._owner)),
+    _columns(std::move(other._columns))
 {
     other._statement = nullptr;
     other._ctx = nullptr;
 }
 
-OracleStatement& OracleStatement::operator=(const OracleStatement& other) {
-    if (_statement != nullptr) {
-        dpiStmt_release(_statement);
-    }
-    _ctx = other._ctx;
-    _statement = other._statement;
-    dpiStmt_addRef(_statement);
-    return *this;
-}
-
 OracleStatement& OracleStatement::operator=(OracleStatement&& other) noexcept {
     if (_statement != nullptr) {
         dpiStmt_release(_statement);
@@ -271,6 +966,8 @@ OracleStatement& OracleStatement::operator=(OracleStatement&& other) noexcept {
     _ctx = nullptr;
     std::swap(_ctx, other._ctx);
     std::swap(_statement, other._statement);
+    std::swap(_owner, other._owner);
+    _columns = std::move(other._columns);
     return *this;
 }
 
@@ -294,16 +991,33 @@ std::unique_ptr<OracleContext> OracleContext::make() {
     return std::make_unique<OracleContext>(ctx);
 }
 
+dpiCommonCreateParams OracleContext::commonCreateParams() const {
+    dpiCommonCreateParams params;
+    auto rc = dpiContext_initCommonCreateParams(_ctx, &params);
+    checkErr(rc, this, "error initializing oracle create parameters");
+    params.createMode = static_cast<dpiCreateMode>(params.createMode | DPI_MODE_CREATE_THREADED);
+    return params;
+}
+
 OracleContext::~OracleContext() {
     if(dpiContext_destroy(_ctx) != DPI_SUCCESS) {
         std::abort();
     }
 }
 
-OracleConnectionPool OracleConnectionPool::make(
-        OracleContext* ctx, const OracleConnectionOptions& opts) {
+OracleConnectionPool OracleConnectionPool::make(OracleContext* ctx,
+                                                const OracleConnectionOptions& opts,
+                                                const OracleConnectionPoolOptions& poolOpts) {
     dpiPool* pool;
-    auto rc = dpiPool_create(
+    auto commonParams = ctx->commonCreateParams();
+    dpiPoolCreateParams poolParams;
+    auto rc = dpiContext_initPoolCreateParams(ctx->get(), &poolParams);
+    checkErr(rc, ctx, "error initializing oracle pool create parameters");
+    poolParams.minSessions = poolOpts.minSessions;
+    poolParams.maxSessions = poolOpts.maxSessions;
+    poolParams.sessionIncrement = poolOpts.sessionIncrement;
+    poolParams.getMode = DPI_MODE_POOL_GET_WAIT;
+    rc = dpiPool_create(
             ctx->get(),
             opts.username.c_str(),
             opts.username.size(),
@@ -311,11 +1025,17 @@ OracleConnectionPool OracleConnectionPool::make(
             opts.password.size(),
             opts.connString.c_str(),
             opts.connString.size(),
-            nullptr,
-            nullptr,
+            &commonParams,
+            &poolParams,
             &pool);
     checkErr(rc, ctx, "error creating oracle connection pool");
-    return OracleConnectionPool(ctx, pool);
+    return OracleConnectionPool(ctx, pool, poolOpts.maxSessions);
+}
+
+OracleConnectionPool::~OracleConnectionPool() {
+    if (_pool != nullptr) {
+        dpiPool_release(_pool);
+    }
 }
 
 OracleConnection OracleConnectionPool::acquireConnection() {
@@ -328,6 +1048,7 @@ OracleConnection OracleConnectionPool::acquireConnection() {
 
 OracleConnection OracleConnection::make(OracleContext *ctx, const OracleConnectionOptions &opts) {
     dpiConn* conn;
+    auto commonParams = ctx->commonCreateParams();
     auto rc = dpiConn_create(
             ctx->get(),
             opts.username.c_str(),
@@ -336,7 +1057,7 @@ OracleConnection OracleConnection::make(OracleContext *ctx, const OracleConnecti
             opts.password.size(),
             opts.connString.c_str(),
             opts.connString.size(),
-            nullptr,
+            &commonParams,
             nullptr,
             &conn);
 
@@ -345,15 +1066,42 @@ OracleConnection OracleConnection::make(OracleContext *ctx, const OracleConnecti
     return OracleConnection(ctx, conn);
 }
 
+void OracleConnectionOwner::check() const {
+    checkErr(thread.load(std::memory_order_relaxed) == std::this_thread::get_id(),
+             "oracle connection used by a thread that does not own it");
+}
+
 OracleStatement OracleConnection::prepareStatement(std::string_view sql) {
+    _checkOwner();
     dpiStmt* stmt = nullptr;
     int rc = dpiConn_prepareStmt(_conn, 0, sql.data(), sql.size(), nullptr, 0, &stmt);
     checkErr(rc, _ctx, "error preparing oracle statement");
 
-    return OracleStatement(_ctx, stmt);
+    return OracleStatement(_ctx, stmt, _owner);
+}
+
+OracleObjectType OracleConnection::getObjectType(std::string_view name) {
+    _checkOwner();
+    dpiObjectType* objType = nullptr;
+    auto rc = dpiConn_getObjectType(_conn, name.data(), name.size(), &objType);
+    checkErr(rc, _ctx, "error looking up oracle object type");
+
+    // The wrapper takes its own reference, so drop the one returned to us.
+    OracleObjectType ret(_ctx, objType);
+    dpiObjectType_release(objType);
+    return ret;
+}
+
+OracleSodaDatabase OracleConnection::sodaDatabase() {
+    _checkOwner();
+    dpiSodaDb* db = nullptr;
+    auto rc = dpiConn_getSodaDb(_conn, &db);
+    checkErr(rc, _ctx, "error getting soda database");
+    return OracleSodaDatabase(_ctx, db);
 }
 
 OracleVariable OracleConnection::newArrayVariable(VariableOpts opts) {
+    _checkOwner();
     dpiObjectType* objType = nullptr;
     uint32_t size = 0;
     uint32_t sizeIsBytes = 0;
@@ -379,26 +1127,50 @@ OracleVariable OracleConnection::newArrayVariable(VariableOpts opts) {
             &var,
             &data);
     checkErr(rc, _ctx, "error creating oracle varaible");
-    std::vector<OracleData> dataVec;
-    dataVec.reserve(opts.maxArraySize);
-    for (uint32_t idx = 0; idx < opts.maxArraySize; idx++) {
-        dataVec.emplace_back(opts.nativeTypeNum, &data[idx]);
-    }
-   
-    return OracleVariable(_ctx, opts.nativeTypeNum, var, std::move(dataVec));
+    return OracleVariable(_ctx, opts.nativeTypeNum, var, data, opts.maxArraySize);
 }
 
 void OracleStatement::execute() {
-    int rc = dpiStmt_execute(_statement, DPI_MODE_EXEC_DEFAULT, nullptr);
+    _checkOwner();
+    uint32_t numQueryColumns = 0;
+    int rc = dpiStmt_execute(_statement, DPI_MODE_EXEC_DEFAULT, &numQueryColumns);
     checkErr(rc, _ctx, "error executing oracle statement");
+
+    _columns.clear();
+    _columns.reserve(numQueryColumns);
+    for (uint32_t pos = 1; pos <= numQueryColumns; ++pos) {
+        dpiQueryInfo info;
+        rc = dpiStmt_getQueryInfo(_statement, pos, &info);
+        checkErr(rc, _ctx, "error getting column info from oracle results");
+        _columns.push_back(OracleColumnInfo{info});
+    }
+}
+
+void OracleConnection::breakExecution() {
+    auto rc = dpiConn_breakExecution(_conn);
+    checkErr(rc, _ctx, "error interrupting oracle connection");
 }
 
 void OracleConnection::commit() {
+    _checkOwner();
     auto rc = dpiConn_commit(_conn);
     checkErr(rc, _ctx, "error committing changes");
 }
 
+void OracleConnection::rollback() {
+    _checkOwner();
+    auto rc = dpiConn_rollback(_conn);
+    checkErr(rc, _ctx, "error rolling back changes");
+}
+
+bool OracleConnection::transactionInProgress() {
+    auto stmt = prepareStatement("select dbms_transaction.local_transaction_id from dual");
+    stmt.execute();
+    return stmt.fetch() && !stmt.getColumnValue(1).isNull();
+}
+
 bool OracleStatement::fetch() {
+    _checkOwner();
     int found = 0;
     uint32_t bufferRowIndex;
     auto rc = dpiStmt_fetch(_statement, &found, &bufferRowIndex);
@@ -406,18 +1178,59 @@ bool OracleStatement::fetch() {
     return found != 0;
 }
 
-uint32_t OracleStatement::numColumns() const {
-    uint32_t numColumns;
-    auto rc = dpiStmt_getNumQueryColumns(_statement, &numColumns);
-    checkErr(rc, _ctx, "error getting column count from Oracle results");
-    return numColumns;
+void OracleStatement::setFetchArraySize(uint32_t arraySize) {
+    _checkOwner();
+    auto rc = dpiStmt_setFetchArraySize(_statement, arraySize);
+    checkErr(rc, _ctx, "error setting fetch array size of oracle statement");
 }
 
-OracleColumnInfo OracleStatement::getColumnInfo(uint32_t pos) const {
-    dpiQueryInfo info;
-    int rc = dpiStmt_getQueryInfo(_statement, pos, &info);
-    checkErr(rc, _ctx, "error getting column info from oracle results");
-    return OracleColumnInfo{std::move(info)};
+void OracleStatement::executeMany(uint32_t numIters, bool batchErrors) {
+    _checkOwner();
+    const dpiExecMode mode = batchErrors ? DPI_MODE_EXEC_BATCH_ERRORS : DPI_MODE_EXEC_DEFAULT;
+    auto rc = dpiStmt_executeMany(_statement, mode, numIters);
+    checkErr(rc, _ctx, "error executing oracle statement");
+    _columns.clear();
+}
+
+std::vector<OracleException> OracleStatement::batchErrors() const {
+    _checkOwner();
+    uint32_t count;
+    auto rc = dpiStmt_getBatchErrorCount(_statement, &count);
+    checkErr(rc, _ctx, "error getting batch error count of oracle statement");
+
+    std::vector<dpiErrorInfo> infos(count);
+    rc = dpiStmt_getBatchErrors(_statement, count, infos.data());
+    checkErr(rc, _ctx, "error getting batch errors of oracle statement");
+
+    std::vector<OracleException> errors;
+    errors.reserve(count);
+    for (const auto& info : infos) {
+        errors.emplace_back(info, "executing batch");
+    }
+    return errors;
+}
+
+uint64_t OracleStatement::rowCount() const {
+    _checkOwner();
+    uint64_t count;
+    auto rc = dpiStmt_getRowCount(_statement, &count);
+    checkErr(rc, _ctx, "error getting row count of oracle statement");
+    return count;
+}
+
+void OracleStatement::defineValue(uint32_t pos,
+                                  dpiOracleTypeNum oracleType,
+                                  dpiNativeTypeNum nativeType,
+                                  uint32_t size,
+                                  bool sizeIsBytes) {
+    _checkOwner();
+    auto rc = dpiStmt_defineValue(_statement, pos, oracleType, nativeType, size, sizeIsBytes, nullptr);
+    checkErr(rc, _ctx, "error defining column type of oracle statement");
+}
+
+const OracleColumnInfo& OracleStatement::getColumnInfo(uint32_t pos) const {
+    checkErr(pos >= 1 && pos <= _columns.size(), "column position is out of range for oracle statement");
+    return _columns[pos - 1];
 }
 
 OracleData OracleStatement::getColumnValue(uint32_t pos) const {
@@ -429,10 +1242,36 @@ OracleData OracleStatement::getColumnValue(uint32_t pos) const {
 }
 
 void OracleStatement::bindByPos(uint32_t pos, const OracleVariable &var) {
+    _checkOwner();
     int rc = dpiStmt_bindByPos(_statement, pos, var._var);
     checkErr(rc, _ctx, "binding variable to statement by pos");
 }
 
+void OracleStatement::bindByName(std::string_view name, const OracleVariable& var) {
+    _checkOwner();
+    int rc = dpiStmt_bindByName(_statement, name.data(), name.size(), var._var);
+    checkErr(rc, _ctx, "binding variable to statement by name");
+}
+
+std::vector<std::string> OracleStatement::bindNames() const {
+    _checkOwner();
+    uint32_t count = 0;
+    int rc = dpiStmt_getBindCount(_statement, &count);
+    checkErr(rc, _ctx, "getting bind count of oracle statement");
+
+    std::vector<const char*> names(count);
+    std::vector<uint32_t> nameLengths(count);
+    rc = dpiStmt_getBindNames(_statement, &count, names.data(), nameLengths.data());
+    checkErr(rc, _ctx, "getting bind names of oracle statement");
+
+    std::vector<std::string> ret;
+    ret.reserve(count);
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        ret.emplace_back(names[idx], nameLengths[idx]);
+    }
+    return ret;
+}
+
 bool OracleData::isNull() const {
     return dpiData_getIsNull(_data);
 }
@@ -455,7 +1294,7 @@ int64_t OracleData::as<int64_t>() const {
 
 template<>
 uint64_t OracleData::as<uint64_t>() const {
-    checkErr( _typeNum == DPI_NATIVE_TYPE_INT64, "value for column is not uint64_t");
+    checkErr(_typeNum == DPI_NATIVE_TYPE_UINT64, "value for column is not uint64_t");
     return dpiData_getUint64(_data);
 }
 
@@ -477,6 +1316,36 @@ dpiTimestamp* OracleData::as<dpiTimestamp*>() const {
     return dpiData_getTimestamp(_data);
 }
 
+template<>
+dpiIntervalDS* OracleData::as<dpiIntervalDS*>() const {
+    checkErr(_typeNum == DPI_NATIVE_TYPE_INTERVAL_DS, "value for column is not interval day to second");
+    return dpiData_getIntervalDS(_data);
+}
+
+template<>
+dpiIntervalYM* OracleData::as<dpiIntervalYM*>() const {
+    checkErr(_typeNum == DPI_NATIVE_TYPE_INTERVAL_YM, "value for column is not interval year to month");
+    return dpiData_getIntervalYM(_data);
+}
+
+template<>
+dpiObject* OracleData::as<dpiObject*>() const {
+    checkErr(_typeNum == DPI_NATIVE_TYPE_OBJECT, "value for column is not an object");
+    return dpiData_getObject(_data);
+}
+
+template<>
+dpiLob* OracleData::as<dpiLob*>() const {
+    checkErr(_typeNum == DPI_NATIVE_TYPE_LOB, "value for column is not a lob");
+    return dpiData_getLOB(_data);
+}
+
+template<>
+dpiJson* OracleData::as<dpiJson*>() const {
+    checkErr(_typeNum == DPI_NATIVE_TYPE_JSON, "value for column is not json");
+    return _data->value.asJson;
+}
+
 template<>
 std::string_view OracleData::as<std::string_view>() const {
     checkErr(_typeNum == DPI_NATIVE_TYPE_BYTES, "value for column is not bytes");
@@ -3,11 +3,15 @@
 #include "dpi.h"
 #include "mpark/variant.hpp"
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 namespace sqlplusplus {
@@ -25,8 +29,16 @@ private:
     std::string _context;
 };
 
+// Thread safety: the context may be shared by every thread. A connection, and every
+// statement, variable, LOB, object or SODA handle created from it, must only be used by
+// one thread at a time, the thread that owns the connection. OracleConnection and
+// OracleStatement enforce this for their methods that call into ODPI (except for
+// OracleStatement::getColumnValue, which runs for every cell); ownership is handed over
+// with OracleConnection::claim.
 class OracleContext {
 public:
+    // Connections and pools created from the context use OCI's threaded mode so that
+    // different threads can work on different connections concurrently.
     static std::unique_ptr<OracleContext> make();
 
     explicit OracleContext(dpiContext* ctx) noexcept : _ctx(ctx) {}
@@ -36,11 +48,15 @@ public:
         return _ctx;
     }
 
+    // ODPI records errors per thread, so this must be called on the thread that made the
+    // failing call before that thread makes another one.
     dpiErrorInfo getLastError() const noexcept {
         dpiErrorInfo errInfo;
         dpiContext_getError(_ctx, &errInfo);
         return errInfo;
     }
+    dpiCommonCreateParams commonCreateParams() const;
+
 private:
     dpiContext* _ctx = nullptr;
 };
@@ -52,19 +68,37 @@ struct OracleConnectionOptions {
     std::string connString;
 };
 
+struct OracleConnectionPoolOptions {
+    uint32_t minSessions = 0;
+    uint32_t maxSessions = 4;
+    uint32_t sessionIncrement = 1;
+};
+
+// The pool itself may be used from any thread, each acquired connection is owned by the
+// thread that acquired it. acquireConnection waits for a session once maxSessions are in use.
 class OracleConnectionPool {
 public:
-    static OracleConnectionPool make(OracleContext* ctx, const OracleConnectionOptions& opts);
+    static OracleConnectionPool make(OracleContext* ctx,
+                                     const OracleConnectionOptions& opts,
+                                     const OracleConnectionPoolOptions& poolOpts = {});
+
+    OracleConnectionPool(const OracleConnectionPool&) = delete;
+    OracleConnectionPool(OracleConnectionPool&&) = delete;
+    ~OracleConnectionPool();
 
     OracleConnection acquireConnection();
 
+    uint32_t maxSessions() const noexcept {
+        return _maxSessions;
+    }
+
 private:
-    OracleConnectionPool(const OracleConnectionPool&) = delete;
-    OracleConnectionPool(OracleConnectionPool&&) = delete;
 
-    explicit OracleConnectionPool(OracleContext* ctx, dpiPool* pool) : _ctx(ctx), _pool(pool) {}
+    explicit OracleConnectionPool(OracleContext* ctx, dpiPool* pool, uint32_t maxSessions) :
+        _ctx(ctx), _pool(pool), _maxSessions(maxSessions) {}
     OracleContext* _ctx = nullptr;
     dpiPool* _pool = nullptr;
+    uint32_t _maxSessions = 0;
 };
 
 class OracleData {
@@ -111,6 +145,291 @@ private:
     std::string_view _strValue;
 };
 
+class OracleObjectAttr {
+public:
+    OracleObjectAttr(const OracleObjectAttr& other);
+    OracleObjectAttr(OracleObjectAttr&& other) noexcept;
+    OracleObjectAttr& operator=(const OracleObjectAttr& other);
+    OracleObjectAttr& operator=(OracleObjectAttr&& other) noexcept;
+    ~OracleObjectAttr();
+
+    std::string_view name() const noexcept {
+        return std::string_view(_info.name, _info.nameLength);
+    }
+
+    const dpiDataTypeInfo& typeInfo() const noexcept {
+        return _info.typeInfo;
+    }
+
+protected:
+    friend class OracleObject;
+    operator dpiObjectAttr*() const {
+        return _attr;
+    }
+
+private:
+    friend class OracleObjectType;
+    OracleObjectAttr(dpiObjectAttr* attr, dpiObjectAttrInfo info) :
+        _attr(attr),
+        _info(info)
+    {}
+
+    dpiObjectAttr* _attr;
+    dpiObjectAttrInfo _info;
+};
+
+class OracleObject;
+class OracleObjectType {
+public:
+    // Takes a new reference to objType, e.g. from the typeInfo of a query column.
+    OracleObjectType(OracleContext* ctx, dpiObjectType* objType);
+    OracleObjectType(const OracleObjectType& other);
+    OracleObjectType(OracleObjectType&& other) noexcept;
+    OracleObjectType& operator=(const OracleObjectType& other);
+    OracleObjectType& operator=(OracleObjectType&& other) noexcept;
+    ~OracleObjectType();
+
+    const dpiObjectTypeInfo& info() const noexcept {
+        return _info;
+    }
+
+    std::string_view schema() const noexcept {
+        return std::string_view(_info.schema, _info.schemaLength);
+    }
+
+    std::string_view name() const noexcept {
+        return std::string_view(_info.name, _info.nameLength);
+    }
+
+    bool isCollection() const noexcept {
+        return _info.isCollection;
+    }
+
+    // Each call goes back to ODPI for the attribute handles, callers rendering many
+    // objects should keep the result around.
+    std::vector<OracleObjectAttr> attributes() const;
+    OracleObject createObject() const;
+
+    dpiObjectType* get() const noexcept {
+        return _objType;
+    }
+
+private:
+    OracleContext* _ctx;
+    dpiObjectType* _objType;
+    dpiObjectTypeInfo _info;
+};
+
+class OracleObject {
+public:
+    // Takes a new reference to obj, e.g. from OracleData::as<dpiObject*>().
+    OracleObject(OracleContext* ctx, dpiObject* obj);
+    OracleObject(const OracleObject& other);
+    OracleObject(OracleObject&& other) noexcept;
+    OracleObject& operator=(const OracleObject& other);
+    OracleObject& operator=(OracleObject&& other) noexcept;
+    ~OracleObject();
+
+    // Fills out with the attribute's value converted to its default native type. If
+    // that's DPI_NATIVE_TYPE_OBJECT or DPI_NATIVE_TYPE_LOB the returned reference must be
+    // adopted with OracleObject::adopt or OracleLob::adopt.
+    void getAttributeValue(const OracleObjectAttr& attr, dpiData& out) const;
+
+    // Collection methods
+    int32_t size() const;
+    bool firstIndex(int32_t& index) const;
+    bool nextIndex(int32_t index, int32_t& next) const;
+    void getElementValue(int32_t index, dpiNativeTypeNum nativeType, dpiData& out) const;
+    void appendElement(dpiNativeTypeNum nativeType, dpiData& value);
+
+    // Takes ownership of a reference returned by ODPI without adding a new one.
+    static OracleObject adopt(OracleContext* ctx, dpiObject* obj);
+
+    dpiObject* get() const noexcept {
+        return _obj;
+    }
+
+private:
+    struct AdoptTag {};
+    OracleObject(OracleContext* ctx, dpiObject* obj, AdoptTag) :
+        _ctx(ctx),
+        _obj(obj)
+    {}
+
+    OracleContext* _ctx;
+    dpiObject* _obj;
+};
+
+class OracleLob {
+public:
+    // Takes a new reference to lob, e.g. from OracleData::as<dpiLob*>().
+    OracleLob(OracleContext* ctx, dpiLob* lob);
+    OracleLob(const OracleLob& other);
+    OracleLob(OracleLob&& other) noexcept;
+    OracleLob& operator=(const OracleLob& other);
+    OracleLob& operator=(OracleLob&& other) noexcept;
+    ~OracleLob();
+
+    // Writes are most efficient in multiples of the chunk size.
+    uint32_t chunkSize() const;
+    // In bytes for BLOBs and characters for CLOBs.
+    uint64_t size() const;
+    void trim(uint64_t newSize);
+    // offset is 1-based, in bytes for BLOBs and characters for CLOBs.
+    void writeBytes(uint64_t offset, std::string_view bytes);
+
+    // Opening the LOB around a series of writes defers index and trigger maintenance
+    // until it's closed.
+    void openResource();
+    void closeResource();
+
+    // Takes ownership of a reference returned by ODPI without adding a new one.
+    static OracleLob adopt(OracleContext* ctx, dpiLob* lob);
+
+private:
+    struct AdoptTag {};
+    OracleLob(OracleContext* ctx, dpiLob* lob, AdoptTag) :
+        _ctx(ctx),
+        _lob(lob)
+    {}
+
+    OracleContext* _ctx;
+    dpiLob* _lob;
+};
+
+// A JSON value fetched from a JSON column. The value belongs to the variable it was
+// fetched into, so it's only valid until the next fetch.
+class OracleJson {
+public:
+    // Takes a new reference to json, e.g. from OracleData::as<dpiJson*>().
+    OracleJson(OracleContext* ctx, dpiJson* json);
+    OracleJson(const OracleJson& other);
+    OracleJson(OracleJson&& other) noexcept;
+    OracleJson& operator=(const OracleJson& other);
+    OracleJson& operator=(OracleJson&& other) noexcept;
+    ~OracleJson();
+
+    // Returns the root of the decoded tree, options are DPI_JSON_OPT_* flags. The tree
+    // is owned by the JSON value and is rebuilt by every call.
+    const dpiJsonNode& value(uint32_t options = DPI_JSON_OPT_DEFAULT) const;
+
+private:
+    OracleContext* _ctx;
+    dpiJson* _json;
+};
+
+class OracleSodaDocument {
+public:
+    OracleSodaDocument(const OracleSodaDocument& other);
+    OracleSodaDocument(OracleSodaDocument&& other) noexcept;
+    OracleSodaDocument& operator=(const OracleSodaDocument& other);
+    OracleSodaDocument& operator=(OracleSodaDocument&& other) noexcept;
+    ~OracleSodaDocument();
+
+    std::string_view key() const;
+    std::string_view content() const;
+
+    dpiSodaDoc* get() const noexcept {
+        return _doc;
+    }
+
+private:
+    friend class OracleSodaDatabase;
+    friend class OracleSodaDocCursor;
+    // Takes ownership of a reference returned by ODPI.
+    OracleSodaDocument(OracleContext* ctx, dpiSodaDoc* doc) :
+        _ctx(ctx),
+        _doc(doc)
+    {}
+
+    OracleContext* _ctx;
+    dpiSodaDoc* _doc;
+};
+
+class OracleSodaDocCursor {
+public:
+    OracleSodaDocCursor(const OracleSodaDocCursor& other);
+    OracleSodaDocCursor(OracleSodaDocCursor&& other) noexcept;
+    OracleSodaDocCursor& operator=(const OracleSodaDocCursor& other);
+    OracleSodaDocCursor& operator=(OracleSodaDocCursor&& other) noexcept;
+    ~OracleSodaDocCursor();
+
+    // Returns the next document, or nothing once the cursor is exhausted. Documents are
+    // fetched from the database in batches of the fetch array size given to find.
+    std::optional<OracleSodaDocument> next();
+
+private:
+    friend class OracleSodaCollection;
+    OracleSodaDocCursor(OracleContext* ctx, dpiSodaDocCursor* cursor) :
+        _ctx(ctx),
+        _cursor(cursor)
+    {}
+
+    OracleContext* _ctx;
+    dpiSodaDocCursor* _cursor;
+};
+
+class OracleSodaCollection {
+public:
+    OracleSodaCollection(const OracleSodaCollection& other);
+    OracleSodaCollection(OracleSodaCollection&& other) noexcept;
+    OracleSodaCollection& operator=(const OracleSodaCollection& other);
+    OracleSodaCollection& operator=(OracleSodaCollection&& other) noexcept;
+    ~OracleSodaCollection();
+
+    struct FindOpts {
+        // A SODA query-by-example filter, e.g. {"name": "x"}. Empty matches every document.
+        std::string_view filter;
+        uint32_t limit = 0;
+        uint32_t fetchArraySize = 0;
+    };
+
+    OracleSodaDocCursor find(const FindOpts& opts);
+    uint64_t count(std::string_view filter);
+    // Inserts every document in one round trip. With atomicCommit the documents are
+    // committed together if they all succeed.
+    void insertMany(const std::vector<OracleSodaDocument>& docs, bool atomicCommit);
+
+private:
+    friend class OracleSodaDatabase;
+    OracleSodaCollection(OracleContext* ctx, dpiSodaColl* coll) :
+        _ctx(ctx),
+        _coll(coll)
+    {}
+
+    dpiSodaOperOptions _operOptions(std::string_view filter) const;
+
+    OracleContext* _ctx;
+    dpiSodaColl* _coll;
+};
+
+class OracleSodaDatabase {
+public:
+    OracleSodaDatabase(const OracleSodaDatabase& other);
+    OracleSodaDatabase(OracleSodaDatabase&& other) noexcept;
+    OracleSodaDatabase& operator=(const OracleSodaDatabase& other);
+    OracleSodaDatabase& operator=(OracleSodaDatabase&& other) noexcept;
+    ~OracleSodaDatabase();
+
+    std::vector<std::string> collectionNames();
+    // Throws if the collection doesn't exist, unless create is set in which case it's
+    // created with the default metadata.
+    OracleSodaCollection openCollection(std::string_view name, bool create = false);
+    OracleSodaDocument createDocument(std::string_view content);
+
+private:
+    friend class OracleConnection;
+    OracleSodaDatabase(OracleContext* ctx, dpiSodaDb* db) :
+        _ctx(ctx),
+        _db(db)
+    {}
+
+    OracleContext* _ctx;
+    dpiSodaDb* _db;
+};
+
+// A bind/define buffer of maxArraySize elements. A variable can be bound once and then
+// refilled with the setters before every execution, which doesn't allocate.
 class OracleVariable {
 public: 
     OracleVariable(const OracleVariable& other);
@@ -123,26 +442,68 @@ public:
     void setFrom(uint32_t pos, std::string_view value);
     void setFrom(uint32_t pos, const OracleStatement& stmt);
     void setFrom(uint32_t pos, const OracleRowId& rowId);
+    void setFrom(uint32_t pos, const OracleObject& obj);
+
+    // Write straight into the element, the variable's native type must match.
+    void setInt64(uint32_t pos, int64_t value);
+    void setDouble(uint32_t pos, double value);
+    void setTimestamp(uint32_t pos, const dpiTimestamp& value);
+    void setNull(uint32_t pos);
 
+    // Sets how many elements of an array variable (isArray) are bound, so one variable
+    // can be reused for batches of any size up to maxArraySize.
+    void setNumElements(uint32_t numElements);
     uint32_t numElements() const;
     uint32_t sizeInBytes() const;
+
+    uint32_t maxArraySize() const noexcept {
+        return _maxArraySize;
+    }
+
+    dpiNativeTypeNum nativeType() const noexcept {
+        return _nativeType;
+    }
+
+    // The variable's buffer, one entry per element. Values written by an execution (out
+    // binds) are read from here.
+    std::span<dpiData> elements() const noexcept {
+        return std::span<dpiData>(_data, _maxArraySize);
+    }
+
+    OracleData element(uint32_t pos) const;
     std::vector<OracleData> returnedData(uint32_t pos) const;
-    const std::vector<OracleData>& allocatedData() const;
 
 private:
     friend class OracleStatement;
     friend class OracleConnection;
-    OracleVariable(OracleContext* ctx, dpiNativeTypeNum nativeType, dpiVar* var, std::vector<OracleData> allocatedData) :
+    OracleVariable(OracleContext* ctx,
+                   dpiNativeTypeNum nativeType,
+                   dpiVar* var,
+                   dpiData* data,
+                   uint32_t maxArraySize) :
         _ctx(ctx),
         _nativeType(nativeType),
         _var(var),
-        _allocatedData(std::move(allocatedData))
+        _data(data),
+        _maxArraySize(maxArraySize)
     {}
 
+    dpiData* _element(uint32_t pos, dpiNativeTypeNum nativeType) const;
+
     OracleContext* _ctx;
     dpiNativeTypeNum _nativeType;
     dpiVar* _var;
-    std::vector<OracleData> _allocatedData;
+    dpiData* _data;
+    uint32_t _maxArraySize;
+};
+
+// The thread that owns a connection, shared with the statements prepared on it so that
+// claiming the connection hands them over too.
+struct OracleConnectionOwner {
+    std::atomic<std::thread::id> thread{std::this_thread::get_id()};
+
+    // Throws OracleException when called from any other thread.
+    void check() const;
 };
 
 class OracleConnection {
@@ -155,22 +516,41 @@ public:
     OracleConnection& operator=(OracleConnection&& other) noexcept;
     ~OracleConnection();
 
+    // Makes the calling thread the owner of this copy of the connection. The previous
+    // owner must be done with it and everything created from it. Copies share the session
+    // but track their owner separately, so connections are handed to other threads by
+    // moving them and calling claim on the receiving thread.
+    void claim() noexcept {
+        _owner->thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    }
+
     OracleStatement prepareStatement(std::string_view sql);
     void commit();
+    void rollback();
+    // Whether the session has a transaction open, i.e. changes or locks that a commit or
+    // rollback would end. Costs a round trip.
+    bool transactionInProgress();
+    // Interrupts the call currently running on the connection, which then fails with
+    // ORA-01013. Unlike every other method this may be called from any thread.
+    void breakExecution();
+
+    // Looks up a named object or collection type, e.g. "SYS.ODCINUMBERLIST".
+    OracleObjectType getObjectType(std::string_view name);
+    OracleSodaDatabase sodaDatabase();
 
     struct VariableOpts {
         struct ByteBufferOpts {
-            uint32_t size;
-            bool sizeIsBytes;
+            uint32_t size = 0;
+            bool sizeIsBytes = false;
         };
         struct ObjectOpts {
-            dpiObjectType* objType;
+            dpiObjectType* objType = nullptr;
         };
 
-        dpiOracleTypeNum dbTypeNum;
-        dpiNativeTypeNum nativeTypeNum;
-        uint32_t maxArraySize;
-        bool isArray;
+        dpiOracleTypeNum dbTypeNum = DPI_ORACLE_TYPE_VARCHAR;
+        dpiNativeTypeNum nativeTypeNum = DPI_NATIVE_TYPE_BYTES;
+        uint32_t maxArraySize = 1;
+        bool isArray = false;
         mpark::variant<ByteBufferOpts, ObjectOpts> opts;
     };
 
@@ -180,14 +560,22 @@ private:
     friend class OracleConnectionPool;
     explicit OracleConnection(OracleContext* ctx, dpiConn* conn) :
         _ctx(ctx),
-        _conn(conn)
+        _conn(conn),
+        _owner(std::make_shared<OracleConnectionOwner>())
     {}
 
+    void _checkOwner() const {
+        _owner->check();
+    }
+
     OracleContext* _ctx;
     dpiConn* _conn = nullptr;
+    std::shared_ptr<OracleConnectionOwner> _owner;
 };
 
 class OracleStatement;
+// Describes one query column. The name points into memory owned by the statement and is
+// valid until the statement is executed again or released.
 class OracleColumnInfo {
 public:
     std::string_view name() const noexcept {
@@ -202,6 +590,26 @@ public:
         return _info.typeInfo;
     }
 
+    dpiOracleTypeNum oracleType() const noexcept {
+        return _info.typeInfo.oracleTypeNum;
+    }
+
+    dpiNativeTypeNum nativeType() const noexcept {
+        return _info.typeInfo.defaultNativeTypeNum;
+    }
+
+    uint32_t sizeInBytes() const noexcept {
+        return _info.typeInfo.dbSizeInBytes;
+    }
+
+    int16_t precision() const noexcept {
+        return _info.typeInfo.precision;
+    }
+
+    int8_t scale() const noexcept {
+        return _info.typeInfo.scale;
+    }
+
 private:
     friend class OracleStatement;
     OracleColumnInfo(dpiQueryInfo info)
@@ -211,27 +619,64 @@ private:
     dpiQueryInfo _info;
 };
 
+// Move-only: the column metadata is cached per object and refreshed by execute, so a copy
+// would go stale as soon as the other one executed again.
 class OracleStatement {
 public:
-    OracleStatement(const OracleStatement& other);
+    OracleStatement(const OracleStatement&) = delete;
     OracleStatement(OracleStatement&& other) noexcept;
-    OracleStatement& operator=(const OracleStatement& other);
+    OracleStatement& operator=(const OracleStatement&) = delete;
     OracleStatement& operator=(OracleStatement&& other) noexcept;
     ~OracleStatement();
 
+    // Also describes the query columns, so the metadata accessors below never call into ODPI.
     void execute();
+    // Executes a DML statement once for each of the first numIters elements of the bound
+    // variables in one round trip. With batchErrors, failing rows don't stop the rest and
+    // are reported by batchErrors() afterwards.
+    void executeMany(uint32_t numIters, bool batchErrors = false);
+    // The errors from the last executeMany, info().offset is the element that failed.
+    std::vector<OracleException> batchErrors() const;
     bool fetch();
-    uint32_t numColumns() const;
-    OracleColumnInfo getColumnInfo(uint32_t pos) const ;
+    void setFetchArraySize(uint32_t arraySize);
+    // Rows affected by the last execution of a DML statement, or rows fetched so far for a query.
+    uint64_t rowCount() const;
+    // Overrides the type a query column is fetched as. Must be called after execute and
+    // before the first fetch.
+    void defineValue(uint32_t pos,
+                     dpiOracleTypeNum oracleType,
+                     dpiNativeTypeNum nativeType,
+                     uint32_t size,
+                     bool sizeIsBytes);
+    uint32_t numColumns() const noexcept {
+        return static_cast<uint32_t>(_columns.size());
+    }
+
+    // pos is 1-based, like every other ODPI column position.
+    const OracleColumnInfo& getColumnInfo(uint32_t pos) const;
+
+    // The query columns as of the last execute, empty for statements that aren't queries.
+    std::span<const OracleColumnInfo> columns() const noexcept {
+        return _columns;
+    }
+
     OracleData getColumnValue(uint32_t pos) const;
 
+    OracleContext* context() const noexcept {
+        return _ctx;
+    }
+
     void bindByPos(uint32_t pos, const OracleVariable& var);
+    void bindByName(std::string_view name, const OracleVariable& var);
+    // Returns the unique bind variable names in the statement, without the leading colon.
+    std::vector<std::string> bindNames() const;
 
 protected:
     friend class OracleConnection;
-    OracleStatement(OracleContext* ctx, dpiStmt* statement) :
+    OracleStatement(OracleContext* ctx, dpiStmt* statement, std::shared_ptr<OracleConnectionOwner> owner) :
         _ctx(ctx),
-        _statement(statement)
+        _statement(statement),
+        _owner(std::move(owner))
     {}
 
     friend class OracleVariable;
@@ -242,8 +687,14 @@ protected:
 private:
     std::pair<dpiData*, dpiNativeTypeNum> _dataForColumn(uint32_t pos);
 
+    void _checkOwner() const {
+        _owner->check();
+    }
+
     OracleContext* _ctx = nullptr;
     dpiStmt* _statement = nullptr;
+    std::shared_ptr<OracleConnectionOwner> _owner;
+    std::vector<OracleColumnInfo> _columns;
 };
 
 
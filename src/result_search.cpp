@@ -0,0 +1,170 @@
+#include "result_search.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <thread>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+using Column = ResultSet::Column;
+using RowIndex = ResultSet::RowIndex;
+
+constexpr RowIndex kMinRowsPerChunk = 16 * 1024;
+
+struct SearchChunk {
+    size_t column;
+    RowIndex begin;
+    RowIndex end;
+};
+
+class CellMatcher {
+public:
+    CellMatcher(std::string_view pattern, const ResultSearchOptions& opts) : _literal(pattern) {
+        if (opts.regex) {
+            _regex.emplace(pattern.begin(), pattern.end(), std::regex::ECMAScript | std::regex::optimize);
+        }
+    }
+
+    bool isRegex() const noexcept {
+        return _regex.has_value();
+    }
+
+    std::string_view literal() const noexcept {
+        return _literal;
+    }
+
+    bool matches(std::string_view value) const {
+        if (_regex) {
+            return std::regex_search(value.begin(), value.end(), *_regex);
+        }
+        return findSubstring(value, _literal) != std::string_view::npos;
+    }
+
+private:
+    std::string_view _literal;
+    std::optional<std::regex> _regex;
+};
+
+// Literal search over a text column runs over the column's contiguous text buffer in one
+// pass and maps each hit back to the row it falls in.
+void searchTextLiteral(const Column& col, const SearchChunk& chunk, std::string_view needle, uint8_t* mask) {
+    const auto& offsets = col.textOffsets;
+    const auto base = offsets[chunk.begin];
+    const std::string_view haystack(col.text.data() + base, offsets[chunk.end] - base);
+    size_t pos = 0;
+    while ((pos = findSubstring(haystack, needle, pos)) != std::string_view::npos) {
+        const auto absolute = base + pos;
+        auto it = std::upper_bound(offsets.begin() + chunk.begin, offsets.begin() + chunk.end + 1, absolute);
+        const auto row = static_cast<RowIndex>(std::distance(offsets.begin(), it) - 1);
+        if (absolute + needle.size() <= offsets[row + 1]) {
+            mask[row] = 1;
+            pos = offsets[row + 1] - base;
+        } else {
+            // The hit straddles two cells, keep looking from the next byte.
+            ++pos;
+        }
+    }
+}
+
+void searchChunk(const ResultSet& rs, const CellMatcher& matcher, const SearchChunk& chunk, uint8_t* mask) {
+    const auto& col = rs.columns()[chunk.column];
+    if (col.type == ResultSet::ColumnType::Text && !matcher.isRegex()) {
+        searchTextLiteral(col, chunk, matcher.literal(), mask);
+        return;
+    }
+
+    fmt::memory_buffer buf;
+    for (auto row = chunk.begin; row < chunk.end; ++row) {
+        if (col.isNull(row)) {
+            continue;
+        }
+        std::string_view value;
+        switch (col.type) {
+        case ResultSet::ColumnType::Int64:
+            buf.clear();
+            fmt::format_to(buf, "{}", col.ints[row]);
+            value = std::string_view(buf.data(), buf.size());
+            break;
+        case ResultSet::ColumnType::UInt64:
+            buf.clear();
+            fmt::format_to(buf, "{}", col.uints[row]);
+            value = std::string_view(buf.data(), buf.size());
+            break;
+        case ResultSet::ColumnType::Double:
+            buf.clear();
+            fmt::format_to(buf, "{}", col.doubles[row]);
+            value = std::string_view(buf.data(), buf.size());
+            break;
+        case ResultSet::ColumnType::Text:
+            value = col.textAt(row);
+            break;
+        }
+        if (matcher.matches(value)) {
+            mask[row] = 1;
+        }
+    }
+}
+} // namespace
+
+ResultSet::Selection searchRows(const ResultSet& rs, std::string_view pattern, const ResultSearchOptions& opts) {
+    if (rs.empty()) {
+        throw std::runtime_error("there is no result set to search");
+    }
+    if (pattern.empty()) {
+        throw std::runtime_error("search pattern must not be empty");
+    }
+
+    CellMatcher matcher(pattern, opts);
+    const auto numRows = rs.numRows();
+    const auto numColumns = rs.columns().size();
+    const size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    const auto rowsPerChunk = std::max<RowIndex>(
+            kMinRowsPerChunk, static_cast<RowIndex>(numRows * numColumns / numThreads + 1));
+
+    std::vector<SearchChunk> chunks;
+    for (size_t column = 0; column < numColumns; ++column) {
+        for (RowIndex begin = 0; begin < numRows; begin += rowsPerChunk) {
+            chunks.push_back(SearchChunk{column, begin, std::min(numRows, begin + rowsPerChunk)});
+        }
+    }
+
+    // Each column gets its own mask so chunks never write to the same byte.
+    std::vector<std::vector<uint8_t>> masks(numColumns, std::vector<uint8_t>(numRows));
+    std::atomic<size_t> nextChunk{0};
+    auto worker = [&] {
+        for (auto idx = nextChunk++; idx < chunks.size(); idx = nextChunk++) {
+            const auto& chunk = chunks[idx];
+            searchChunk(rs, matcher, chunk, masks[chunk.column].data());
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t idx = 1; idx < std::min(numThreads, chunks.size()); ++idx) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    ResultSet::Selection rows;
+    for (RowIndex row = 0; row < numRows; ++row) {
+        bool matched = false;
+        for (const auto& mask : masks) {
+            matched |= mask[row] != 0;
+        }
+        if (matched) {
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "result_set.h"
+
+#include <string_view>
+
+namespace sqlplusplus {
+
+struct ResultSearchOptions {
+    // Treat the pattern as an ECMAScript regular expression rather than a literal.
+    bool regex = false;
+};
+
+// Returns every row of the result set where at least one cell (as displayed, without
+// quotes) contains the pattern. Columns are split into row chunks that are searched
+// on multiple threads.
+ResultSet::Selection searchRows(const ResultSet& rs, std::string_view pattern, const ResultSearchOptions& opts);
+
+} // namespace sqlplusplus
@@ -0,0 +1,284 @@
+#include "result_set.h"
+#include "json_format.h"
+#include "table.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+ResultSet::ColumnType columnTypeFor(dpiNativeTypeNum nativeType) {
+    switch (nativeType) {
+    case DPI_NATIVE_TYPE_INT64:
+        return ResultSet::ColumnType::Int64;
+    case DPI_NATIVE_TYPE_UINT64:
+        return ResultSet::ColumnType::UInt64;
+    case DPI_NATIVE_TYPE_DOUBLE:
+    case DPI_NATIVE_TYPE_FLOAT:
+        return ResultSet::ColumnType::Double;
+    default:
+        return ResultSet::ColumnType::Text;
+    }
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char l, char r) {
+        return std::toupper(static_cast<unsigned char>(l)) == std::toupper(static_cast<unsigned char>(r));
+    });
+}
+} // namespace
+
+void ResultSet::clear() {
+    _columns.clear();
+    _numRows = 0;
+    _objectFormatter.reset();
+}
+
+void ResultSet::clearRows() {
+    for (auto& col : _columns) {
+        col.ints.clear();
+        col.uints.clear();
+        col.doubles.clear();
+        col.text.clear();
+        col.textOffsets.assign(1, 0);
+        col.nulls.clear();
+    }
+    _numRows = 0;
+}
+
+void ResultSet::reset(const OracleStatement& stmt, const TemporalFormatSettings& temporalSettings) {
+    clear();
+    _objectFormatter = std::make_unique<ObjectFormatter>(stmt.context(), temporalSettings);
+    _temporal = temporalSettings;
+    for (const auto& colInfo : stmt.columns()) {
+        auto nativeType = colInfo.nativeType();
+        auto colIdx = addColumn(std::string(colInfo.name()), columnTypeFor(nativeType));
+        const auto oracleType = colInfo.oracleType();
+        _columns[colIdx].binary = oracleType == DPI_ORACLE_TYPE_RAW || oracleType == DPI_ORACLE_TYPE_LONG_RAW;
+        _columns[colIdx].quoted = nativeType == DPI_NATIVE_TYPE_BYTES && !_columns[colIdx].binary;
+        _columns[colIdx].temporalFormat = temporalSettings.resolve(colInfo.typeInfo());
+        _columns[colIdx].objectType = colInfo.typeInfo().objectType;
+    }
+}
+
+size_t ResultSet::addColumn(std::string name, ColumnType type) {
+    if (_numRows != 0) {
+        throw std::runtime_error("cannot add a column to a result set that already has rows");
+    }
+    auto& column = _columns.emplace_back();
+    column.name = std::move(name);
+    column.type = type;
+    return _columns.size() - 1;
+}
+
+void ResultSet::appendNull(size_t column) {
+    auto& col = _columns[column];
+    col.nulls.push_back(1);
+    switch (col.type) {
+    case ColumnType::Int64:
+        col.ints.push_back(0);
+        break;
+    case ColumnType::UInt64:
+        col.uints.push_back(0);
+        break;
+    case ColumnType::Double:
+        col.doubles.push_back(0);
+        break;
+    case ColumnType::Text:
+        col.textOffsets.push_back(col.text.size());
+        break;
+    }
+}
+
+void ResultSet::appendInt64(size_t column, int64_t value) {
+    auto& col = _columns[column];
+    col.nulls.push_back(0);
+    col.ints.push_back(value);
+}
+
+void ResultSet::appendUInt64(size_t column, uint64_t value) {
+    auto& col = _columns[column];
+    col.nulls.push_back(0);
+    col.uints.push_back(value);
+}
+
+void ResultSet::appendDouble(size_t column, double value) {
+    auto& col = _columns[column];
+    col.nulls.push_back(0);
+    col.doubles.push_back(value);
+}
+
+void ResultSet::appendText(size_t column, std::string_view value) {
+    auto& col = _columns[column];
+    col.nulls.push_back(0);
+    col.text.append(value);
+    col.textOffsets.push_back(col.text.size());
+}
+
+void ResultSet::appendBinary(size_t column, std::string_view bytes) {
+    auto& col = _columns[column];
+    col.nulls.push_back(0);
+    appendHex(col.text, bytes);
+    col.textOffsets.push_back(col.text.size());
+}
+
+void ResultSet::finishRow() {
+    ++_numRows;
+}
+
+void ResultSet::appendRow(const OracleStatement& stmt) {
+    for (size_t idx = 0; idx < _columns.size(); ++idx) {
+        auto value = stmt.getColumnValue(static_cast<uint32_t>(idx + 1));
+        if (value.isNull()) {
+            appendNull(idx);
+            continue;
+        }
+
+        auto& col = _columns[idx];
+        switch (value.nativeType()) {
+        case DPI_NATIVE_TYPE_INT64:
+            col.type == ColumnType::Int64 ? appendInt64(idx, value.as<int64_t>())
+                                          : appendDouble(idx, static_cast<double>(value.as<int64_t>()));
+            break;
+        case DPI_NATIVE_TYPE_UINT64:
+            col.type == ColumnType::UInt64 ? appendUInt64(idx, value.as<uint64_t>())
+                                           : appendDouble(idx, static_cast<double>(value.as<uint64_t>()));
+            break;
+        case DPI_NATIVE_TYPE_DOUBLE:
+            appendDouble(idx, value.as<double>());
+            break;
+        case DPI_NATIVE_TYPE_FLOAT:
+            appendDouble(idx, value.as<float>());
+            break;
+        case DPI_NATIVE_TYPE_BOOLEAN:
+            appendText(idx, value.as<bool>() ? "TRUE" : "FALSE");
+            break;
+        case DPI_NATIVE_TYPE_BYTES:
+            if (col.binary) {
+                appendBinary(idx, value.as<std::string_view>());
+            } else {
+                appendText(idx, value.as<std::string_view>());
+            }
+            break;
+        case DPI_NATIVE_TYPE_TIMESTAMP: {
+            char buf[kMaxTimestampLength];
+            auto len = formatTimestamp(buf, *value.as<dpiTimestamp*>(), col.temporalFormat);
+            appendText(idx, std::string_view(buf, len));
+            break;
+        }
+        case DPI_NATIVE_TYPE_INTERVAL_DS: {
+            char buf[kMaxIntervalLength];
+            auto len = formatIntervalDS(buf, *value.as<dpiIntervalDS*>(), col.temporalFormat.fractionalDigits);
+            appendText(idx, std::string_view(buf, len));
+            break;
+        }
+        case DPI_NATIVE_TYPE_INTERVAL_YM: {
+            char buf[kMaxIntervalLength];
+            auto len = formatIntervalYM(buf, *value.as<dpiIntervalYM*>());
+            appendText(idx, std::string_view(buf, len));
+            break;
+        }
+        case DPI_NATIVE_TYPE_OBJECT:
+            _scratch.clear();
+            _objectFormatter->append(
+                    _scratch, value.as<dpiObject*>(), col.objectType, ObjectFormatter::Style::Display);
+            appendText(idx, _scratch);
+            break;
+        case DPI_NATIVE_TYPE_JSON:
+            _scratch.clear();
+            appendJson(_scratch,
+                       OracleJson(stmt.context(), value.as<dpiJson*>()).value(kJsonDecodeOptions),
+                       _temporal);
+            appendText(idx, _scratch);
+            break;
+        default:
+            appendText(idx, "unsupported type");
+        }
+    }
+    finishRow();
+}
+
+size_t ResultSet::columnIndex(std::string_view name) const {
+    for (size_t idx = 0; idx < _columns.size(); ++idx) {
+        if (equalsIgnoreCase(_columns[idx].name, name)) {
+            return idx;
+        }
+    }
+    throw std::runtime_error(fmt::format("no column named \"{}\" in result set", name));
+}
+
+void ResultSet::appendCellText(std::string& out, RowIndex row, size_t column) const {
+    const auto& col = _columns.at(column);
+    if (col.isNull(row)) {
+        out.append("<null>");
+        return;
+    }
+
+    switch (col.type) {
+    case ColumnType::Int64:
+        fmt::format_to(std::back_inserter(out), "{}", col.ints[row]);
+        break;
+    case ColumnType::UInt64:
+        fmt::format_to(std::back_inserter(out), "{}", col.uints[row]);
+        break;
+    case ColumnType::Double:
+        fmt::format_to(std::back_inserter(out), "{}", col.doubles[row]);
+        break;
+    case ColumnType::Text:
+        if (col.quoted) {
+            out.push_back('"');
+        }
+        appendEscaped(out, col.textAt(row), kKeepNewlines);
+        if (col.quoted) {
+            out.push_back('"');
+        }
+        break;
+    }
+}
+
+std::string ResultSet::cellText(RowIndex row, size_t column) const {
+    std::string out;
+    appendCellText(out, row, column);
+    return out;
+}
+
+ResultSet::Selection ResultSet::allRows() const {
+    Selection rows(_numRows);
+    std::iota(rows.begin(), rows.end(), 0);
+    return rows;
+}
+
+void ResultSet::render(std::ostream& out, const Selection& rows) const {
+    if (!_renderArena) {
+        _renderArena = std::make_unique<RenderArena>();
+    }
+
+    {
+        Table table(static_cast<Table::Width>(_columns.size()), &_renderArena->resource);
+        table.values.reserve((rows.size() + 1) * _columns.size());
+        table.addRow();
+        for (size_t col = 0; col < _columns.size(); ++col) {
+            table.setColumnValue(0, static_cast<Table::Width>(col), _columns[col].name);
+        }
+
+        for (auto row : rows) {
+            auto rowIdx = table.addRow();
+            for (size_t col = 0; col < _columns.size(); ++col) {
+                _renderScratch.clear();
+                appendCellText(_renderScratch, row, col);
+                table.setColumnValue(rowIdx, static_cast<Table::Width>(col), _renderScratch);
+            }
+        }
+
+        table.render(out);
+    }
+    _renderArena->resource.release();
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "object_format.h"
+#include "oracle_helpers.h"
+#include "value_format.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sqlplusplus {
+
+// A columnar copy of the rows fetched from a statement. Numeric columns are stored as
+// contiguous arrays so that client-side filters/sorts/aggregations can run over them
+// without going back to the database.
+class ResultSet {
+public:
+    using RowIndex = uint32_t;
+    using Selection = std::vector<RowIndex>;
+
+    enum class ColumnType { Int64, UInt64, Double, Text };
+
+    struct Column {
+        std::string name;
+        ColumnType type = ColumnType::Text;
+        bool quoted = false;
+        // RAW/LONG RAW columns, stored as hex text.
+        bool binary = false;
+        // Object and collection columns are rendered to text with this type, JSON
+        // columns are rendered as compact JSON text.
+        dpiObjectType* objectType = nullptr;
+        TemporalFormat temporalFormat;
+
+        std::vector<int64_t> ints;
+        // UINT64 values are kept unsigned so ones above INT64_MAX don't wrap.
+        std::vector<uint64_t> uints;
+        std::vector<double> doubles;
+        // Text values are stored back-to-back in one buffer, textOffsets[row] is where
+        // the value for row starts and textOffsets[row + 1] is where it ends.
+        std::string text;
+        std::vector<uint64_t> textOffsets = {0};
+        std::vector<uint8_t> nulls;
+
+        bool isNull(RowIndex row) const noexcept {
+            return nulls[row] != 0;
+        }
+
+        std::string_view textAt(RowIndex row) const noexcept {
+            return std::string_view(text).substr(
+                    textOffsets[row], textOffsets[row + 1] - textOffsets[row]);
+        }
+
+        bool isNumeric() const noexcept {
+            return type != ColumnType::Text;
+        }
+    };
+
+    // Discards any stored rows and sets up the columns from the statement's query info.
+    void reset(const OracleStatement& stmt, const TemporalFormatSettings& temporalSettings = {});
+    void clear();
+    // Discards the stored rows but keeps the columns, so a long result can be processed in batches.
+    void clearRows();
+
+    // Copies the row the statement is currently positioned on.
+    void appendRow(const OracleStatement& stmt);
+
+    // Used to build derived result sets (e.g. the output of a group-by).
+    size_t addColumn(std::string name, ColumnType type);
+    void appendNull(size_t column);
+    void appendInt64(size_t column, int64_t value);
+    void appendUInt64(size_t column, uint64_t value);
+    void appendDouble(size_t column, double value);
+    void appendText(size_t column, std::string_view value);
+    void appendBinary(size_t column, std::string_view bytes);
+    // Must be called once every column has had a value appended for the new row.
+    void finishRow();
+
+    RowIndex numRows() const noexcept {
+        return _numRows;
+    }
+
+    bool empty() const noexcept {
+        return _columns.empty();
+    }
+
+    const std::vector<Column>& columns() const noexcept {
+        return _columns;
+    }
+
+    // Looks up a column by name case-insensitively, throws std::runtime_error if it doesn't exist.
+    size_t columnIndex(std::string_view name) const;
+
+    void appendCellText(std::string& out, RowIndex row, size_t column) const;
+    std::string cellText(RowIndex row, size_t column) const;
+
+    Selection allRows() const;
+    // Renders a batch of rows as a table. The table is built in an arena that's reset
+    // after every call, so rendering batches doesn't touch the global heap unless a
+    // batch outgrows RenderArena::kInitialSize.
+    void render(std::ostream& out, const Selection& rows) const;
+
+private:
+    struct RenderArena {
+        static constexpr size_t kInitialSize = 256 * 1024;
+
+        std::unique_ptr<std::byte[]> buffer = std::make_unique<std::byte[]>(kInitialSize);
+        std::pmr::monotonic_buffer_resource resource{buffer.get(), kInitialSize};
+    };
+
+    std::vector<Column> _columns;
+    RowIndex _numRows = 0;
+    std::unique_ptr<ObjectFormatter> _objectFormatter;
+    TemporalFormatSettings _temporal;
+    std::string _scratch;
+    // Rendering state, render is logically const.
+    mutable std::unique_ptr<RenderArena> _renderArena;
+    mutable std::string _renderScratch;
+};
+
+} // namespace sqlplusplus
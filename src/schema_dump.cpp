@@ -0,0 +1,907 @@
+#include "schema_dump.h"
+#include "checkpoint.h"
+#include "mapped_file.h"
+#include "script_runner.h"
+#include "text_export.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+constexpr std::string_view kMagic = "SQLPPDAT";
+constexpr uint32_t kFormatVersion = 1;
+// Rows per block of a .dat file, which is also the size of the array inserts that
+// restore it.
+constexpr uint32_t kRowsPerBlock = 1000;
+// A block also ends once its values take this much space.
+constexpr size_t kMaxBlockBytes = 8 << 20;
+// Longest value a VARCHAR or RAW bind can hold.
+constexpr uint32_t kMaxBindSize = 32767;
+constexpr uint32_t kNumberTextSize = 64;
+// LOBs are fetched and bound as LONG values, which ODPI allocates value by value.
+constexpr uint32_t kMaxLongSize = 1u << 30;
+// Year, month, day, hour, minute, second, fractional seconds and time zone offset.
+constexpr size_t kTimestampSize = 13;
+// Rejected rows reported per table.
+constexpr uint64_t kMaxReportedErrors = 10;
+
+constexpr std::string_view kTablesFile = "tables.sql";
+constexpr std::string_view kIndexesFile = "indexes.sql";
+constexpr std::string_view kConstraintsFile = "constraints.sql";
+constexpr std::string_view kCodeFile = "code.sql";
+constexpr std::string_view kInfoFile = "dump.info";
+
+enum class ColumnKind : uint8_t { Text, Number, Raw, Timestamp, LongText, LongRaw };
+
+struct DumpColumn {
+    std::string name;
+    ColumnKind kind = ColumnKind::Text;
+    // The type the column is bound as when it's restored.
+    dpiOracleTypeNum oracleType = DPI_ORACLE_TYPE_VARCHAR;
+};
+
+template <typename T>
+void appendFixed(std::string& out, T value) {
+    for (size_t idx = 0; idx < sizeof(T); ++idx) {
+        out.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * idx)) & 0xFF));
+    }
+}
+
+void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void appendValue(std::string& out, std::string_view value) {
+    appendVarint(out, value.size() + 1);
+    out.append(value);
+}
+
+void appendTimestamp(std::string& out, const dpiTimestamp& value) {
+    appendVarint(out, kTimestampSize + 1);
+    appendFixed(out, value.year);
+    appendFixed(out, value.month);
+    appendFixed(out, value.day);
+    appendFixed(out, value.hour);
+    appendFixed(out, value.minute);
+    appendFixed(out, value.second);
+    appendFixed(out, value.fsecond);
+    appendFixed(out, value.tzHourOffset);
+    appendFixed(out, value.tzMinuteOffset);
+}
+
+// Reads the fields of a .dat file, throwing std::runtime_error instead of reading past
+// its end.
+class DumpReader {
+public:
+    explicit DumpReader(std::string_view data) : _data(data) {}
+
+    template <typename T>
+    T fixed() {
+        const auto bytes = this->bytes(sizeof(T));
+        uint64_t value = 0;
+        for (size_t idx = 0; idx < sizeof(T); ++idx) {
+            value |= uint64_t{static_cast<uint8_t>(bytes[idx])} << (8 * idx);
+        }
+        return static_cast<T>(value);
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const auto byte = fixed<uint8_t>();
+            value |= uint64_t{byte & 0x7Fu} << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        corrupt();
+    }
+
+    std::string_view bytes(uint64_t size) {
+        if (_data.size() - _pos < size) {
+            corrupt();
+        }
+        const auto out = _data.substr(_pos, static_cast<size_t>(size));
+        _pos += static_cast<size_t>(size);
+        return out;
+    }
+
+    dpiTimestamp timestamp() {
+        dpiTimestamp out{};
+        out.year = fixed<int16_t>();
+        out.month = fixed<uint8_t>();
+        out.day = fixed<uint8_t>();
+        out.hour = fixed<uint8_t>();
+        out.minute = fixed<uint8_t>();
+        out.second = fixed<uint8_t>();
+        out.fsecond = fixed<uint32_t>();
+        out.tzHourOffset = fixed<int8_t>();
+        out.tzMinuteOffset = fixed<int8_t>();
+        return out;
+    }
+
+    [[noreturn]] static void corrupt() {
+        throw std::runtime_error("dump file is truncated or corrupt");
+    }
+
+private:
+    std::string_view _data;
+    size_t _pos = 0;
+};
+
+class OutputFile {
+public:
+    explicit OutputFile(const std::string& path) : _path(path) {
+        _file = std::fopen(path.c_str(), "wb");
+        if (_file == nullptr) {
+            throw std::runtime_error(fmt::format("could not open {} for writing: {}", path, std::strerror(errno)));
+        }
+    }
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    ~OutputFile() {
+        if (_file != nullptr) {
+            std::fclose(_file);
+        }
+    }
+
+    void write(std::string_view data) {
+        if (!data.empty() && std::fwrite(data.data(), 1, data.size(), _file) != data.size()) {
+            throw std::runtime_error(fmt::format("error writing {}: {}", _path, std::strerror(errno)));
+        }
+        _bytesWritten += data.size();
+    }
+
+    void close() {
+        auto file = _file;
+        _file = nullptr;
+        if (std::fclose(file) != 0) {
+            throw std::runtime_error(fmt::format("error closing {}: {}", _path, std::strerror(errno)));
+        }
+    }
+
+    uint64_t bytesWritten() const noexcept {
+        return _bytesWritten;
+    }
+
+private:
+    std::string _path;
+    std::FILE* _file = nullptr;
+    uint64_t _bytesWritten = 0;
+};
+
+std::string readFile(const std::string& path) {
+    MappedFile file(path);
+    return std::string(file.contents());
+}
+
+// Names in the data dictionary are upper case unless they were quoted.
+std::string dictionaryName(std::string_view name) {
+    if (name.size() >= 2 && name.front() == '"' && name.back() == '"') {
+        return std::string(name.substr(1, name.size() - 2));
+    }
+    std::string out(name);
+    std::transform(out.begin(), out.end(), out.begin(), [](unsigned char ch) {
+        return static_cast<char>(std::toupper(ch));
+    });
+    return out;
+}
+
+// A file name for the table's data that is unique within the dump and safe on any file system.
+std::string dataFileName(size_t idx, std::string_view table) {
+    std::string out = fmt::format("{:04}-", idx);
+    for (auto ch : table) {
+        out.push_back(std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' ? ch : '_');
+    }
+    return out + ".dat";
+}
+
+OracleVariable textVariable(OracleConnection& conn, std::string_view value) {
+    OracleConnection::VariableOpts varOpts;
+    varOpts.opts = OracleConnection::VariableOpts::ByteBufferOpts{static_cast<uint32_t>(std::max<size_t>(value.size(), 1)), true};
+    auto var = conn.newArrayVariable(varOpts);
+    var.setFrom(0, value);
+    return var;
+}
+
+// Runs fn(conn, idx) for every idx below count on up to numSessions pooled sessions, but
+// no more than the pool has, each used by its own thread. fn reports its own errors;
+// failing to get a session is rethrown once every thread has finished.
+template <typename Fn>
+void forEachOnSessions(OracleConnectionPool& sessions, size_t count, uint32_t numSessions, Fn fn) {
+    std::atomic<size_t> nextIdx{0};
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+    auto worker = [&] {
+        try {
+            std::optional<OracleConnection> conn;
+            for (auto idx = nextIdx++; idx < count; idx = nextIdx++) {
+                if (!conn) {
+                    conn.emplace(sessions.acquireConnection());
+                }
+                fn(*conn, idx);
+            }
+        } catch (...) {
+            nextIdx = count;
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const auto numWorkers = std::min<size_t>({std::max(1u, numSessions), sessions.maxSessions(), count});
+    for (size_t idx = 0; idx < numWorkers; ++idx) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+// Appends the statements of a DBMS_METADATA script to out, ended the way a script run by
+// .run or splitScript expects.
+uint64_t appendStatements(std::string& out, const std::vector<ScriptStatement>& statements) {
+    for (const auto& statement : statements) {
+        out.append(statement.sql);
+        out.append(statement.kind == ScriptStatement::Kind::PlSql ? "\n/\n\n" : ";\n\n");
+    }
+    return statements.size();
+}
+
+struct DdlScripts {
+    std::string tables;
+    std::string indexes;
+    std::string constraints;
+    std::string code;
+    uint64_t statements = 0;
+};
+
+DdlScripts dumpDdl(OracleConnection& conn, const std::string& owner) {
+    // Leave out schema names and storage so the DDL fits any schema, and have table DDL
+    // add its constraints with separate ALTER TABLE statements so they can run last.
+    auto transforms = conn.prepareStatement(
+            "begin\n"
+            "    dbms_metadata.set_transform_param(dbms_metadata.session_transform, 'SQLTERMINATOR', true);\n"
+            "    dbms_metadata.set_transform_param(dbms_metadata.session_transform, 'SEGMENT_ATTRIBUTES', false);\n"
+            "    dbms_metadata.set_transform_param(dbms_metadata.session_transform, 'CONSTRAINTS_AS_ALTER', true);\n"
+            "    dbms_metadata.set_transform_param(dbms_metadata.session_transform, 'REF_CONSTRAINTS', false);\n"
+            "    begin\n"
+            "        dbms_metadata.set_transform_param(dbms_metadata.session_transform, 'EMIT_SCHEMA', false);\n"
+            "    exception\n"
+            "        when others then null;\n"
+            "    end;\n"
+            "end;");
+    transforms.execute();
+
+    auto ownerVar = textVariable(conn, owner);
+    auto fetchDdl = [&](std::string_view sql, auto handle) {
+        auto stmt = conn.prepareStatement(sql);
+        stmt.bindByName("owner", ownerVar);
+        stmt.execute();
+        stmt.defineValue(2, DPI_ORACLE_TYPE_LONG_VARCHAR, DPI_NATIVE_TYPE_BYTES, kMaxLongSize, true);
+        while (stmt.fetch()) {
+            handle(stmt.getColumnValue(1).as<std::string_view>(),
+                   splitScript(stmt.getColumnValue(2).as<std::string_view>()));
+        }
+    };
+
+    DdlScripts out;
+    std::string foreignKeys;
+    try {
+        fetchDdl("select object_type, dbms_metadata.get_ddl(case object_type "
+                 "when 'PACKAGE' then 'PACKAGE_SPEC' when 'TYPE' then 'TYPE_SPEC' "
+                 "else replace(object_type, ' ', '_') end, object_name, owner) "
+                 "from all_objects o "
+                 "where owner = :owner and generated = 'N' and secondary = 'N' "
+                 "and object_type in ('TYPE', 'SEQUENCE', 'TABLE', 'VIEW', 'SYNONYM', 'FUNCTION', 'PROCEDURE', "
+                 "'PACKAGE', 'PACKAGE BODY', 'TYPE BODY', 'TRIGGER') "
+                 "and (object_type <> 'TABLE' or exists (select 1 from all_tables t "
+                 "where t.owner = o.owner and t.table_name = o.object_name and t.nested = 'NO' "
+                 "and t.iot_name is null and t.secondary = 'N' and t.dropped = 'NO')) "
+                 "and not exists (select 1 from all_mviews m where m.owner = o.owner and m.mview_name = o.object_name) "
+                 "order by decode(object_type, 'TYPE', 1, 'SEQUENCE', 2, 'TABLE', 3, 4), object_id",
+                 [&](std::string_view type, std::vector<ScriptStatement> statements) {
+            if (type == "TABLE" && !statements.empty()) {
+                out.statements += appendStatements(out.tables, {statements.front()});
+                statements.erase(statements.begin());
+                out.statements += appendStatements(out.constraints, statements);
+            } else if (type == "TYPE" || type == "SEQUENCE") {
+                out.statements += appendStatements(out.tables, statements);
+            } else {
+                out.statements += appendStatements(out.code, statements);
+            }
+        });
+
+        // Indexes of primary and unique keys are created by constraints.sql along with the keys.
+        fetchDdl("select index_type, dbms_metadata.get_ddl('INDEX', index_name, owner) from all_indexes i "
+                 "where owner = :owner and table_owner = :owner and generated = 'N' "
+                 "and index_type not in ('LOB', 'IOT - TOP', 'CLUSTER') "
+                 "and not exists (select 1 from all_constraints c where c.owner = i.table_owner "
+                 "and c.index_name = i.index_name and c.constraint_type in ('P', 'U')) "
+                 "and exists (select 1 from all_tables t where t.owner = i.table_owner "
+                 "and t.table_name = i.table_name and t.dropped = 'NO')",
+                 [&](std::string_view, const std::vector<ScriptStatement>& statements) {
+            out.statements += appendStatements(out.indexes, statements);
+        });
+
+        fetchDdl("select constraint_type, dbms_metadata.get_ddl('REF_CONSTRAINT', constraint_name, owner) "
+                 "from all_constraints c where owner = :owner and constraint_type = 'R' "
+                 "and exists (select 1 from all_tables t where t.owner = c.owner "
+                 "and t.table_name = c.table_name and t.dropped = 'NO')",
+                 [&](std::string_view, const std::vector<ScriptStatement>& statements) {
+            out.statements += appendStatements(foreignKeys, statements);
+        });
+    } catch (const std::exception&) {
+        conn.prepareStatement("begin dbms_metadata.set_transform_param(dbms_metadata.session_transform, 'DEFAULT'); end;")
+                .execute();
+        throw;
+    }
+    conn.prepareStatement("begin dbms_metadata.set_transform_param(dbms_metadata.session_transform, 'DEFAULT'); end;")
+            .execute();
+
+    // Foreign keys need the primary and unique keys they refer to.
+    out.constraints.append(foreignKeys);
+    return out;
+}
+
+struct TableStats {
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+};
+
+TableStats dumpTable(OracleConnection& conn,
+                     const std::string& owner,
+                     const std::string& table,
+                     uint64_t scn,
+                     const std::string& path) {
+    auto ownerVar = textVariable(conn, owner);
+    auto tableVar = textVariable(conn, table);
+    auto describe = conn.prepareStatement(
+            "select column_name, data_type from all_tab_cols "
+            "where owner = :1 and table_name = :2 and virtual_column = 'NO' and hidden_column = 'NO' "
+            "order by column_id");
+    describe.bindByPos(1, ownerVar);
+    describe.bindByPos(2, tableVar);
+    describe.execute();
+
+    // NUMBER columns are rendered by the server, which is exact, in a fixed format.
+    std::vector<std::string> names;
+    std::vector<bool> isNumber;
+    std::string selectList;
+    while (describe.fetch()) {
+        const auto name = std::string(describe.getColumnValue(1).as<std::string_view>());
+        const auto type = describe.getColumnValue(2).as<std::string_view>();
+        isNumber.push_back(type == "NUMBER" || type == "FLOAT");
+        fmt::format_to(std::back_inserter(selectList), isNumber.back()
+                           ? "{}to_char(\"{}\", 'TM9', 'nls_numeric_characters=''.,''')"
+                           : "{}\"{}\"",
+                       selectList.empty() ? "" : ", ", name);
+        names.push_back(name);
+    }
+    if (names.empty()) {
+        throw std::runtime_error("no columns found");
+    }
+
+    auto stmt = conn.prepareStatement(
+            fmt::format("select {} from \"{}\".\"{}\" as of scn {}", selectList, owner, table, scn));
+    stmt.setFetchArraySize(kRowsPerBlock);
+    stmt.execute();
+
+    std::vector<DumpColumn> columns(names.size());
+    for (uint32_t pos = 1; pos <= columns.size(); ++pos) {
+        auto& column = columns[pos - 1];
+        column.name = names[pos - 1];
+        const auto oracleType = stmt.getColumnInfo(pos).oracleType();
+        if (isNumber[pos - 1]) {
+            column.kind = ColumnKind::Number;
+            column.oracleType = DPI_ORACLE_TYPE_NUMBER;
+            continue;
+        }
+        column.oracleType = oracleType;
+        switch (oracleType) {
+        case DPI_ORACLE_TYPE_NATIVE_FLOAT:
+        case DPI_ORACLE_TYPE_NATIVE_DOUBLE:
+            column.kind = ColumnKind::Number;
+            break;
+        case DPI_ORACLE_TYPE_CHAR:
+        case DPI_ORACLE_TYPE_VARCHAR:
+        case DPI_ORACLE_TYPE_NCHAR:
+        case DPI_ORACLE_TYPE_NVARCHAR:
+            column.kind = ColumnKind::Text;
+            break;
+        case DPI_ORACLE_TYPE_NATIVE_INT:
+        case DPI_ORACLE_TYPE_INTERVAL_DS:
+        case DPI_ORACLE_TYPE_INTERVAL_YM:
+        case DPI_ORACLE_TYPE_ROWID:
+            column.kind = ColumnKind::Text;
+            column.oracleType = DPI_ORACLE_TYPE_VARCHAR;
+            stmt.defineValue(pos, DPI_ORACLE_TYPE_VARCHAR, DPI_NATIVE_TYPE_BYTES, kNumberTextSize, false);
+            break;
+        case DPI_ORACLE_TYPE_RAW:
+            column.kind = ColumnKind::Raw;
+            break;
+        case DPI_ORACLE_TYPE_DATE:
+        case DPI_ORACLE_TYPE_TIMESTAMP:
+        case DPI_ORACLE_TYPE_TIMESTAMP_TZ:
+        case DPI_ORACLE_TYPE_TIMESTAMP_LTZ:
+            column.kind = ColumnKind::Timestamp;
+            break;
+        case DPI_ORACLE_TYPE_CLOB:
+        case DPI_ORACLE_TYPE_NCLOB:
+        case DPI_ORACLE_TYPE_LONG_VARCHAR:
+            column.kind = ColumnKind::LongText;
+            column.oracleType = DPI_ORACLE_TYPE_LONG_VARCHAR;
+            stmt.defineValue(pos, DPI_ORACLE_TYPE_LONG_VARCHAR, DPI_NATIVE_TYPE_BYTES, kMaxLongSize, true);
+            break;
+        case DPI_ORACLE_TYPE_BLOB:
+        case DPI_ORACLE_TYPE_LONG_RAW:
+            column.kind = ColumnKind::LongRaw;
+            column.oracleType = DPI_ORACLE_TYPE_LONG_RAW;
+            stmt.defineValue(pos, DPI_ORACLE_TYPE_LONG_RAW, DPI_NATIVE_TYPE_BYTES, kMaxLongSize, true);
+            break;
+        default:
+            throw std::runtime_error(fmt::format("column {} has a type that can't be dumped", column.name));
+        }
+    }
+
+    OutputFile file(path);
+    std::string buf(kMagic);
+    appendFixed(buf, kFormatVersion);
+    appendFixed(buf, static_cast<uint32_t>(columns.size()));
+    for (const auto& column : columns) {
+        appendFixed(buf, static_cast<uint8_t>(column.kind));
+        appendFixed(buf, static_cast<uint32_t>(column.oracleType));
+        appendFixed(buf, static_cast<uint32_t>(column.name.size()));
+        buf.append(column.name);
+    }
+    file.write(buf);
+
+    TableStats stats;
+    std::string block;
+    uint32_t blockRows = 0;
+    auto writeBlock = [&] {
+        buf.clear();
+        appendFixed(buf, blockRows);
+        appendFixed(buf, static_cast<uint64_t>(block.size()));
+        file.write(buf);
+        file.write(block);
+        block.clear();
+        blockRows = 0;
+    };
+
+    while (stmt.fetch()) {
+        for (uint32_t pos = 1; pos <= columns.size(); ++pos) {
+            const auto value = stmt.getColumnValue(pos);
+            if (value.isNull()) {
+                appendVarint(block, 0);
+                continue;
+            }
+            switch (value.nativeType()) {
+            case DPI_NATIVE_TYPE_TIMESTAMP:
+                appendTimestamp(block, *value.as<dpiTimestamp*>());
+                break;
+            case DPI_NATIVE_TYPE_DOUBLE:
+                appendValue(block, fmt::format("{}", value.as<double>()));
+                break;
+            case DPI_NATIVE_TYPE_FLOAT:
+                appendValue(block, fmt::format("{}", value.as<float>()));
+                break;
+            default:
+                appendValue(block, value.as<std::string_view>());
+                break;
+            }
+        }
+        ++stats.rows;
+        if (++blockRows == kRowsPerBlock || block.size() >= kMaxBlockBytes) {
+            writeBlock();
+        }
+    }
+    if (blockRows != 0) {
+        writeBlock();
+    }
+    writeBlock();
+    file.close();
+    stats.bytes = file.bytesWritten();
+    return stats;
+}
+
+struct RestoreColumn {
+    DumpColumn info;
+    dpiOracleTypeNum bindType = DPI_ORACLE_TYPE_VARCHAR;
+    dpiNativeTypeNum nativeType = DPI_NATIVE_TYPE_BYTES;
+    uint32_t capacity = 0;
+    std::optional<OracleVariable> var;
+};
+
+struct RestoreStats {
+    uint64_t rows = 0;
+    uint64_t rejected = 0;
+};
+
+// Switches the table's GENERATED ALWAYS identity columns to BY DEFAULT while its dumped
+// values are inserted, then back to ALWAYS with the sequence moved past the highest value.
+template <typename Report>
+class IdentityOverride {
+public:
+    IdentityOverride(OracleConnection& conn, const std::string& table, Report& report) :
+        _conn(conn),
+        _table(table),
+        _report(report)
+    {
+        auto tableVar = textVariable(conn, table);
+        auto query = conn.prepareStatement(
+                "select column_name from all_tab_identity_columns "
+                "where owner = sys_context('userenv', 'current_schema') and table_name = :1 "
+                "and generation_type = 'ALWAYS'");
+        query.bindByPos(1, tableVar);
+        query.execute();
+        while (query.fetch()) {
+            _columns.emplace_back(query.getColumnValue(1).as<std::string_view>());
+        }
+        for (const auto& column : _columns) {
+            _alter(column, "generated by default as identity");
+        }
+    }
+
+    IdentityOverride(const IdentityOverride&) = delete;
+    IdentityOverride& operator=(const IdentityOverride&) = delete;
+
+    // The DDL commits, so a failed load's uncommitted block is rolled back first.
+    ~IdentityOverride() {
+        if (_columns.empty()) {
+            return;
+        }
+        try {
+            _conn.rollback();
+            for (const auto& column : _columns) {
+                _alter(column, "generated always as identity (start with limit value)");
+            }
+        } catch (const OracleException& ex) {
+            _report(fmt::format("{}: could not make its identity columns GENERATED ALWAYS again: {}",
+                                _table, ex.what()));
+        }
+    }
+
+private:
+    void _alter(const std::string& column, std::string_view identity) {
+        _conn.prepareStatement(fmt::format("alter table \"{}\" modify (\"{}\" {})", _table, column, identity))
+                .execute();
+    }
+
+    OracleConnection& _conn;
+    const std::string& _table;
+    Report& _report;
+    std::vector<std::string> _columns;
+};
+
+// Loads one .dat file into table a block at a time. Rejected rows are passed to
+// report(message).
+template <typename Report>
+RestoreStats restoreTable(OracleConnection& conn, const std::string& path, const std::string& table, Report report) {
+    IdentityOverride identity(conn, table, report);
+    MappedFile file(path);
+    file.adviseSequential();
+    DumpReader reader(file.contents());
+    if (reader.bytes(kMagic.size()) != kMagic) {
+        throw std::runtime_error(fmt::format("{} is not a dump file", path));
+    }
+    if (reader.fixed<uint32_t>() != kFormatVersion) {
+        throw std::runtime_error(fmt::format("{} was written by a different version", path));
+    }
+
+    std::vector<RestoreColumn> columns(reader.fixed<uint32_t>());
+    std::string columnList;
+    std::string placeholders;
+    for (size_t idx = 0; idx < columns.size(); ++idx) {
+        auto& column = columns[idx];
+        column.info.kind = static_cast<ColumnKind>(reader.fixed<uint8_t>());
+        column.info.oracleType = static_cast<dpiOracleTypeNum>(reader.fixed<uint32_t>());
+        column.info.name = std::string(reader.bytes(reader.fixed<uint32_t>()));
+        fmt::format_to(std::back_inserter(columnList), "{}\"{}\"", idx == 0 ? "" : ", ", column.info.name);
+        fmt::format_to(std::back_inserter(placeholders), "{}:{}", idx == 0 ? "" : ", ", idx + 1);
+
+        column.bindType = column.info.oracleType;
+        switch (column.info.kind) {
+        case ColumnKind::Number:
+            if (column.bindType == DPI_ORACLE_TYPE_NATIVE_FLOAT || column.bindType == DPI_ORACLE_TYPE_NATIVE_DOUBLE) {
+                column.bindType = DPI_ORACLE_TYPE_NATIVE_DOUBLE;
+                column.nativeType = DPI_NATIVE_TYPE_DOUBLE;
+            } else {
+                column.capacity = kNumberTextSize;
+            }
+            break;
+        case ColumnKind::Timestamp:
+            column.nativeType = DPI_NATIVE_TYPE_TIMESTAMP;
+            break;
+        case ColumnKind::LongText:
+        case ColumnKind::LongRaw:
+            column.capacity = kMaxLongSize;
+            break;
+        case ColumnKind::Text:
+        case ColumnKind::Raw:
+            break;
+        default:
+            DumpReader::corrupt();
+        }
+    }
+
+    // The table is new and has no indexes or constraints yet, so rows are written
+    // directly into new blocks and each batch is committed. Oracle doesn't allow batch
+    // errors with APPEND_VALUES (ORA-38910), so a block that fails is inserted again
+    // conventionally to find and skip the rows it rejects.
+    const auto target = fmt::format("into \"{}\" ({}) values ({})", table, columnList, placeholders);
+    auto insert = conn.prepareStatement(fmt::format("insert /*+ APPEND_VALUES */ {}", target));
+    std::optional<OracleStatement> conventional;
+    auto bind = [&](size_t idx, uint32_t needed) {
+        auto& column = columns[idx];
+        if (column.var && needed <= column.capacity) {
+            return;
+        }
+        column.capacity = std::max({needed, column.capacity * 2, 16u});
+        if (column.info.kind == ColumnKind::Text || column.info.kind == ColumnKind::Raw) {
+            column.capacity = std::min(column.capacity, kMaxBindSize);
+        }
+        OracleConnection::VariableOpts varOpts;
+        varOpts.dbTypeNum = column.bindType;
+        varOpts.nativeTypeNum = column.nativeType;
+        varOpts.maxArraySize = kRowsPerBlock;
+        varOpts.opts = OracleConnection::VariableOpts::ByteBufferOpts{column.capacity, true};
+        column.var = conn.newArrayVariable(varOpts);
+        insert.bindByPos(static_cast<uint32_t>(idx + 1), *column.var);
+        if (conventional) {
+            conventional->bindByPos(static_cast<uint32_t>(idx + 1), *column.var);
+        }
+    };
+
+    RestoreStats stats;
+    std::vector<std::optional<std::string_view>> values;
+    std::vector<uint32_t> maxSizes(columns.size());
+    for (;;) {
+        const auto numRows = reader.fixed<uint32_t>();
+        const auto blockSize = reader.fixed<uint64_t>();
+        if (numRows == 0) {
+            break;
+        }
+        if (numRows > kRowsPerBlock) {
+            DumpReader::corrupt();
+        }
+
+        DumpReader block(reader.bytes(blockSize));
+        values.clear();
+        std::fill(maxSizes.begin(), maxSizes.end(), 0);
+        for (uint32_t row = 0; row < numRows; ++row) {
+            for (size_t idx = 0; idx < columns.size(); ++idx) {
+                const auto size = block.varint();
+                if (size == 0) {
+                    values.emplace_back();
+                    continue;
+                }
+                values.emplace_back(block.bytes(size - 1));
+                maxSizes[idx] = std::max(maxSizes[idx], static_cast<uint32_t>(std::min<uint64_t>(size - 1, kMaxLongSize)));
+            }
+        }
+
+        for (size_t idx = 0; idx < columns.size(); ++idx) {
+            auto& column = columns[idx];
+            if ((column.info.kind == ColumnKind::Text || column.info.kind == ColumnKind::Raw) &&
+                maxSizes[idx] > kMaxBindSize) {
+                throw std::runtime_error(fmt::format("a value of column {} is longer than {} bytes",
+                                                     column.info.name, kMaxBindSize));
+            }
+            bind(idx, maxSizes[idx]);
+            for (uint32_t row = 0; row < numRows; ++row) {
+                const auto& value = values[row * columns.size() + idx];
+                if (!value) {
+                    column.var->setNull(row);
+                } else if (column.info.kind == ColumnKind::Timestamp) {
+                    if (value->size() != kTimestampSize) {
+                        DumpReader::corrupt();
+                    }
+                    column.var->setTimestamp(row, DumpReader(*value).timestamp());
+                } else if (column.nativeType == DPI_NATIVE_TYPE_DOUBLE) {
+                    column.var->setDouble(row, std::strtod(std::string(*value).c_str(), nullptr));
+                } else {
+                    column.var->setFrom(row, *value);
+                }
+            }
+        }
+
+        const auto firstRow = stats.rows + stats.rejected + 1;
+        try {
+            insert.executeMany(numRows);
+            stats.rows += insert.rowCount();
+        } catch (const OracleException&) {
+            conn.rollback();
+            if (!conventional) {
+                conventional = conn.prepareStatement(fmt::format("insert {}", target));
+                for (size_t idx = 0; idx < columns.size(); ++idx) {
+                    conventional->bindByPos(static_cast<uint32_t>(idx + 1), *columns[idx].var);
+                }
+            }
+            conventional->executeMany(numRows, true);
+            stats.rows += conventional->rowCount();
+            for (const auto& error : conventional->batchErrors()) {
+                if (stats.rejected++ < kMaxReportedErrors) {
+                    report(fmt::format("{} row {}: {}", table, firstRow + error.info().offset, error.what()));
+                }
+            }
+        }
+        conn.commit();
+    }
+    return stats;
+}
+
+// Runs a script written by dumpDdl, reporting failing statements and carrying on.
+void runDdl(OracleConnection& conn,
+            const std::string& dir,
+            std::string_view name,
+            SchemaRestoreStats& stats,
+            std::ostream& errors) {
+    const auto text = readFile(fmt::format("{}/{}", dir, name));
+    for (const auto& statement : splitScript(text)) {
+        ++stats.ddlStatements;
+        try {
+            conn.prepareStatement(statement.sql).execute();
+        } catch (const OracleException& ex) {
+            ++stats.failedStatements;
+            errors << fmt::format("{} line {}: {}", name, statement.line, ex.what()) << std::endl;
+        }
+    }
+}
+} // namespace
+
+SchemaDumpStats dumpSchema(OracleConnection& conn,
+                           OracleConnectionPool& sessions,
+                           std::string_view schema,
+                           const std::string& dir,
+                           const SchemaDumpOptions& opts,
+                           std::ostream& errors) {
+    const auto start = std::chrono::steady_clock::now();
+    if (::mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST) {
+        throw std::runtime_error(fmt::format("could not create {}: {}", dir, std::strerror(errno)));
+    }
+
+    const auto owner = dictionaryName(schema);
+    SchemaDumpStats stats;
+    stats.scn = currentScn(conn);
+
+    auto ddl = dumpDdl(conn, owner);
+    stats.ddlStatements = ddl.statements;
+    for (auto [name, text] : {std::pair{kTablesFile, &ddl.tables},
+                              std::pair{kIndexesFile, &ddl.indexes},
+                              std::pair{kConstraintsFile, &ddl.constraints},
+                              std::pair{kCodeFile, &ddl.code}}) {
+        OutputFile file(fmt::format("{}/{}", dir, name));
+        file.write(*text);
+        file.close();
+    }
+
+    // Biggest tables first, so the last ones to finish are small.
+    std::vector<std::string> tables;
+    {
+        auto ownerVar = textVariable(conn, owner);
+        auto list = conn.prepareStatement(
+                "select table_name from all_tables t "
+                "where owner = :owner and nested = 'NO' and iot_name is null and secondary = 'N' "
+                "and temporary = 'N' and dropped = 'NO' "
+                "and not exists (select 1 from all_external_tables e "
+                "where e.owner = t.owner and e.table_name = t.table_name) "
+                "and not exists (select 1 from all_mviews m where m.owner = t.owner and m.mview_name = t.table_name) "
+                "order by blocks desc nulls last, table_name");
+        list.bindByName("owner", ownerVar);
+        list.execute();
+        while (list.fetch()) {
+            tables.emplace_back(list.getColumnValue(1).as<std::string_view>());
+        }
+    }
+
+    std::mutex statsMutex;
+    std::vector<bool> dumped(tables.size());
+    forEachOnSessions(sessions, tables.size(), opts.sessions, [&](OracleConnection& session, size_t idx) {
+        try {
+            const auto tableStats = dumpTable(session, owner, tables[idx], stats.scn,
+                                              fmt::format("{}/{}", dir, dataFileName(idx, tables[idx])));
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.rows += tableStats.rows;
+            stats.bytes += tableStats.bytes;
+            dumped[idx] = true;
+        } catch (const std::exception& ex) {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            errors << fmt::format("{}: {}", tables[idx], ex.what()) << std::endl;
+        }
+    });
+
+    // Only tables whose data was written are listed, so a restore doesn't look for the others.
+    Checkpoint info(fmt::format("{}/{}", dir, kInfoFile));
+    info.set("schema", owner);
+    info.set("scn", stats.scn);
+    for (size_t idx = 0; idx < tables.size(); ++idx) {
+        if (dumped[idx]) {
+            info.set(fmt::format("table.{}", stats.tables), tables[idx]);
+            info.set(fmt::format("file.{}", stats.tables), dataFileName(idx, tables[idx]));
+            ++stats.tables;
+        } else {
+            ++stats.failedTables;
+        }
+    }
+    info.set("tables", stats.tables);
+    info.save();
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+SchemaRestoreStats restoreSchema(OracleConnection& conn,
+                                 OracleConnectionPool& sessions,
+                                 const std::string& dir,
+                                 const SchemaDumpOptions& opts,
+                                 std::ostream& errors) {
+    const auto start = std::chrono::steady_clock::now();
+    Checkpoint info(fmt::format("{}/{}", dir, kInfoFile));
+    if (!info.resumed()) {
+        throw std::runtime_error(fmt::format("{} has no {}", dir, kInfoFile));
+    }
+
+    SchemaRestoreStats stats;
+    runDdl(conn, dir, kTablesFile, stats, errors);
+
+    const auto numTables = info.getNumber("tables");
+    std::mutex statsMutex;
+    forEachOnSessions(sessions, numTables, opts.sessions, [&](OracleConnection& session, size_t idx) {
+        const auto table = info.get(fmt::format("table.{}", idx));
+        auto report = [&](const std::string& message) {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            errors << message << std::endl;
+        };
+        try {
+            const auto tableStats = restoreTable(
+                    session, fmt::format("{}/{}", dir, info.get(fmt::format("file.{}", idx))), table, report);
+            std::lock_guard<std::mutex> lock(statsMutex);
+            ++stats.tables;
+            stats.rows += tableStats.rows;
+            stats.rejected += tableStats.rejected;
+        } catch (const std::exception& ex) {
+            report(fmt::format("{}: {}", table, ex.what()));
+            std::lock_guard<std::mutex> lock(statsMutex);
+            ++stats.failedTables;
+        }
+    });
+
+    for (auto name : {kIndexesFile, kConstraintsFile, kCodeFile}) {
+        runDdl(conn, dir, name, stats, errors);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "oracle_helpers.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+struct SchemaDumpOptions {
+    // Tables are dumped or restored this many at a time, each on its own pooled session.
+    uint32_t sessions = 4;
+};
+
+struct SchemaDumpStats {
+    uint64_t scn = 0;
+    uint64_t tables = 0;
+    uint64_t failedTables = 0;
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+    uint64_t ddlStatements = 0;
+    double seconds = 0;
+};
+
+// Writes a logical backup of schema into dir, which is created if needed:
+//   tables.sql       types, sequences and tables, without their constraints
+//   indexes.sql      indexes that don't get created by a constraint
+//   constraints.sql  primary key, unique and check constraints, then foreign keys
+//   code.sql         views, synonyms, PL/SQL units and triggers
+//   <table>.dat      the rows of each table
+//   dump.info        the schema, the SCN and the tables
+// The DDL comes from DBMS_METADATA without schema names or storage clauses, so it can be
+// restored into another schema or database. The rows of every table are read as of the
+// same SCN, by up to opts.sessions sessions from the pool at once. Tables that fail are
+// reported to errors and the rest are still dumped.
+//
+// A .dat file holds the column names and types followed by blocks of rows. Each value
+// is a varint length (0 for NULL, else the size plus one) and its bytes: numbers as
+// text, dates and timestamps as packed binary, strings, RAWs and LOBs as is. Objects,
+// JSON, XMLType and BFILE columns aren't supported.
+SchemaDumpStats dumpSchema(OracleConnection& conn,
+                           OracleConnectionPool& sessions,
+                           std::string_view schema,
+                           const std::string& dir,
+                           const SchemaDumpOptions& opts,
+                           std::ostream& errors);
+
+struct SchemaRestoreStats {
+    uint64_t tables = 0;
+    uint64_t failedTables = 0;
+    uint64_t rows = 0;
+    uint64_t rejected = 0;
+    uint64_t ddlStatements = 0;
+    uint64_t failedStatements = 0;
+    double seconds = 0;
+};
+
+// Restores a dump made by dumpSchema into the connection's current schema: runs
+// tables.sql, loads the tables in parallel with APPEND_VALUES array inserts, committing
+// each block of rows, and only then runs indexes.sql, constraints.sql and code.sql.
+// Failing statements, tables and rows are reported to errors and don't stop the restore.
+// GENERATED ALWAYS identity columns are BY DEFAULT while their table loads, so the dumped
+// values are kept.
+SchemaRestoreStats restoreSchema(OracleConnection& conn,
+                                 OracleConnectionPool& sessions,
+                                 const std::string& dir,
+                                 const SchemaDumpOptions& opts,
+                                 std::ostream& errors);
+
+} // namespace sqlplusplus
@@ -0,0 +1,458 @@
+#include "script_runner.h"
+#include "async.h"
+#include "insert_batch.h"
+#include "mapped_file.h"
+#include "result_set.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// Query results are fetched and printed in batches of this many rows so a large result
+// doesn't have to fit in memory.
+constexpr uint32_t kRowsPerBatch = 1000;
+
+bool isIdentifierChar(char ch) {
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '$' || ch == '#';
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char l, char r) {
+        return std::toupper(static_cast<unsigned char>(l)) == std::toupper(static_cast<unsigned char>(r));
+    });
+}
+
+// Returns the keyword starting at or after pos (skipping whitespace) and moves pos past it.
+std::string_view nextKeyword(std::string_view text, size_t& pos) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+        ++pos;
+    }
+    const auto start = pos;
+    while (pos < text.size() && isIdentifierChar(text[pos])) {
+        ++pos;
+    }
+    return text.substr(start, pos - start);
+}
+
+template <size_t N>
+bool isOneOf(std::string_view word, const std::string_view (&candidates)[N]) {
+    return std::any_of(std::begin(candidates), std::end(candidates), [word](std::string_view candidate) {
+        return equalsIgnoreCase(word, candidate);
+    });
+}
+
+// Whether the statement starting at text is a PL/SQL block or stored unit, which contain
+// ';' and so only end at a '/' line.
+bool isPlSql(std::string_view text) {
+    size_t pos = 0;
+    auto word = nextKeyword(text, pos);
+    if (equalsIgnoreCase(word, "begin") || equalsIgnoreCase(word, "declare")) {
+        return true;
+    }
+    if (!equalsIgnoreCase(word, "create")) {
+        return false;
+    }
+
+    constexpr std::string_view kModifiers[] = {"or", "replace", "editionable", "noneditionable", "editioning"};
+    constexpr std::string_view kUnits[] = {"function", "procedure", "package", "trigger", "type", "library"};
+    do {
+        word = nextKeyword(text, pos);
+    } while (!word.empty() && isOneOf(word, kModifiers));
+    return isOneOf(word, kUnits);
+}
+
+// Whether a query locks the rows it selects. Literals and comments are skipped, anything
+// that still looks like FOR UPDATE makes the query count as locking.
+bool locksRows(std::string_view sql) {
+    bool afterFor = false;
+    size_t pos = 0;
+    while (pos < sql.size()) {
+        const auto ch = sql[pos];
+        if (ch == '\'' || ch == '"') {
+            pos = std::min(sql.size(), sql.find(ch, pos + 1)) + 1;
+        } else if (sql.substr(pos, 2) == "--") {
+            pos = std::min(sql.size(), sql.find('\n', pos));
+        } else if (sql.substr(pos, 2) == "/*") {
+            pos = std::min(sql.size(), sql.find("*/", pos + 2)) + 2;
+        } else if (isIdentifierChar(ch)) {
+            const auto word = nextKeyword(sql, pos);
+            if (afterFor && equalsIgnoreCase(word, "update")) {
+                return true;
+            }
+            afterFor = equalsIgnoreCase(word, "for");
+        } else {
+            afterFor = afterFor && std::isspace(static_cast<unsigned char>(ch));
+            ++pos;
+        }
+    }
+    return false;
+}
+
+ScriptStatement::Kind classify(std::string_view sql) {
+    using Kind = ScriptStatement::Kind;
+    constexpr std::string_view kQueries[] = {"select", "with"};
+    constexpr std::string_view kPlSql[] = {"begin", "declare", "call"};
+    constexpr std::string_view kDdl[] = {
+            "create", "alter", "drop", "truncate", "grant", "revoke", "rename", "comment", "analyze", "purge"};
+
+    size_t pos = 0;
+    const auto word = nextKeyword(sql, pos);
+    if (isOneOf(word, kQueries)) {
+        // SELECT ... FOR UPDATE takes row locks in the transaction, so it's run like DML:
+        // on conn, in order, and never ahead on the second session where the locks would
+        // block the script's own later changes.
+        return locksRows(sql) ? Kind::Dml : Kind::Query;
+    } else if (isOneOf(word, kPlSql) || isPlSql(sql)) {
+        return Kind::PlSql;
+    } else if (isOneOf(word, kDdl)) {
+        return Kind::Ddl;
+    } else if (equalsIgnoreCase(word, "commit")) {
+        return Kind::Commit;
+    } else if (equalsIgnoreCase(word, "rollback")) {
+        return Kind::Rollback;
+    }
+    // Anything else (DML, LOCK TABLE, SAVEPOINT, ...) is assumed to change session state.
+    return Kind::Dml;
+}
+
+// SQL*Plus commands that can appear between statements in generated scripts. They end at
+// the end of their line and aren't sent to the server.
+bool isSqlPlusDirective(std::string_view line) {
+    constexpr std::string_view kDirectives[] = {
+            "set", "prompt", "spool", "whenever", "exit", "quit", "rem", "remark", "define", "column", "show"};
+    constexpr std::string_view kSqlAfterSet[] = {"transaction", "role", "constraint", "constraints"};
+
+    size_t pos = 0;
+    const auto word = nextKeyword(line, pos);
+    if (!isOneOf(word, kDirectives)) {
+        return false;
+    }
+    return !equalsIgnoreCase(word, "set") || !isOneOf(nextKeyword(line, pos), kSqlAfterSet);
+}
+
+class ScriptScanner {
+public:
+    explicit ScriptScanner(std::string_view text) : _text(text) {}
+
+    std::optional<ScriptStatement> next() {
+        _skipToStatement();
+        if (_pos == _text.size()) {
+            return std::nullopt;
+        }
+
+        ScriptStatement statement;
+        statement.line = _line;
+        const auto start = _pos;
+        const bool plsql = isPlSql(_text.substr(start));
+        auto end = _text.size();
+        while (_pos < _text.size()) {
+            const auto ch = _text[_pos];
+            if (ch == '\'' && _pos > 0 && (_text[_pos - 1] == 'q' || _text[_pos - 1] == 'Q') &&
+                (_pos < 2 || !isIdentifierChar(_text[_pos - 2]) || _text[_pos - 2] == 'n' || _text[_pos - 2] == 'N')) {
+                _skipQuotedLiteral();
+            } else if (ch == '\'' || ch == '"') {
+                _skipPast(ch, _pos + 1);
+            } else if (_text.substr(_pos, 2) == "--") {
+                // The newline is left for the check for a '/' line below.
+                _advanceTo(std::min(_text.size(), _text.find('\n', _pos)));
+            } else if (_text.substr(_pos, 2) == "/*") {
+                _skipPast("*/", _pos + 2);
+            } else if (ch == ';' && !plsql) {
+                end = _pos++;
+                break;
+            } else if (ch == '\n') {
+                ++_line;
+                if (auto next = _pos + 1; _isSlashLine(next)) {
+                    end = _pos;
+                    _pos = std::min(_text.size(), _text.find('\n', next));
+                    break;
+                }
+                ++_pos;
+            } else {
+                ++_pos;
+            }
+        }
+
+        auto sql = _text.substr(start, end - start);
+        sql = sql.substr(0, sql.find_last_not_of(" \t\r\n") + 1);
+        statement.sql = std::string(sql);
+        statement.kind = classify(sql);
+        return statement;
+    }
+
+private:
+    // Moves past whitespace, comments, stray '/' lines and SQL*Plus directives.
+    void _skipToStatement() {
+        while (_pos < _text.size()) {
+            const auto ch = _text[_pos];
+            if (ch == '\n') {
+                ++_line;
+                ++_pos;
+            } else if (std::isspace(static_cast<unsigned char>(ch))) {
+                ++_pos;
+            } else if (_text.substr(_pos, 2) == "--" || _isSlashLine(_pos) ||
+                       isSqlPlusDirective(_text.substr(_pos, _text.find('\n', _pos) - _pos))) {
+                _pos = std::min(_text.size(), _text.find('\n', _pos));
+            } else if (_text.substr(_pos, 2) == "/*") {
+                _skipPast("*/", _pos + 2);
+            } else {
+                return;
+            }
+        }
+    }
+
+    // Whether the line starting at pos holds nothing but a '/'.
+    bool _isSlashLine(size_t pos) const {
+        auto lineEnd = std::min(_text.size(), _text.find('\n', pos));
+        auto line = _text.substr(pos, lineEnd - pos);
+        auto first = line.find_first_not_of(" \t\r");
+        return first != std::string_view::npos && line[first] == '/' &&
+            line.find_first_not_of(" \t\r", first + 1) == std::string_view::npos;
+    }
+
+    template <typename Terminator>
+    void _skipPast(Terminator terminator, size_t from) {
+        auto found = _text.find(terminator, from);
+        if constexpr (std::is_same_v<Terminator, char>) {
+            _advanceTo(found == std::string_view::npos ? _text.size() : found + 1);
+        } else {
+            _advanceTo(found == std::string_view::npos ? _text.size() : found + std::string_view(terminator).size());
+        }
+    }
+
+    // q'[...]' literals, which may contain unescaped quotes.
+    void _skipQuotedLiteral() {
+        if (_pos + 1 >= _text.size()) {
+            _advanceTo(_text.size());
+            return;
+        }
+        auto close = _text[_pos + 1];
+        switch (close) {
+        case '[': close = ']'; break;
+        case '{': close = '}'; break;
+        case '(': close = ')'; break;
+        case '<': close = '>'; break;
+        }
+        const char terminator[] = {close, '\'', '\0'};
+        _skipPast(static_cast<const char*>(terminator), _pos + 2);
+    }
+
+    void _advanceTo(size_t pos) {
+        _line += static_cast<uint32_t>(std::count(_text.begin() + _pos, _text.begin() + pos, '\n'));
+        _pos = pos;
+    }
+
+    std::string_view _text;
+    size_t _pos = 0;
+    uint32_t _line = 1;
+};
+
+bool canRunAhead(const ScriptStatement& statement, bool uncommitted, const ScriptOptions& opts) {
+    if (statement.kind != ScriptStatement::Kind::Query) {
+        return false;
+    }
+    switch (opts.pipeline) {
+    case ScriptOptions::Pipeline::Off:
+        return false;
+    case ScriptOptions::Pipeline::Queries:
+        return !uncommitted;
+    case ScriptOptions::Pipeline::All:
+        return true;
+    }
+    return false;
+}
+
+Task<OracleStatement> executeOn(OracleConnection& session, std::string_view sql) {
+    auto stmt = co_await prepareAsync(session, sql);
+    co_await executeAsync(session, stmt);
+    co_return stmt;
+}
+
+uint64_t printQuery(OracleStatement& stmt, ResultSet& results, const ScriptOptions& opts, std::ostream& out) {
+    results.reset(stmt, opts.temporal);
+    uint64_t total = 0;
+    bool more = true;
+    while (more) {
+        results.clearRows();
+        while (results.numRows() < kRowsPerBatch && (more = stmt.fetch())) {
+            results.appendRow(stmt);
+        }
+        if (results.numRows() != 0) {
+            results.render(out, results.allRows());
+            total += results.numRows();
+        }
+    }
+    out << total << " rows selected\n";
+    return total;
+}
+} // namespace
+
+std::vector<ScriptStatement> splitScript(std::string_view script) {
+    std::vector<ScriptStatement> statements;
+    ScriptScanner scanner(script);
+    while (auto statement = scanner.next()) {
+        if (!statement->sql.empty()) {
+            statements.push_back(std::move(*statement));
+        }
+    }
+    return statements;
+}
+
+ScriptStats runScript(OracleConnection& conn,
+                      OracleConnectionPool& sessions,
+                      const std::string& path,
+                      const ScriptOptions& opts,
+                      std::ostream& out) {
+    MappedFile file(path);
+    file.adviseSequential();
+    const auto statements = splitScript(file.contents());
+    const auto start = std::chrono::steady_clock::now();
+
+    ScriptStats stats;
+    ResultSet results;
+    // Opened the first time a query can run ahead.
+    std::optional<OracleConnection> second;
+    // The next statement, when it's already executing on aheadSession.
+    std::future<OracleStatement> ahead;
+    OracleConnection* aheadSession = nullptr;
+    // Changes the shell made before the script are just as invisible to the second session.
+    bool uncommitted = opts.pipeline == ScriptOptions::Pipeline::Queries && conn.transactionInProgress();
+
+    InsertBatch inserts;
+    uint64_t rowsSinceCommit = 0;
+    auto flushInserts = [&] {
+        if (inserts.empty()) {
+            return;
+        }
+        const auto numRows = inserts.size();
+        try {
+            conn.claim();
+            auto result = inserts.flush(conn);
+            stats.batchedInserts += numRows;
+            ++stats.batches;
+            uncommitted = true;
+            for (const auto& [line, error] : result.errors) {
+                ++stats.failed;
+                out << fmt::format("Error at line {}: {}", line, error.what()) << std::endl;
+            }
+
+            rowsSinceCommit += result.rowsInserted;
+            if (opts.commitRows != 0 && rowsSinceCommit >= opts.commitRows) {
+                conn.commit();
+                rowsSinceCommit = 0;
+                uncommitted = false;
+            }
+        } catch (const OracleException& e) {
+            ++stats.failed;
+            out << fmt::format("Error in batch of {} inserts {}: {}", numRows, e.context(), e.what()) << std::endl;
+            inserts.clear();
+        }
+    };
+
+    for (size_t idx = 0; idx < statements.size(); ++idx) {
+        const auto& statement = statements[idx];
+        ++stats.statements;
+
+        if (opts.insertBatchSize > 1 && statement.kind == ScriptStatement::Kind::Dml) {
+            if (auto insert = parseInsert(statement.sql)) {
+                if (!inserts.accepts(*insert)) {
+                    flushInserts();
+                }
+                inserts.add(*insert, statement.line);
+                if (inserts.size() >= opts.insertBatchSize) {
+                    flushInserts();
+                }
+                if (stats.failed != 0 && opts.stopOnError) {
+                    break;
+                }
+                continue;
+            }
+        }
+        flushInserts();
+        if (stats.failed != 0 && opts.stopOnError) {
+            break;
+        }
+
+        try {
+            OracleConnection* session = &conn;
+            std::optional<OracleStatement> stmt;
+            if (ahead.valid()) {
+                session = aheadSession;
+                stmt = ahead.get();
+                // It was executed on a pool thread, its rows are fetched here.
+                session->claim();
+            } else {
+                conn.claim();
+                stmt = conn.prepareStatement(statement.sql);
+                stmt->execute();
+            }
+
+            switch (statement.kind) {
+            case ScriptStatement::Kind::Dml:
+            case ScriptStatement::Kind::PlSql:
+                uncommitted = true;
+                break;
+            case ScriptStatement::Kind::Ddl:
+            case ScriptStatement::Kind::Commit:
+            case ScriptStatement::Kind::Rollback:
+                uncommitted = false;
+                break;
+            case ScriptStatement::Kind::Query:
+                break;
+            }
+            if (stmt->numColumns() == 0) {
+                continue;
+            }
+
+            // Whichever session isn't busy with this statement runs the next one while
+            // this one's rows are fetched.
+            if (idx + 1 < statements.size() && canRunAhead(statements[idx + 1], uncommitted, opts)) {
+                if (session == &conn && !second) {
+                    second = sessions.acquireConnection();
+                }
+                aheadSession = session == &conn ? &*second : &conn;
+                ahead = startTask(executeOn(*aheadSession, statements[idx + 1].sql));
+                ++stats.pipelined;
+            }
+            stats.rows += printQuery(*stmt, results, opts, out);
+        } catch (const OracleException& e) {
+            ++stats.failed;
+            out << fmt::format("Error at line {} {}: {}", statement.line, e.context(), e.what()) << std::endl;
+        } catch (const std::exception& e) {
+            ++stats.failed;
+            out << fmt::format("Error at line {}: {}", statement.line, e.what()) << std::endl;
+        }
+
+        if (stats.failed != 0 && opts.stopOnError) {
+            break;
+        }
+    }
+
+    if (stats.failed == 0 || !opts.stopOnError) {
+        flushInserts();
+        if (opts.commitRows != 0 && rowsSinceCommit != 0) {
+            conn.commit();
+        }
+    }
+
+    // A statement started ahead is still using one of the sessions.
+    if (ahead.valid()) {
+        ahead.wait();
+    }
+    conn.claim();
+    out << std::flush;
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+} // namespace sqlplusplus
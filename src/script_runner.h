@@ -0,0 +1,71 @@
+#pragma once
+
+#include "oracle_helpers.h"
+#include "value_format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sqlplusplus {
+
+struct ScriptStatement {
+    // SELECT ... FOR UPDATE is Dml rather than Query, since it takes locks like DML does.
+    enum class Kind { Query, Dml, Ddl, PlSql, Commit, Rollback };
+
+    std::string sql;
+    // Line of the script the statement starts on, counting from 1.
+    uint32_t line = 0;
+    Kind kind = Kind::Dml;
+};
+
+// Splits a SQL*Plus style script into statements. SQL statements end at a ';' and PL/SQL
+// blocks (BEGIN, DECLARE and CREATE of a stored unit) at a line holding only '/', which
+// also ends any other statement. Comments between statements and SQL*Plus directives
+// such as SET or PROMPT are skipped.
+std::vector<ScriptStatement> splitScript(std::string_view script);
+
+struct ScriptOptions {
+    // Queries can be prepared and executed on a second session while the previous
+    // statement's rows are still being fetched. That session can't see the shell's
+    // uncommitted changes, so by default a query only runs ahead when there are none;
+    // All lets it run ahead regardless.
+    enum class Pipeline { Off, Queries, All };
+
+    Pipeline pipeline = Pipeline::Queries;
+    // Consecutive single-row INSERTs of literals into the same table are sent as array
+    // DML in batches of up to this many rows, 1 runs every INSERT on its own.
+    uint32_t insertBatchSize = 5000;
+    // Commit once at least this many batched rows have been inserted since the last
+    // commit, 0 leaves committing to the script.
+    uint64_t commitRows = 0;
+    // With batching, the rest of a batch is still inserted after one of its rows fails.
+    bool stopOnError = true;
+    TemporalFormatSettings temporal;
+};
+
+struct ScriptStats {
+    size_t statements = 0;
+    size_t failed = 0;
+    // Statements that were executed ahead on the second session.
+    size_t pipelined = 0;
+    // INSERTs that were sent in batches, and how many batches that took.
+    size_t batchedInserts = 0;
+    size_t batches = 0;
+    uint64_t rows = 0;
+    double seconds = 0;
+};
+
+// Runs the script at path on conn, printing query results and errors to out. Statements
+// other than queries always run on conn, in order, so they share the shell's transaction.
+// Errors in batched INSERTs are reported against the line of the INSERT that failed.
+ScriptStats runScript(OracleConnection& conn,
+                      OracleConnectionPool& sessions,
+                      const std::string& path,
+                      const ScriptOptions& opts,
+                      std::ostream& out);
+
+} // namespace sqlplusplus
@@ -0,0 +1,75 @@
+#include "server_output.h"
+
+#include <ostream>
+#include <string_view>
+
+namespace sqlplusplus {
+
+namespace {
+OracleConnection::VariableOpts linesVariableOpts() {
+    OracleConnection::VariableOpts opts;
+    opts.dbTypeNum = DPI_ORACLE_TYPE_VARCHAR;
+    opts.nativeTypeNum = DPI_NATIVE_TYPE_BYTES;
+    opts.maxArraySize = ServerOutput::kLinesPerCall;
+    opts.isArray = true;
+    opts.opts = OracleConnection::VariableOpts::ByteBufferOpts{ServerOutput::kMaxLineSize, true};
+    return opts;
+}
+
+OracleConnection::VariableOpts numLinesVariableOpts() {
+    OracleConnection::VariableOpts opts;
+    opts.dbTypeNum = DPI_ORACLE_TYPE_NATIVE_INT;
+    opts.nativeTypeNum = DPI_NATIVE_TYPE_INT64;
+    opts.maxArraySize = 1;
+    opts.isArray = false;
+    opts.opts = OracleConnection::VariableOpts::ByteBufferOpts{0, false};
+    return opts;
+}
+
+void runPlsql(OracleConnection& conn, std::string_view block) {
+    auto stmt = conn.prepareStatement(block);
+    stmt.execute();
+}
+} // namespace
+
+ServerOutput::ServerOutput(OracleConnection& conn) :
+    _getLines(conn.prepareStatement("begin dbms_output.get_lines(:lines, :numLines); end;")),
+    _lines(conn.newArrayVariable(linesVariableOpts())),
+    _numLines(conn.newArrayVariable(numLinesVariableOpts()))
+{
+    runPlsql(conn, "begin dbms_output.enable(null); end;");
+    _getLines.bindByName("lines", _lines);
+    _getLines.bindByName("numLines", _numLines);
+}
+
+void ServerOutput::disable(OracleConnection& conn) {
+    runPlsql(conn, "begin dbms_output.disable; end;");
+}
+
+size_t ServerOutput::drain(std::ostream& out) {
+    size_t total = 0;
+    for (;;) {
+        _numLines.setInt64(0, kLinesPerCall);
+        _getLines.execute();
+
+        const auto numLines = static_cast<uint32_t>(_numLines.element(0).as<int64_t>());
+        for (uint32_t idx = 0; idx < numLines; ++idx) {
+            // Empty lines come back as nulls.
+            auto line = _lines.element(idx);
+            if (!line.isNull()) {
+                out << line.as<std::string_view>();
+            }
+            out << '\n';
+        }
+        total += numLines;
+
+        // GET_LINES returns fewer lines than asked for once the buffer is empty.
+        if (numLines < kLinesPerCall) {
+            break;
+        }
+    }
+    out.flush();
+    return total;
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "oracle_helpers.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace sqlplusplus {
+
+// Retrieves the lines written with DBMS_OUTPUT by statements run on a connection. Lines
+// are fetched kLinesPerCall at a time with DBMS_OUTPUT.GET_LINES into an array bind, so
+// draining a large buffer costs one round trip per batch rather than one per line.
+class ServerOutput {
+public:
+    static constexpr uint32_t kLinesPerCall = 256;
+    // DBMS_OUTPUT lines are limited to 32767 bytes.
+    static constexpr uint32_t kMaxLineSize = 32767;
+
+    // Enables DBMS_OUTPUT for the session with an unlimited buffer.
+    explicit ServerOutput(OracleConnection& conn);
+
+    // Disables DBMS_OUTPUT for the session, discarding anything still buffered.
+    void disable(OracleConnection& conn);
+
+    // Writes every buffered line to out and returns how many there were.
+    size_t drain(std::ostream& out);
+
+private:
+    OracleStatement _getLines;
+    OracleVariable _lines;
+    OracleVariable _numLines;
+};
+
+} // namespace sqlplusplus
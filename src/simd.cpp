@@ -0,0 +1,145 @@
+#include "simd.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sqlplusplus {
+
+size_t findSubstring(std::string_view haystack, std::string_view needle, size_t from) noexcept {
+    if (from > haystack.size()) {
+        return std::string_view::npos;
+    }
+    if (needle.size() < 2) {
+        return haystack.find(needle, from);
+    }
+
+#if defined(__SSE2__)
+    // Compare the first and last byte of the needle against 16 positions of the haystack
+    // at once and only memcmp the middle of the candidates where both matched.
+    const auto* data = haystack.data();
+    const auto needleSize = needle.size();
+    const auto firstByte = _mm_set1_epi8(needle.front());
+    const auto lastByte = _mm_set1_epi8(needle.back());
+    size_t pos = from;
+    for (; pos + needleSize - 1 + 16 <= haystack.size(); pos += 16) {
+        const auto blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const auto blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + needleSize - 1));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(firstByte, blockFirst), _mm_cmpeq_epi8(lastByte, blockLast))));
+        while (mask != 0) {
+            const auto bit = static_cast<size_t>(__builtin_ctz(mask));
+            if (std::memcmp(data + pos + bit + 1, needle.data() + 1, needleSize - 2) == 0) {
+                return pos + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return haystack.find(needle, pos);
+#else
+    return haystack.find(needle, from);
+#endif
+}
+
+size_t findEscapeChar(std::string_view str, size_t from) noexcept {
+    const auto* data = reinterpret_cast<const unsigned char*>(str.data());
+    size_t pos = from;
+#if defined(__SSE2__)
+    // There's no unsigned byte compare in SSE2, but max(v, 0x1f) == 0x1f iff v <= 0x1f.
+    const auto controlMax = _mm_set1_epi8(0x1f);
+    const auto del = _mm_set1_epi8(0x7f);
+    const auto backslash = _mm_set1_epi8('\\');
+    for (; pos + 16 <= str.size(); pos += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const auto isControl = _mm_or_si128(
+                _mm_cmpeq_epi8(_mm_max_epu8(block, controlMax), controlMax), _mm_cmpeq_epi8(block, del));
+        const auto isEscape = _mm_or_si128(isControl, _mm_cmpeq_epi8(block, backslash));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(isEscape));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+#endif
+    for (; pos < str.size(); ++pos) {
+        if (data[pos] < 0x20 || data[pos] == 0x7f || data[pos] == '\\') {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+size_t findFirstOf(std::string_view str, char c1, char c2, char c3, size_t from) noexcept {
+    const auto* data = str.data();
+    size_t pos = from;
+#if defined(__SSE2__)
+    const auto first = _mm_set1_epi8(c1);
+    const auto second = _mm_set1_epi8(c2);
+    const auto third = _mm_set1_epi8(c3);
+    for (; pos + 16 <= str.size(); pos += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const auto matches = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(block, first), _mm_cmpeq_epi8(block, second)),
+                _mm_cmpeq_epi8(block, third));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+#endif
+    for (; pos < str.size(); ++pos) {
+        if (data[pos] == c1 || data[pos] == c2 || data[pos] == c3) {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+size_t countChar(std::string_view str, char ch) noexcept {
+    const auto* data = str.data();
+    size_t count = 0;
+    size_t pos = 0;
+#if defined(__SSE2__)
+    const auto needle = _mm_set1_epi8(ch);
+    for (; pos + 16 <= str.size(); pos += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+        count += static_cast<size_t>(__builtin_popcount(mask));
+    }
+#endif
+    for (; pos < str.size(); ++pos) {
+        count += data[pos] == ch;
+    }
+    return count;
+}
+
+void hexEncode(const unsigned char* data, size_t size, char* out) noexcept {
+    size_t pos = 0;
+#if defined(__SSE2__)
+    // Split every byte into its two nibbles, interleave them high nibble first and turn
+    // each nibble into '0'-'9' or 'A'-'F' with a compare instead of a table lookup.
+    const auto lowNibbleMask = _mm_set1_epi8(0x0f);
+    const auto nine = _mm_set1_epi8(9);
+    const auto zeroChar = _mm_set1_epi8('0');
+    const auto letterOffset = _mm_set1_epi8('A' - '0' - 10);
+    auto toHex = [&](__m128i nibbles) {
+        const auto isLetter = _mm_cmpgt_epi8(nibbles, nine);
+        return _mm_add_epi8(_mm_add_epi8(nibbles, zeroChar), _mm_and_si128(isLetter, letterOffset));
+    };
+    for (; pos + 16 <= size; pos += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const auto high = _mm_and_si128(_mm_srli_epi16(block, 4), lowNibbleMask);
+        const auto low = _mm_and_si128(block, lowNibbleMask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + pos * 2), toHex(_mm_unpacklo_epi8(high, low)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + pos * 2 + 16), toHex(_mm_unpackhi_epi8(high, low)));
+    }
+#endif
+    constexpr char kHexDigits[] = "0123456789ABCDEF";
+    for (; pos < size; ++pos) {
+        out[pos * 2] = kHexDigits[data[pos] >> 4];
+        out[pos * 2 + 1] = kHexDigits[data[pos] & 0x0f];
+    }
+}
+
+} // namespace sqlplusplus
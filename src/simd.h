@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace sqlplusplus {
+
+// Returns the offset of the first occurrence of needle in haystack at or after `from`,
+// or std::string_view::npos. Uses SSE2 to test 16 candidate positions at a time where
+// it's available.
+size_t findSubstring(std::string_view haystack, std::string_view needle, size_t from = 0) noexcept;
+
+// Returns the offset of the first ASCII control character (0x00-0x1f or 0x7f) or backslash
+// in str at or after `from`, or std::string_view::npos. These are the bytes appendEscaped
+// may rewrite.
+size_t findEscapeChar(std::string_view str, size_t from = 0) noexcept;
+
+// Returns the offset of the first of c1, c2 or c3 in str at or after `from`, or
+// std::string_view::npos.
+size_t findFirstOf(std::string_view str, char c1, char c2, char c3, size_t from = 0) noexcept;
+
+// Returns how many times ch occurs in str.
+size_t countChar(std::string_view str, char ch) noexcept;
+
+// Writes two upper-case hex digits for every byte of data to out, which must have room
+// for 2 * size characters.
+void hexEncode(const unsigned char* data, size_t size, char* out) noexcept;
+
+} // namespace sqlplusplus
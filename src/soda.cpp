@@ -0,0 +1,154 @@
+#include "soda.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+constexpr size_t kFlushThreshold = 1 << 20;
+
+bool isBlank(std::string_view line) {
+    return line.find_first_not_of(" \t\r") == std::string_view::npos;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+SodaTransferStats loadDocuments(OracleConnection& conn,
+                                std::string_view collection,
+                                const std::string& path,
+                                const SodaLoadOptions& opts) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error(fmt::format("could not open {} for reading: {}", path, std::strerror(errno)));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto db = conn.sodaDatabase();
+    auto coll = db.openCollection(collection, opts.create);
+
+    // The documents of a batch are read back-to-back into one buffer and only turned into
+    // SODA documents once the batch is complete, so the buffer never moves underneath them.
+    std::string batchText;
+    std::vector<size_t> batchOffsets = {0};
+    std::vector<OracleSodaDocument> docs;
+    docs.reserve(opts.batchSize);
+    SodaTransferStats stats;
+
+    auto insertBatch = [&] {
+        for (size_t idx = 0; idx + 1 < batchOffsets.size(); ++idx) {
+            auto content = std::string_view(batchText).substr(
+                    batchOffsets[idx], batchOffsets[idx + 1] - batchOffsets[idx]);
+            docs.push_back(db.createDocument(content));
+        }
+        coll.insertMany(docs, true);
+        stats.documents += docs.size();
+        stats.bytes += batchText.size();
+        docs.clear();
+        batchText.clear();
+        batchOffsets.resize(1);
+    };
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (isBlank(line)) {
+            continue;
+        }
+        batchText.append(line);
+        batchOffsets.push_back(batchText.size());
+        if (batchOffsets.size() > opts.batchSize) {
+            insertBatch();
+        }
+    }
+    if (batchOffsets.size() > 1) {
+        insertBatch();
+    }
+
+    stats.seconds = secondsSince(start);
+    return stats;
+}
+
+SodaTransferStats dumpDocuments(OracleConnection& conn,
+                                std::string_view collection,
+                                const std::string& path,
+                                const SodaDumpOptions& opts) {
+    const auto start = std::chrono::steady_clock::now();
+    auto coll = conn.sodaDatabase().openCollection(collection);
+    OracleSodaCollection::FindOpts findOpts;
+    findOpts.filter = opts.filter;
+    findOpts.fetchArraySize = opts.fetchArraySize;
+    auto cursor = coll.find(findOpts);
+
+    auto file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error(fmt::format("could not open {} for writing: {}", path, std::strerror(errno)));
+    }
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> fileGuard(file, &std::fclose);
+
+    std::string buffer;
+    buffer.reserve(kFlushThreshold * 2);
+    SodaTransferStats stats;
+    auto flush = [&] {
+        if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            throw std::runtime_error(fmt::format("error writing dump file: {}", std::strerror(errno)));
+        }
+        stats.bytes += buffer.size();
+        buffer.clear();
+    };
+
+    while (auto doc = cursor.next()) {
+        buffer.append(doc->content());
+        buffer.push_back('\n');
+        ++stats.documents;
+        if (buffer.size() >= kFlushThreshold) {
+            flush();
+        }
+    }
+    flush();
+
+    if (std::fclose(fileGuard.release()) != 0) {
+        throw std::runtime_error(fmt::format("error closing dump file: {}", std::strerror(errno)));
+    }
+    stats.seconds = secondsSince(start);
+    return stats;
+}
+
+bool findDocuments(OracleConnection& conn,
+                   std::string_view collection,
+                   std::string_view filter,
+                   uint32_t limit,
+                   ResultSet& out) {
+    auto coll = conn.sodaDatabase().openCollection(collection);
+    OracleSodaCollection::FindOpts findOpts;
+    findOpts.filter = filter;
+    // Ask for one extra document to find out whether there are more.
+    findOpts.limit = limit + 1;
+    findOpts.fetchArraySize = findOpts.limit;
+    auto cursor = coll.find(findOpts);
+
+    out.clear();
+    const auto keyColumn = out.addColumn("KEY", ResultSet::ColumnType::Text);
+    const auto contentColumn = out.addColumn("CONTENT", ResultSet::ColumnType::Text);
+    while (auto doc = cursor.next()) {
+        if (out.numRows() == limit) {
+            return true;
+        }
+        out.appendText(keyColumn, doc->key());
+        out.appendText(contentColumn, doc->content());
+        out.finishRow();
+    }
+    return false;
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "oracle_helpers.h"
+#include "result_set.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+struct SodaLoadOptions {
+    // Number of documents sent to the database by each insertMany call.
+    uint32_t batchSize = 1000;
+    // Create the collection if it doesn't exist yet.
+    bool create = true;
+};
+
+struct SodaDumpOptions {
+    // A SODA query-by-example filter, empty dumps every document.
+    std::string_view filter;
+    uint32_t fetchArraySize = 1000;
+};
+
+struct SodaTransferStats {
+    uint64_t documents = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+// Inserts every non-blank line of path (one JSON document per line) into the collection.
+// Each batch is inserted in one round trip and committed atomically, so a failure leaves
+// the earlier batches committed and none of the failing batch.
+SodaTransferStats loadDocuments(OracleConnection& conn,
+                                std::string_view collection,
+                                const std::string& path,
+                                const SodaLoadOptions& opts);
+
+// Streams the matching documents of the collection to path, one per line.
+SodaTransferStats dumpDocuments(OracleConnection& conn,
+                                std::string_view collection,
+                                const std::string& path,
+                                const SodaDumpOptions& opts);
+
+// Replaces the contents of out with the key and content of up to limit matching documents.
+// Returns whether more documents matched than were fetched.
+bool findDocuments(OracleConnection& conn,
+                   std::string_view collection,
+                   std::string_view filter,
+                   uint32_t limit,
+                   ResultSet& out);
+
+} // namespace sqlplusplus
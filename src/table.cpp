@@ -1,14 +1,17 @@
 #include "table.h"
 
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <limits>
+#include <stdexcept>
 
 #include "fmt/format.h"
 
 namespace sqlplusplus {
 
-Table::Table(Width numColumns) :
-    columns(numColumns)
+Table::Table(Width numColumns, std::pmr::memory_resource* resource) :
+    values(resource),
+    columns(numColumns, resource)
 {}
 
 Table::RowIndex Table::addRow() {
@@ -32,17 +35,17 @@ size_t Table::_resolveValueIdx(RowIndex row, Width column) const {
     return (row * columns.size()) + column;
 }
 
-const std::string& Table::columnValue(RowIndex row, Width column) const {
+std::string_view Table::columnValue(RowIndex row, Width column) const {
     return values.at(_resolveValueIdx(row, column));
 }
 
-void Table::setColumnValue(RowIndex row, Width column, std::string value) {
+void Table::setColumnValue(RowIndex row, Width column, std::string_view value) {
     if (value.size() > std::numeric_limits<Width>::max()) {
         throw std::runtime_error("table value width over flow");
     }
 
     auto& strValue = values.at(_resolveValueIdx(row, column));
-    strValue = std::move(value);
+    strValue.assign(value);
     auto& colInfo = columns.at(column);
     colInfo.minValueWidth = std::min(colInfo.minValueWidth, static_cast<Width>(strValue.size()));
     colInfo.maxValueWidth = std::max(colInfo.maxValueWidth, static_cast<Width>(strValue.size()));
@@ -53,75 +56,69 @@ void Table::render(std::ostream& out) {
         return;
     }
 
-    for (RowIndex rowIndex = 0; rowIndex < numRows; ++rowIndex) {
-        const auto& borders = (rowIndex == 0) ? firstRowBorders : otherRowBorders;
-        out << borders.left;
+    // Each row, including its wrapped lines, is built up in one buffer and written out in
+    // one go. Wrapped segments are views into the values, so nothing is copied per cell.
+    auto* resource = values.get_allocator().resource();
+    std::pmr::string buffer(resource);
+    std::pmr::vector<Width> widths(resource);
+    widths.reserve(columns.size());
+    for (const auto& columnInfo : columns) {
+        widths.push_back(std::max(columnInfo.configuredWidth, columnInfo.maxValueWidth));
+    }
+
+    auto appendBorder = [&](const CellBorder& borders) {
+        buffer.append(borders.left);
         for (Width colIndex = 0; colIndex < columns.size(); ++colIndex) {
-            const auto& columnInfo = columns.at(colIndex);
-            const auto columnWidth = std::max(columnInfo.configuredWidth, columnInfo.maxValueWidth);
             if (colIndex != 0) {
-                out << borders.divider;
+                buffer.append(borders.divider);
             }
-            for (Width idx = 0; idx < columnWidth + (padding * 2); ++idx) {
-                out << borders.rowBorder;
+            for (Width idx = 0; idx < widths[colIndex] + (padding * 2); ++idx) {
+                buffer.append(borders.rowBorder);
             }
         }
-        out << borders.right << "\n";
+        buffer.append(borders.right);
+        buffer.push_back('\n');
+    };
+
+    std::pmr::vector<std::string_view> remaining(columns.size(), resource);
+    for (RowIndex rowIndex = 0; rowIndex < numRows; ++rowIndex) {
+        const auto& borders = (rowIndex == 0) ? firstRowBorders : otherRowBorders;
+        appendBorder(borders);
+
+        for (Width colIndex = 0; colIndex < columns.size(); ++colIndex) {
+            remaining[colIndex] = columnValue(rowIndex, colIndex);
+        }
 
-        std::map<Width, std::string> remainingFromCurrentRow;
         bool hasIncompleteRows;
         do {
             hasIncompleteRows = false;
             for (Width colIndex = 0; colIndex < columns.size(); ++colIndex) {
-                const auto& columnInfo = columns.at(colIndex);
-                const auto columnWidth = std::max(columnInfo.configuredWidth, columnInfo.maxValueWidth);
-                std::string ownedCurrentWrappedSegment;
-                const auto& value = [&]{
-                    if (remainingFromCurrentRow.find(colIndex) == remainingFromCurrentRow.end()) {
-                        const auto& fullValue = columnValue(rowIndex, colIndex);
-                        auto newLineAt = fullValue.find_first_of("\n");
-                        if (newLineAt == std::string::npos) {
-                            remainingFromCurrentRow[colIndex] = "";
-                            return fullValue;
-                        }
-
-                        ownedCurrentWrappedSegment = fullValue.substr(0, newLineAt);
-                        remainingFromCurrentRow.insert({colIndex, fullValue.substr(newLineAt + 1)});
-                        hasIncompleteRows = true;
-                    } else {
-                        const auto& remaining = remainingFromCurrentRow[colIndex];
-                        auto newlineAt = remaining.find_first_of("\n");
-                        if (newlineAt != std::string::npos) {
-                            ownedCurrentWrappedSegment = remaining.substr(0, newlineAt);
-                            remainingFromCurrentRow[colIndex] = remaining.substr(newlineAt + 1);
-                            hasIncompleteRows = true;
-                        } else {
-                            ownedCurrentWrappedSegment = remaining;
-                            remainingFromCurrentRow[colIndex] = "";
-                        }
-                    }
-                    
-                    return ownedCurrentWrappedSegment;
-                }();
-                fmt::print("{0}{1: >{2}}{3}{1: >{4}}",
-                        borders.cellBorder, "", padding, value, (columnWidth - value.size()) + padding);
+                auto& rest = remaining[colIndex];
+                const auto newLineAt = rest.find('\n');
+                const auto segment = rest.substr(0, newLineAt);
+                if (newLineAt == std::string_view::npos) {
+                    rest = std::string_view();
+                } else {
+                    rest = rest.substr(newLineAt + 1);
+                    hasIncompleteRows = true;
+                }
+
+                buffer.append(borders.cellBorder);
+                buffer.append(padding, ' ');
+                buffer.append(segment);
+                buffer.append((widths[colIndex] - segment.size()) + padding, ' ');
             }
-            out << borders.cellBorder << "\n";
+            buffer.append(borders.cellBorder);
+            buffer.push_back('\n');
         } while(hasIncompleteRows);
+
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
     }
-   
-    out << lastRowBorders.left;
-    for (Width colIndex = 0; colIndex < columns.size(); ++colIndex) {
-        if (colIndex != 0) {
-            std::cout << lastRowBorders.divider;
-        }
-        const auto& columnInfo = columns.at(colIndex);
-        const auto columnWidth = std::max(columnInfo.configuredWidth, columnInfo.maxValueWidth);
-        for (Width idx = 0; idx < columnWidth + (padding * 2); ++idx) {
-            out << lastRowBorders.rowBorder;
-        }
-    }
-    out << lastRowBorders.right << std::endl;
+
+    appendBorder(lastRowBorders);
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
 }
 
 } // namespace sqlplusplus
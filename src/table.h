@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace sqlplusplus {
@@ -15,17 +17,16 @@ public:
         Width configuredWidth = 0;
     };
 
-    explicit Table(Width numColumns);
+    // Every value and rendering temporary is allocated from resource, e.g. an arena that
+    // is released once the table has been rendered.
+    explicit Table(Width numColumns, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     RowIndex addRow();
-    const std::string& columnValue(RowIndex row, Width column) const;
-    void setColumnValue(RowIndex row, Width column, std::string value);
-    void setColumnValue(RowIndex row, Width column, std::string_view value) {
-        setColumnValue(row, column, std::string(value));
-    }
-
-    std::vector<std::string> values;
-    std::vector<Column> columns;
+    std::string_view columnValue(RowIndex row, Width column) const;
+    void setColumnValue(RowIndex row, Width column, std::string_view value);
+
+    std::pmr::vector<std::pmr::string> values;
+    std::pmr::vector<Column> columns;
     RowIndex numRows = 0;
 
     struct CellBorder {
@@ -0,0 +1,750 @@
+#include "table_load.h"
+#include "arrow_reader.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+// Longest value a VARCHAR bind can hold.
+constexpr uint32_t kMaxBindSize = 32767;
+
+bool isNumberType(dpiOracleTypeNum oracleType) {
+    return oracleType == DPI_ORACLE_TYPE_NUMBER || oracleType == DPI_ORACLE_TYPE_NATIVE_DOUBLE ||
+        oracleType == DPI_ORACLE_TYPE_NATIVE_FLOAT;
+}
+
+// Set when a load starts, a failed load rolls back to it until its first commit.
+constexpr auto kLoadSavepoint = "sqlplusplus_load";
+
+// Decimal128 values as text. The longest is a sign, "0." and kMaxNumberScale digits; a
+// sign, 39 digits and a point or an exponent are shorter.
+constexpr uint32_t kMaxDecimalSize = 3 + kMaxNumberScale;
+
+// The bind variable for one column, recreated with room for longer values when a batch
+// needs it.
+struct ColumnBind {
+    dpiOracleTypeNum oracleType = DPI_ORACLE_TYPE_VARCHAR;
+    dpiNativeTypeNum nativeType = DPI_NATIVE_TYPE_BYTES;
+    uint32_t capacity = 0;
+    std::optional<OracleVariable> var;
+};
+
+// Makes sure bind has a variable with room for values of needed bytes, (re)binding it at
+// position pos of stmt when it has to be created.
+void ensureCapacity(OracleConnection& conn,
+                    OracleStatement& stmt,
+                    uint32_t pos,
+                    ColumnBind& bind,
+                    uint32_t needed,
+                    uint32_t maxArraySize) {
+    if (bind.var && needed <= bind.capacity) {
+        return;
+    }
+    bind.capacity = std::min(kMaxBindSize, std::max({needed, bind.capacity * 2, 16u}));
+    OracleConnection::VariableOpts varOpts;
+    varOpts.dbTypeNum = bind.oracleType;
+    varOpts.nativeTypeNum = bind.nativeType;
+    varOpts.maxArraySize = maxArraySize;
+    varOpts.opts = OracleConnection::VariableOpts::ByteBufferOpts{bind.capacity, true};
+    bind.var = conn.newArrayVariable(varOpts);
+    stmt.bindByPos(pos, *bind.var);
+}
+
+void bindTypeFor(const ArrowField& field, ColumnBind& bind) {
+    switch (field.type) {
+    case ArrowField::Type::Int:
+    case ArrowField::Type::Bool:
+        bind.oracleType = DPI_ORACLE_TYPE_NUMBER;
+        bind.nativeType = field.bitWidth == 64 && !field.isSigned ? DPI_NATIVE_TYPE_UINT64 : DPI_NATIVE_TYPE_INT64;
+        break;
+    case ArrowField::Type::FloatingPoint:
+        bind.oracleType = field.bitWidth == 32 ? DPI_ORACLE_TYPE_NATIVE_FLOAT : DPI_ORACLE_TYPE_NATIVE_DOUBLE;
+        bind.nativeType = field.bitWidth == 32 ? DPI_NATIVE_TYPE_FLOAT : DPI_NATIVE_TYPE_DOUBLE;
+        break;
+    case ArrowField::Type::Decimal:
+        bind.oracleType = DPI_ORACLE_TYPE_NUMBER;
+        break;
+    case ArrowField::Type::Binary:
+    case ArrowField::Type::LargeBinary:
+        bind.oracleType = DPI_ORACLE_TYPE_RAW;
+        break;
+    case ArrowField::Type::Date:
+        bind.oracleType = DPI_ORACLE_TYPE_DATE;
+        bind.nativeType = DPI_NATIVE_TYPE_TIMESTAMP;
+        break;
+    case ArrowField::Type::Timestamp:
+        bind.oracleType = field.hasTimezone ? DPI_ORACLE_TYPE_TIMESTAMP_TZ : DPI_ORACLE_TYPE_TIMESTAMP;
+        bind.nativeType = DPI_NATIVE_TYPE_TIMESTAMP;
+        break;
+    default:
+        break;
+    }
+}
+
+// Converts a time since the Unix epoch to a UTC timestamp, using Howard Hinnant's
+// days-to-civil algorithm.
+dpiTimestamp timestampFromEpoch(int64_t seconds, uint32_t nanoseconds) {
+    auto days = seconds / 86400;
+    auto secondOfDay = seconds % 86400;
+    if (secondOfDay < 0) {
+        secondOfDay += 86400;
+        --days;
+    }
+
+    days += 719468;
+    const auto era = (days >= 0 ? days : days - 146096) / 146097;
+    const auto dayOfEra = days - era * 146097;
+    const auto yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const auto dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const auto monthIndex = (5 * dayOfYear + 2) / 153;
+    const auto month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+
+    dpiTimestamp out{};
+    out.year = static_cast<int16_t>(yearOfEra + era * 400 + (month <= 2));
+    out.month = static_cast<uint8_t>(month);
+    out.day = static_cast<uint8_t>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    out.hour = static_cast<uint8_t>(secondOfDay / 3600);
+    out.minute = static_cast<uint8_t>(secondOfDay / 60 % 60);
+    out.second = static_cast<uint8_t>(secondOfDay % 60);
+    out.fsecond = nanoseconds;
+    return out;
+}
+
+// Splits a count of units since the epoch into seconds and nanoseconds.
+dpiTimestamp timestampFromUnits(int64_t value, int64_t unitsPerSecond) {
+    auto seconds = value / unitsPerSecond;
+    auto remainder = value % unitsPerSecond;
+    if (remainder < 0) {
+        remainder += unitsPerSecond;
+        --seconds;
+    }
+    return timestampFromEpoch(seconds, static_cast<uint32_t>(remainder * (1000000000 / unitsPerSecond)));
+}
+
+size_t formatDecimal(char* out, size_t size, __int128 value, int32_t scale) {
+    char digits[48];
+    const bool negative = value < 0;
+    auto magnitude = negative ? -static_cast<unsigned __int128>(value) : static_cast<unsigned __int128>(value);
+    int numDigits = 0;
+    do {
+        digits[numDigits++] = static_cast<char>('0' + static_cast<int>(magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    // Oracle NUMBER text accepts an exponent, which keeps negative scales short.
+    const fmt::format_int exponent(scale < 0 ? -static_cast<int64_t>(scale) : 0);
+    size_t needed = negative ? 1 : 0;
+    if (scale < 0) {
+        needed += static_cast<size_t>(numDigits) + 1 + exponent.size();
+    } else if (scale == 0) {
+        needed += static_cast<size_t>(numDigits);
+    } else {
+        needed += static_cast<size_t>(numDigits <= scale ? 2 + scale : numDigits + 1);
+    }
+    if (needed > size) {
+        throw std::runtime_error(fmt::format("decimal with scale {} doesn't fit in {} characters", scale, size));
+    }
+
+    size_t len = 0;
+    if (negative) {
+        out[len++] = '-';
+    }
+    if (scale <= 0) {
+        while (numDigits > 0) {
+            out[len++] = digits[--numDigits];
+        }
+        if (scale < 0) {
+            out[len++] = 'e';
+            len = std::copy_n(exponent.data(), exponent.size(), out + len) - out;
+        }
+        return len;
+    }
+
+    if (numDigits <= scale) {
+        out[len++] = '0';
+        out[len++] = '.';
+        for (int pad = numDigits; pad < scale; ++pad) {
+            out[len++] = '0';
+        }
+        while (numDigits > 0) {
+            out[len++] = digits[--numDigits];
+        }
+        return len;
+    }
+    while (numDigits > 0) {
+        if (numDigits == scale) {
+            out[len++] = '.';
+        }
+        out[len++] = digits[--numDigits];
+    }
+    return len;
+}
+
+// Copies rows [first, first + numRows) of array into the start of the variable's
+// elements. Fixed-width values are converted straight into the dpiData array, variable
+// width ones are copied into the variable's buffers by setFrom.
+void fillColumn(const ArrowField& field,
+                const ArrowArray& array,
+                OracleVariable& var,
+                uint64_t first,
+                uint32_t numRows) {
+    auto elements = var.elements();
+    auto forEachValid = [&](auto setValue) {
+        for (uint32_t row = 0; row < numRows; ++row) {
+            auto& element = elements[row];
+            element.isNull = field.type == ArrowField::Type::Null || !array.isValid(first + row);
+            if (!element.isNull) {
+                setValue(element, first + row);
+            }
+        }
+    };
+
+    switch (field.type) {
+    case ArrowField::Type::Null:
+        forEachValid([](dpiData&, uint64_t) {});
+        break;
+    case ArrowField::Type::Int: {
+        auto toInt64 = [&](uint64_t idx) -> int64_t {
+            switch (field.bitWidth) {
+            case 8:
+                return field.isSigned ? array.valueAt<int8_t>(idx) : array.valueAt<uint8_t>(idx);
+            case 16:
+                return field.isSigned ? array.valueAt<int16_t>(idx) : array.valueAt<uint16_t>(idx);
+            case 32:
+                return field.isSigned ? array.valueAt<int32_t>(idx) : array.valueAt<uint32_t>(idx);
+            default:
+                return array.valueAt<int64_t>(idx);
+            }
+        };
+        if (field.bitWidth == 64 && !field.isSigned) {
+            forEachValid([&](dpiData& element, uint64_t idx) {
+                element.value.asUint64 = array.valueAt<uint64_t>(idx);
+            });
+        } else {
+            forEachValid([&](dpiData& element, uint64_t idx) {
+                element.value.asInt64 = toInt64(idx);
+            });
+        }
+        break;
+    }
+    case ArrowField::Type::Bool:
+        forEachValid([&](dpiData& element, uint64_t idx) {
+            element.value.asInt64 = (array.values[idx / 8] >> (idx % 8)) & 1;
+        });
+        break;
+    case ArrowField::Type::FloatingPoint:
+        if (field.bitWidth == 32) {
+            forEachValid([&](dpiData& element, uint64_t idx) {
+                element.value.asFloat = array.valueAt<float>(idx);
+            });
+        } else {
+            forEachValid([&](dpiData& element, uint64_t idx) {
+                element.value.asDouble = array.valueAt<double>(idx);
+            });
+        }
+        break;
+    case ArrowField::Type::Date:
+        if (field.unit == ArrowField::TimeUnit::Day) {
+            forEachValid([&](dpiData& element, uint64_t idx) {
+                element.value.asTimestamp = timestampFromEpoch(int64_t{array.valueAt<int32_t>(idx)} * 86400, 0);
+            });
+        } else {
+            forEachValid([&](dpiData& element, uint64_t idx) {
+                element.value.asTimestamp = timestampFromUnits(array.valueAt<int64_t>(idx), 1000);
+            });
+        }
+        break;
+    case ArrowField::Type::Timestamp: {
+        constexpr int64_t kUnitsPerSecond[] = {1, 1000, 1000000, 1000000000};
+        const auto unitsPerSecond = kUnitsPerSecond[static_cast<int>(field.unit)];
+        forEachValid([&](dpiData& element, uint64_t idx) {
+            element.value.asTimestamp = timestampFromUnits(array.valueAt<int64_t>(idx), unitsPerSecond);
+        });
+        break;
+    }
+    case ArrowField::Type::Decimal:
+        forEachValid([&](dpiData&, uint64_t idx) {
+            char text[kMaxDecimalSize];
+            const auto len = formatDecimal(text, sizeof(text), array.valueAt<__int128>(idx), field.scale);
+            var.setFrom(static_cast<uint32_t>(idx - first), std::string_view(text, len));
+        });
+        break;
+    case ArrowField::Type::Binary:
+    case ArrowField::Type::Utf8:
+        forEachValid([&](dpiData&, uint64_t idx) {
+            var.setFrom(static_cast<uint32_t>(idx - first), array.bytesAt<int32_t>(idx));
+        });
+        break;
+    case ArrowField::Type::LargeBinary:
+    case ArrowField::Type::LargeUtf8:
+        forEachValid([&](dpiData&, uint64_t idx) {
+            var.setFrom(static_cast<uint32_t>(idx - first), array.bytesAt<int64_t>(idx));
+        });
+        break;
+    }
+}
+
+// The longest variable-width value in rows [first, first + numRows) of array.
+template <typename OffsetType>
+uint64_t maxValueSize(const ArrowArray& array, uint64_t first, uint32_t numRows) {
+    uint64_t out = 0;
+    for (uint64_t idx = first; idx < first + numRows; ++idx) {
+        out = std::max<uint64_t>(out, array.bytesAt<OffsetType>(idx).size());
+    }
+    return out;
+}
+// The owner and name of table as the data dictionary stores them: unquoted parts are
+// upper-cased, and the owner is empty when table doesn't name one.
+std::pair<std::string, std::string> dictionaryName(std::string_view table) {
+    auto part = [](std::string_view text) {
+        if (text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+            return std::string(text.substr(1, text.size() - 2));
+        }
+        std::string out(text);
+        std::transform(out.begin(), out.end(), out.begin(), [](unsigned char ch) {
+            return static_cast<char>(std::toupper(ch));
+        });
+        return out;
+    };
+
+    bool inQuotes = false;
+    for (size_t idx = 0; idx < table.size(); ++idx) {
+        if (table[idx] == '"') {
+            inQuotes = !inQuotes;
+        } else if (table[idx] == '.' && !inQuotes) {
+            return {part(table.substr(0, idx)), part(table.substr(idx + 1))};
+        }
+    }
+    return {std::string(), part(table)};
+}
+
+// The part of a load shared by every input format: the insert statement, when to commit,
+// and the table settings changed for the length of the load.
+class TableInserter {
+public:
+    TableInserter(OracleConnection& conn,
+                  std::string_view table,
+                  std::string_view columnList,
+                  size_t numColumns,
+                  const TableLoadOptions& opts,
+                  Checkpoint* checkpoint,
+                  std::ostream& errors)
+        : _conn(conn),
+          _table(table),
+          _opts(opts),
+          _checkpoint(checkpoint),
+          _errors(errors),
+          _start(std::chrono::steady_clock::now())
+    {
+        if (checkpoint && checkpoint->resumed()) {
+            _stats.rows = checkpoint->getNumber("rows");
+            _stats.rejected = checkpoint->getNumber("rejected");
+            _stats.batches = checkpoint->getNumber("batches");
+            _stats.commits = checkpoint->getNumber("commits");
+            _stats.resumedRows = rowsDone();
+        }
+
+        // These commit on their own, which would end whatever the session was in the middle of.
+        if ((opts.directPath || opts.noLogging || opts.deferIndexes) && conn.transactionInProgress()) {
+            throw std::runtime_error("direct, nologging and deferindexes loads commit as they go, "
+                                     "commit or roll back the open transaction first");
+        }
+
+        std::string placeholders;
+        for (size_t idx = 0; idx < numColumns; ++idx) {
+            fmt::format_to(std::back_inserter(placeholders), "{}:{}", idx == 0 ? "" : ", ", idx + 1);
+        }
+        _insert.emplace(conn.prepareStatement(fmt::format("insert {}into {} ({}) values ({})",
+                                                          opts.directPath ? "/*+ APPEND_VALUES */ " : "",
+                                                          table, columnList, placeholders)));
+        if (opts.noLogging || opts.deferIndexes) {
+            _prepareTable();
+        }
+        // Lets a failed load undo its own rows without touching changes the session made
+        // before it.
+        conn.prepareStatement(fmt::format("savepoint {}", kLoadSavepoint)).execute();
+    }
+
+    TableInserter(const TableInserter&) = delete;
+    TableInserter& operator=(const TableInserter&) = delete;
+
+    // Rolls back the rows inserted since the last commit after a failed load, so that a
+    // later commit doesn't keep rows the checkpoint says still have to be loaded, and
+    // puts the table settings back.
+    ~TableInserter() {
+        if (_finished) {
+            return;
+        }
+        try {
+            if (_committed) {
+                _conn.rollback();
+            } else {
+                _conn.prepareStatement(fmt::format("rollback to savepoint {}", kLoadSavepoint)).execute();
+            }
+            if (_loggingChanged || !_unusableIndexes.empty()) {
+                _restoreTable();
+            }
+        } catch (const std::exception& ex) {
+            _errors << ex.what() << std::endl;
+        }
+    }
+
+    void ensureCapacity(size_t column, ColumnBind& bind, uint32_t needed) {
+        sqlplusplus::ensureCapacity(_conn, *_insert, static_cast<uint32_t>(column + 1), bind, needed,
+                                    _opts.batchRows);
+    }
+
+    // The number of rows inserted or rejected so far.
+    uint64_t rowsDone() const noexcept {
+        return _stats.rows + _stats.rejected;
+    }
+
+    // Inserts the first numRows elements of the bound variables. rowName(offset) names
+    // the row at that offset in the batch when reporting that it was rejected. Returns
+    // whether the rows were committed, after which the caller records its position in
+    // the input with saveCheckpoint.
+    template <typename RowName>
+    bool insert(uint32_t numRows, RowName rowName) {
+        if (_opts.directPath) {
+            // Oracle doesn't allow batch errors with APPEND_VALUES (ORA-38910), so one bad row
+            // fails its whole batch and the load.
+            try {
+                _insert->executeMany(numRows);
+            } catch (const OracleException& ex) {
+                throw std::runtime_error(fmt::format("direct-path insert of the rows from {} to {} failed: {}",
+                                                     rowName(0), rowName(numRows - 1), ex.what()));
+            }
+        } else {
+            _insert->executeMany(numRows, true);
+        }
+        ++_stats.batches;
+        const auto inserted = _insert->rowCount();
+        for (const auto& error : _insert->batchErrors()) {
+            if (_stats.rejected++ < _opts.maxReportedErrors) {
+                _errors << fmt::format("{}: {}", rowName(error.info().offset), error.what()) << std::endl;
+            }
+        }
+        _stats.rows += inserted;
+
+        _uncommitted += numRows;
+        const bool commitEachBatch = _opts.directPath || (_checkpoint && _opts.commitRows == 0);
+        if (commitEachBatch || (_opts.commitRows != 0 && _uncommitted >= _opts.commitRows)) {
+            _commit();
+            return true;
+        }
+        return false;
+    }
+
+    // Saves the checkpoint, if there is one, with the counts so far. The caller sets
+    // where the next input row is first.
+    void saveCheckpoint() {
+        if (!_checkpoint) {
+            return;
+        }
+        _checkpoint->set("rows", _stats.rows);
+        _checkpoint->set("rejected", _stats.rejected);
+        _checkpoint->set("batches", _stats.batches);
+        _checkpoint->set("commits", _stats.commits);
+        _checkpoint->save();
+    }
+
+    // Commits the rest, then rebuilds the deferred indexes and turns logging back on.
+    TableLoadStats finish(uint64_t bytes) {
+        if (_uncommitted != 0) {
+            _commit();
+        }
+        _finished = true;
+        if (_checkpoint) {
+            _checkpoint->remove();
+        }
+        _restoreTable();
+
+        if (_stats.rejected > _opts.maxReportedErrors) {
+            _errors << fmt::format("{} more rows rejected", _stats.rejected - _opts.maxReportedErrors) << std::endl;
+        }
+        _stats.bytes = bytes;
+        _stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+        return _stats;
+    }
+
+private:
+    void _commit() {
+        _conn.commit();
+        ++_stats.commits;
+        _uncommitted = 0;
+        _committed = true;
+    }
+
+    void _prepareTable() {
+        const auto [owner, name] = dictionaryName(_table);
+        OracleConnection::VariableOpts varOpts;
+        varOpts.opts = OracleConnection::VariableOpts::ByteBufferOpts{128, true};
+        auto ownerVar = _conn.newArrayVariable(varOpts);
+        auto nameVar = _conn.newArrayVariable(varOpts);
+        if (owner.empty()) {
+            ownerVar.setNull(0);
+        } else {
+            ownerVar.setFrom(0, owner);
+        }
+        nameVar.setFrom(0, name);
+
+        constexpr auto kOwnerIs = "owner = nvl(:1, sys_context('userenv', 'current_schema'))";
+        bool wasLogging = false;
+        if (_opts.noLogging) {
+            auto logging = _conn.prepareStatement(fmt::format(
+                    "select logging from all_tables where {} and table_name = :2", kOwnerIs));
+            logging.bindByPos(1, ownerVar);
+            logging.bindByPos(2, nameVar);
+            logging.execute();
+            wasLogging = logging.fetch() && !logging.getColumnValue(1).isNull() &&
+                logging.getColumnValue(1).as<std::string_view>() == "YES";
+        }
+        if (_opts.deferIndexes) {
+            auto indexes = _conn.prepareStatement(fmt::format(
+                    "select owner, index_name from all_indexes "
+                    "where table_{} and table_name = :2 and uniqueness = 'NONUNIQUE' "
+                    "and partitioned = 'NO' and status = 'VALID' "
+                    "and index_type in ('NORMAL', 'NORMAL/REV', 'BITMAP', "
+                    "'FUNCTION-BASED NORMAL', 'FUNCTION-BASED BITMAP')",
+                    kOwnerIs));
+            indexes.bindByPos(1, ownerVar);
+            indexes.bindByPos(2, nameVar);
+            indexes.execute();
+            while (indexes.fetch()) {
+                _unusableIndexes.push_back(fmt::format("\"{}\".\"{}\"",
+                                                       indexes.getColumnValue(1).as<std::string_view>(),
+                                                       indexes.getColumnValue(2).as<std::string_view>()));
+            }
+        }
+
+        // Only the settings changed so far are put back if one of the changes fails.
+        std::vector<std::string> indexes;
+        indexes.swap(_unusableIndexes);
+        try {
+            if (wasLogging) {
+                _conn.prepareStatement(fmt::format("alter table {} nologging", _table)).execute();
+                _loggingChanged = true;
+            }
+            for (auto& index : indexes) {
+                _conn.prepareStatement(fmt::format("alter index {} unusable", index)).execute();
+                _unusableIndexes.push_back(std::move(index));
+            }
+        } catch (const std::exception&) {
+            _restoreTable();
+            throw;
+        }
+    }
+
+    // Rebuilds every index that was made unusable even if some fail, then throws the
+    // first failure.
+    void _restoreTable() {
+        std::optional<std::runtime_error> failure;
+        auto run = [&](const std::string& sql) {
+            try {
+                _conn.prepareStatement(sql).execute();
+                return true;
+            } catch (const std::exception& ex) {
+                if (!failure) {
+                    failure.emplace(fmt::format("{} failed: {}", sql, ex.what()));
+                }
+                return false;
+            }
+        };
+
+        for (const auto& index : _unusableIndexes) {
+            _stats.indexesRebuilt += run(fmt::format("alter index {} rebuild", index));
+        }
+        _unusableIndexes.clear();
+        if (_loggingChanged) {
+            run(fmt::format("alter table {} logging", _table));
+            _loggingChanged = false;
+        }
+        if (failure) {
+            throw *failure;
+        }
+    }
+
+    OracleConnection& _conn;
+    std::string _table;
+    const TableLoadOptions& _opts;
+    Checkpoint* _checkpoint;
+    std::ostream& _errors;
+    std::chrono::steady_clock::time_point _start;
+    std::optional<OracleStatement> _insert;
+    TableLoadStats _stats;
+    uint64_t _uncommitted = 0;
+    bool _finished = false;
+    // Whether this load has committed, which also ends the transaction holding the savepoint.
+    bool _committed = false;
+    bool _loggingChanged = false;
+    std::vector<std::string> _unusableIndexes;
+};
+} // namespace
+
+TableLoadStats loadCsv(OracleConnection& conn,
+                       std::string_view table,
+                       const std::string& path,
+                       const CsvOptions& csvOpts,
+                       const TableLoadOptions& opts,
+                       std::ostream& errors) {
+    CsvReader reader(path, csvOpts);
+    const auto numColumns = reader.numColumns();
+
+    // Describe the target columns to find out which ones are numbers.
+    std::string columnList;
+    if (csvOpts.header) {
+        for (const auto& name : reader.columnNames()) {
+            fmt::format_to(std::back_inserter(columnList), "{}{}", columnList.empty() ? "" : ", ", name);
+        }
+    }
+    auto describe = conn.prepareStatement(
+            fmt::format("select {} from {} where 1 = 0", columnList.empty() ? "*" : columnList, table));
+    describe.execute();
+    if (describe.numColumns() != numColumns) {
+        throw std::runtime_error(fmt::format("{} has {} columns but the file has {}",
+                                             table, describe.numColumns(), numColumns));
+    }
+
+    std::vector<ColumnBind> binds(numColumns);
+    for (size_t idx = 0; idx < numColumns; ++idx) {
+        const auto& info = describe.columns()[idx];
+        if (isNumberType(info.oracleType())) {
+            binds[idx].oracleType = DPI_ORACLE_TYPE_NUMBER;
+        }
+        if (!csvOpts.header) {
+            fmt::format_to(std::back_inserter(columnList), "{}\"{}\"", idx == 0 ? "" : ", ", info.name());
+        }
+    }
+
+    std::optional<Checkpoint> checkpoint;
+    if (opts.checkpoint) {
+        checkpoint.emplace(Checkpoint::pathFor(path));
+        checkpoint->expect("table", table);
+        checkpoint->expect("size", std::to_string(reader.fileSize()));
+        if (checkpoint->resumed()) {
+            reader.resumeAt({checkpoint->getNumber("offset"), checkpoint->getNumber("line")});
+        }
+    }
+
+    TableInserter inserter(conn, table, columnList, numColumns, opts, checkpoint ? &*checkpoint : nullptr, errors);
+    auto loadRows = [&](const CsvBatch& batch, size_t firstRow, uint32_t numRows) {
+        for (size_t column = 0; column < numColumns; ++column) {
+            auto& bind = binds[column];
+            const auto needed = batch.maxSize(column, firstRow, firstRow + numRows);
+            if (needed > kMaxBindSize) {
+                throw std::runtime_error(fmt::format("value in column {} near line {} is longer than {} bytes",
+                                                     reader.columnNames()[column], batch.line(firstRow), kMaxBindSize));
+            }
+            inserter.ensureCapacity(column, bind, needed);
+
+            for (uint32_t row = 0; row < numRows; ++row) {
+                if (batch.isNull(column, firstRow + row)) {
+                    bind.var->setNull(row);
+                } else {
+                    bind.var->setFrom(row, batch.value(column, firstRow + row));
+                }
+            }
+        }
+
+        const bool committed = inserter.insert(numRows, [&](uint32_t offset) {
+            return fmt::format("Line {}", batch.line(firstRow + offset));
+        });
+        if (committed && checkpoint) {
+            const auto next = batch.position(firstRow + numRows);
+            checkpoint->set("offset", next.offset);
+            checkpoint->set("line", next.line);
+            inserter.saveCheckpoint();
+        }
+    };
+
+    auto window = reader.next();
+    while (window) {
+        auto pending = std::async(std::launch::async, [&reader] {
+            return reader.next();
+        });
+        for (const auto& batch : *window) {
+            for (size_t first = 0; first < batch.numRows(); first += opts.batchRows) {
+                loadRows(batch, first, static_cast<uint32_t>(std::min<size_t>(opts.batchRows, batch.numRows() - first)));
+            }
+        }
+        window = pending.get();
+    }
+    return inserter.finish(reader.fileSize());
+}
+
+TableLoadStats loadArrow(OracleConnection& conn,
+                         std::string_view table,
+                         const std::string& path,
+                         const TableLoadOptions& opts,
+                         std::ostream& errors) {
+    ArrowStreamReader reader(path);
+    const auto& fields = reader.fields();
+
+    std::string columnList;
+    std::vector<ColumnBind> binds(fields.size());
+    for (size_t idx = 0; idx < fields.size(); ++idx) {
+        fmt::format_to(std::back_inserter(columnList), "{}{}", idx == 0 ? "" : ", ", fields[idx].name);
+        bindTypeFor(fields[idx], binds[idx]);
+    }
+
+    std::optional<Checkpoint> checkpoint;
+    if (opts.checkpoint) {
+        checkpoint.emplace(Checkpoint::pathFor(path));
+        checkpoint->expect("table", table);
+        checkpoint->expect("size", std::to_string(reader.fileSize()));
+    }
+
+    TableInserter inserter(conn, table, columnList, fields.size(), opts, checkpoint ? &*checkpoint : nullptr, errors);
+    // Record batches are skipped by reading only their metadata.
+    auto skipRows = inserter.rowsDone();
+    while (auto batch = reader.next()) {
+        const auto skipped = std::min(skipRows, batch->numRows);
+        skipRows -= skipped;
+        for (uint64_t first = skipped; first < batch->numRows; first += opts.batchRows) {
+            const auto numRows = static_cast<uint32_t>(std::min<uint64_t>(opts.batchRows, batch->numRows - first));
+            for (size_t column = 0; column < fields.size(); ++column) {
+                const auto& field = fields[column];
+                const auto& array = batch->columns[column];
+                uint64_t needed = 0;
+                if (field.type == ArrowField::Type::Decimal) {
+                    needed = kMaxDecimalSize;
+                } else if (field.type == ArrowField::Type::Utf8 || field.type == ArrowField::Type::Binary) {
+                    needed = maxValueSize<int32_t>(array, first, numRows);
+                } else if (field.type == ArrowField::Type::LargeUtf8 || field.type == ArrowField::Type::LargeBinary) {
+                    needed = maxValueSize<int64_t>(array, first, numRows);
+                }
+                if (needed > kMaxBindSize) {
+                    throw std::runtime_error(fmt::format("value in column {} of row {} is longer than {} bytes",
+                                                         field.name, inserter.rowsDone() + 1, kMaxBindSize));
+                }
+
+                auto& bind = binds[column];
+                inserter.ensureCapacity(column, bind, static_cast<uint32_t>(needed));
+                fillColumn(field, array, *bind.var, first, numRows);
+            }
+
+            const auto firstRow = inserter.rowsDone();
+            const bool committed = inserter.insert(numRows, [&](uint32_t offset) {
+                return fmt::format("Row {}", firstRow + offset + 1);
+            });
+            if (committed && checkpoint) {
+                checkpoint->set("row", inserter.rowsDone());
+                inserter.saveCheckpoint();
+            }
+        }
+    }
+    return inserter.finish(reader.fileSize());
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "csv_reader.h"
+#include "oracle_helpers.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+struct TableLoadOptions {
+    // Rows sent per executeMany.
+    uint32_t batchRows = 10000;
+    // Rejected rows beyond this many are counted but not printed.
+    uint32_t maxReportedErrors = 10;
+    // Commit after every this many rows instead of once at the end.
+    uint64_t commitRows = 0;
+    // Insert with the APPEND_VALUES hint, which writes each batch above the table's high
+    // water mark without going through the buffer cache and with next to no undo. Oracle
+    // doesn't let the table be touched again in the same transaction, so every batch is
+    // committed. Triggers and foreign keys on the table make Oracle ignore the hint.
+    // Rejected rows can't be skipped in this mode, the first one fails the load.
+    bool directPath = false;
+    // Switch the table to NOLOGGING for the load and back afterwards, so direct-path
+    // batches generate almost no redo. Data loaded this way can't be recovered from the
+    // redo logs until the next backup.
+    bool noLogging = false;
+    // Mark the table's non-unique, non-partitioned indexes unusable for the load and
+    // rebuild them at the end, which relies on SKIP_UNUSABLE_INDEXES being true (the
+    // default). Unique indexes are always maintained, since Oracle can't skip them.
+    bool deferIndexes = false;
+    // Record the position of every commit in a checkpoint file next to the input (see
+    // Checkpoint), and carry on from it when one is left by an earlier run. Without
+    // commitRows every batch is committed. A run that dies between a commit and writing
+    // the checkpoint loads the rows of that commit again when resumed.
+    bool checkpoint = false;
+};
+
+struct TableLoadStats {
+    uint64_t rows = 0;
+    uint64_t rejected = 0;
+    uint64_t batches = 0;
+    uint64_t commits = 0;
+    uint64_t indexesRebuilt = 0;
+    // Rows inserted or rejected by earlier runs, when resuming from a checkpoint.
+    uint64_t resumedRows = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+// Inserts every row of a CSV file into table and commits. With a header line its names
+// pick the columns to fill, otherwise the file must have a value for every column of the
+// table, in order. NUMBER columns are converted on the client, other types use Oracle's
+// implicit conversion from text (so dates follow NLS_DATE_FORMAT). Rows the database
+// rejects are reported to errors with their line numbers and don't stop the load.
+//
+// The next window of the file is parsed while the current one is being inserted.
+//
+// Loads with directPath, noLogging or deferIndexes commit along the way and refuse to
+// start while the session has a transaction open.
+//
+// If the load fails, the rows it inserted since its last commit are rolled back. Changes
+// the session made before the load aren't rolled back, though the load's commits include them.
+TableLoadStats loadCsv(OracleConnection& conn,
+                       std::string_view table,
+                       const std::string& path,
+                       const CsvOptions& csvOpts,
+                       const TableLoadOptions& opts,
+                       std::ostream& errors);
+
+// Inserts every row of an Arrow IPC stream or file into table and commits, filling the
+// columns named in its schema. Values are written straight into the bind variables'
+// dpiData arrays in their native form: integers as INT64, floats as BINARY_FLOAT/DOUBLE,
+// dates and timestamps as TIMESTAMP and 128-bit decimals as NUMBER text. Timestamps
+// with a time zone are UTC.
+TableLoadStats loadArrow(OracleConnection& conn,
+                         std::string_view table,
+                         const std::string& path,
+                         const TableLoadOptions& opts,
+                         std::ostream& errors);
+
+} // namespace sqlplusplus
@@ -0,0 +1,514 @@
+#include "text_export.h"
+#include "checkpoint.h"
+#include "json_format.h"
+#include "object_format.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+constexpr size_t kFlushThreshold = 1 << 20;
+// Output written between checkpoints. Each one syncs the output file.
+constexpr uint64_t kCheckpointInterval = 64 << 20;
+// Large enough for any NUMBER or ROWID rendered as text.
+constexpr uint32_t kRawScalarSize = 64;
+
+// Whether the query has an ORDER BY outside any parentheses, skipping literals, quoted
+// identifiers and comments.
+bool hasOrderBy(std::string_view sql) {
+    auto isWordChar = [](char ch) {
+        return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '$' || ch == '#';
+    };
+    auto equalsIgnoreCase = [](std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char l, char r) {
+            return std::tolower(static_cast<unsigned char>(l)) == std::tolower(static_cast<unsigned char>(r));
+        });
+    };
+
+    int depth = 0;
+    std::string_view previous;
+    size_t pos = 0;
+    while (pos < sql.size()) {
+        const auto ch = sql[pos];
+        if (ch == '\'' || ch == '"') {
+            pos = std::min(sql.size(), sql.find(ch, pos + 1)) + 1;
+        } else if (sql.substr(pos, 2) == "--") {
+            pos = std::min(sql.size(), sql.find('\n', pos));
+        } else if (sql.substr(pos, 2) == "/*") {
+            pos = std::min(sql.size(), sql.find("*/", pos + 2)) + 2;
+        } else if (isWordChar(ch)) {
+            const auto start = pos;
+            while (pos < sql.size() && isWordChar(sql[pos])) {
+                ++pos;
+            }
+            const auto word = sql.substr(start, pos - start);
+            // ORDER SIBLINGS BY counts too.
+            if (depth == 0 && equalsIgnoreCase(word, "by") &&
+                (equalsIgnoreCase(previous, "order") || equalsIgnoreCase(previous, "siblings"))) {
+                return true;
+            }
+            previous = word;
+        } else {
+            depth += ch == '(' ? 1 : ch == ')' ? -1 : 0;
+            if (!std::isspace(static_cast<unsigned char>(ch))) {
+                previous = {};
+            }
+            ++pos;
+        }
+    }
+    return false;
+}
+
+class DelimitedWriter {
+public:
+    // With appendAt the file is truncated to that many bytes and written after them.
+    DelimitedWriter(const std::string& path, char delimiter, std::optional<uint64_t> appendAt = std::nullopt)
+        : _delimiter(delimiter)
+    {
+        if (appendAt && ::truncate(path.c_str(), static_cast<off_t>(*appendAt)) != 0) {
+            throw std::runtime_error(fmt::format("could not truncate {}: {}", path, std::strerror(errno)));
+        }
+        _file = std::fopen(path.c_str(), appendAt ? "ab" : "wb");
+        if (_file == nullptr) {
+            throw std::runtime_error(fmt::format("could not open {} for writing: {}", path, std::strerror(errno)));
+        }
+        _bytesWritten = appendAt.value_or(0);
+        _buffer.reserve(kFlushThreshold * 2);
+    }
+
+    ~DelimitedWriter() {
+        if (_file != nullptr) {
+            std::fclose(_file);
+        }
+    }
+
+    std::string& buffer() noexcept {
+        return _buffer;
+    }
+
+    void field(size_t column, std::string_view value) {
+        separator(column);
+        if (findEscapeChar(value) != std::string_view::npos) {
+            _escaped.clear();
+            appendEscaped(_escaped, value, kKeepLineBreaksAndTabs);
+            value = _escaped;
+        }
+        if (value.find_first_of(_specialChars) == std::string_view::npos) {
+            _buffer.append(value);
+            return;
+        }
+        _buffer.push_back('"');
+        for (auto ch : value) {
+            if (ch == '"') {
+                _buffer.push_back('"');
+            }
+            _buffer.push_back(ch);
+        }
+        _buffer.push_back('"');
+    }
+
+    void separator(size_t column) {
+        if (column != 0) {
+            _buffer.push_back(_delimiter);
+        }
+    }
+
+    void endRow() {
+        _buffer.push_back('\n');
+        if (_buffer.size() >= kFlushThreshold) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (!_buffer.empty() && std::fwrite(_buffer.data(), 1, _buffer.size(), _file) != _buffer.size()) {
+            throw std::runtime_error(fmt::format("error writing export file: {}", std::strerror(errno)));
+        }
+        _bytesWritten += _buffer.size();
+        _buffer.clear();
+    }
+
+    // Flushes and makes sure everything written so far is on disk.
+    void sync() {
+        flush();
+        if (std::fflush(_file) != 0 || ::fsync(fileno(_file)) != 0) {
+            throw std::runtime_error(fmt::format("error syncing export file: {}", std::strerror(errno)));
+        }
+    }
+
+    void close() {
+        flush();
+        auto file = _file;
+        _file = nullptr;
+        if (std::fclose(file) != 0) {
+            throw std::runtime_error(fmt::format("error closing export file: {}", std::strerror(errno)));
+        }
+    }
+
+    uint64_t bytesWritten() const noexcept {
+        return _bytesWritten;
+    }
+
+private:
+    std::FILE* _file = nullptr;
+    std::string _buffer;
+    std::string _escaped;
+    uint64_t _bytesWritten = 0;
+    char _delimiter;
+    const char _specialChars[5] = {_delimiter, '"', '\n', '\r', '\0'};
+};
+
+// Defines the columns that are fetched as text rather than with their default type.
+// ROWIDs always are. In raw mode NUMBER columns are fetched as text that ODPI decodes
+// straight from Oracle's decimal format, which is exact and doesn't depend on the
+// session's NLS settings, and the server hex encodes RAW columns. Dates, timestamps and
+// intervals keep their native types and the client formatters render them, as they're
+// cheap and the only way to honour the column's precision and time zone.
+void defineAsText(OracleStatement& stmt, uint32_t pos, const dpiDataTypeInfo& typeInfo, bool rawText) {
+    switch (typeInfo.oracleTypeNum) {
+    case DPI_ORACLE_TYPE_ROWID:
+        stmt.defineValue(pos, DPI_ORACLE_TYPE_VARCHAR, DPI_NATIVE_TYPE_BYTES,
+                         std::max(typeInfo.dbSizeInBytes, kRawScalarSize), false);
+        break;
+    case DPI_ORACLE_TYPE_NUMBER:
+        if (rawText) {
+            stmt.defineValue(pos, DPI_ORACLE_TYPE_NUMBER, DPI_NATIVE_TYPE_BYTES, kRawScalarSize, false);
+        }
+        break;
+    case DPI_ORACLE_TYPE_RAW:
+        if (rawText) {
+            // Two hex digits per byte.
+            stmt.defineValue(pos, DPI_ORACLE_TYPE_VARCHAR, DPI_NATIVE_TYPE_BYTES, typeInfo.dbSizeInBytes * 2, false);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Called for every column before the output file is opened, so a query that can't be
+// exported doesn't leave a partial file behind.
+void checkExportable(const OracleColumnInfo& info) {
+    switch (info.nativeType()) {
+    case DPI_NATIVE_TYPE_LOB:
+        throw std::runtime_error(fmt::format("column {} is a LOB, which can't be exported as text", info.name()));
+    case DPI_NATIVE_TYPE_STMT:
+        throw std::runtime_error(fmt::format("column {} is a cursor, which can't be exported as text", info.name()));
+    default:
+        break;
+    }
+}
+
+// How the last key written is put back into the query of a resumed export.
+std::string keyLiteral(std::string_view keyType, std::string_view key) {
+    std::string quoted = "'";
+    for (auto ch : key) {
+        quoted.push_back(ch);
+        if (ch == '\'') {
+            quoted.push_back('\'');
+        }
+    }
+    quoted.push_back('\'');
+    if (keyType == "number") {
+        return fmt::format("to_number({})", quoted);
+    }
+    return keyType == "ntext" ? "n" + quoted : quoted;
+}
+
+// The key column is fetched as text, which the server renders exactly for numbers.
+std::string_view keyTypeFor(dpiOracleTypeNum oracleType) {
+    switch (oracleType) {
+    case DPI_ORACLE_TYPE_NUMBER:
+    case DPI_ORACLE_TYPE_NATIVE_INT:
+    case DPI_ORACLE_TYPE_NATIVE_FLOAT:
+    case DPI_ORACLE_TYPE_NATIVE_DOUBLE:
+        return "number";
+    case DPI_ORACLE_TYPE_VARCHAR:
+    case DPI_ORACLE_TYPE_CHAR:
+        return "text";
+    case DPI_ORACLE_TYPE_NVARCHAR:
+    case DPI_ORACLE_TYPE_NCHAR:
+        return "ntext";
+    default:
+        throw std::runtime_error("the key column of an export must be a number or a string");
+    }
+}
+
+struct ExportColumn {
+    TemporalFormat format;
+    bool binary = false;
+    dpiObjectType* objectType = nullptr;
+};
+
+// Object, collection and JSON values are written as JSON text.
+struct ObjectWriter {
+    ObjectFormatter formatter;
+    OracleContext* ctx;
+    TemporalFormatSettings temporal;
+    std::string scratch;
+};
+
+void writeValue(DelimitedWriter& writer,
+                size_t column,
+                const OracleData& value,
+                const ExportColumn& colInfo,
+                ObjectWriter& objects) {
+    if (value.isNull()) {
+        writer.separator(column);
+        return;
+    }
+
+    auto& buf = writer.buffer();
+    switch (value.nativeType()) {
+    case DPI_NATIVE_TYPE_BYTES:
+        if (colInfo.binary) {
+            writer.separator(column);
+            appendHex(buf, value.as<std::string_view>());
+        } else {
+            writer.field(column, value.as<std::string_view>());
+        }
+        break;
+    case DPI_NATIVE_TYPE_INT64:
+        writer.separator(column);
+        fmt::format_to(std::back_inserter(buf), "{}", value.as<int64_t>());
+        break;
+    case DPI_NATIVE_TYPE_UINT64:
+        writer.separator(column);
+        fmt::format_to(std::back_inserter(buf), "{}", value.as<uint64_t>());
+        break;
+    case DPI_NATIVE_TYPE_DOUBLE:
+        writer.separator(column);
+        fmt::format_to(std::back_inserter(buf), "{}", value.as<double>());
+        break;
+    case DPI_NATIVE_TYPE_FLOAT:
+        writer.separator(column);
+        fmt::format_to(std::back_inserter(buf), "{}", value.as<float>());
+        break;
+    case DPI_NATIVE_TYPE_BOOLEAN:
+        writer.separator(column);
+        buf.append(value.as<bool>() ? "TRUE" : "FALSE");
+        break;
+    case DPI_NATIVE_TYPE_TIMESTAMP: {
+        writer.separator(column);
+        char out[kMaxTimestampLength];
+        buf.append(out, formatTimestamp(out, *value.as<dpiTimestamp*>(), colInfo.format));
+        break;
+    }
+    case DPI_NATIVE_TYPE_INTERVAL_DS: {
+        writer.separator(column);
+        char out[kMaxIntervalLength];
+        buf.append(out, formatIntervalDS(out, *value.as<dpiIntervalDS*>(), colInfo.format.fractionalDigits));
+        break;
+    }
+    case DPI_NATIVE_TYPE_INTERVAL_YM: {
+        writer.separator(column);
+        char out[kMaxIntervalLength];
+        buf.append(out, formatIntervalYM(out, *value.as<dpiIntervalYM*>()));
+        break;
+    }
+    case DPI_NATIVE_TYPE_OBJECT:
+        objects.scratch.clear();
+        objects.formatter.append(
+                objects.scratch, value.as<dpiObject*>(), colInfo.objectType, ObjectFormatter::Style::Json);
+        writer.field(column, objects.scratch);
+        break;
+    case DPI_NATIVE_TYPE_JSON:
+        objects.scratch.clear();
+        appendJson(objects.scratch,
+                   OracleJson(objects.ctx, value.as<dpiJson*>()).value(kJsonDecodeOptions),
+                   objects.temporal);
+        writer.field(column, objects.scratch);
+        break;
+    default:
+        throw std::runtime_error(fmt::format("column {} has a type that cannot be exported as text", column + 1));
+    }
+}
+} // namespace
+
+TextExportStats exportQuery(OracleConnection& conn,
+                            std::string_view sql,
+                            const std::string& path,
+                            const TextExportOptions& opts) {
+    const auto start = std::chrono::steady_clock::now();
+    // A restarted export skips as many rows as it wrote before, which are only the same
+    // rows if the query returns them in the same order every time.
+    if (opts.checkpoint && opts.keyColumn.empty() && !hasOrderBy(sql)) {
+        throw std::runtime_error("a restartable export needs key=<column> or a query with an ORDER BY");
+    }
+    std::optional<Checkpoint> checkpoint;
+    if (opts.checkpoint || !opts.keyColumn.empty()) {
+        checkpoint.emplace(Checkpoint::pathFor(path));
+        checkpoint->expect("query", sql);
+        checkpoint->expect("key", opts.keyColumn);
+    }
+    const bool resuming = checkpoint && checkpoint->resumed();
+
+    // With a key the query gets it again as an extra last column, which isn't written.
+    std::string query(sql);
+    if (!opts.keyColumn.empty()) {
+        std::string after;
+        if (resuming) {
+            after = fmt::format(" where q.{} > {}", opts.keyColumn,
+                                keyLiteral(checkpoint->get("keytype"), checkpoint->get("lastkey")));
+        }
+        query = fmt::format("select q.*, q.{0} from ({1}) q{2} order by q.{0}", opts.keyColumn, sql, after);
+    }
+
+    auto stmt = conn.prepareStatement(query);
+    stmt.setFetchArraySize(opts.fetchArraySize);
+    stmt.execute();
+
+    const auto keyPos = opts.keyColumn.empty() ? 0 : stmt.numColumns();
+    const auto numColumns = stmt.numColumns() - (keyPos != 0);
+    if (numColumns == 0) {
+        throw std::runtime_error("export requires a query that returns rows");
+    }
+    if (keyPos != 0) {
+        const auto& info = stmt.getColumnInfo(keyPos);
+        const auto keyType = keyTypeFor(info.oracleType());
+        stmt.defineValue(keyPos, DPI_ORACLE_TYPE_VARCHAR, DPI_NATIVE_TYPE_BYTES,
+                         keyType == "number" ? kRawScalarSize : info.sizeInBytes(), true);
+        checkpoint->expect("keytype", keyType);
+    }
+
+    std::vector<ExportColumn> columns(numColumns);
+    for (uint32_t pos = 1; pos <= numColumns; ++pos) {
+        const auto& info = stmt.getColumnInfo(pos);
+        checkExportable(info);
+        auto& column = columns[pos - 1];
+        column.format = opts.temporal.resolve(info.typeInfo());
+        // Raw mode has the server hex encode RAW columns, but LONG RAW can't be defined
+        // as text so it's always encoded on the client.
+        column.binary = info.oracleType() == DPI_ORACLE_TYPE_LONG_RAW ||
+            (info.oracleType() == DPI_ORACLE_TYPE_RAW && !opts.rawText);
+        column.objectType = info.typeInfo().objectType;
+        defineAsText(stmt, pos, info.typeInfo(), opts.rawText);
+    }
+
+    std::optional<uint64_t> appendAt;
+    if (resuming) {
+        appendAt = checkpoint->getNumber("bytes");
+    }
+    DelimitedWriter writer(path, opts.delimiter, appendAt);
+    if (opts.header && !resuming) {
+        for (uint32_t pos = 1; pos <= numColumns; ++pos) {
+            writer.field(pos - 1, stmt.getColumnInfo(pos).name());
+        }
+        writer.endRow();
+    }
+
+    TextExportStats stats;
+    if (resuming) {
+        stats.rows = stats.resumedRows = checkpoint->getNumber("rows");
+        // Without a key the query starts over, so skip what's already in the file.
+        for (uint64_t skipped = 0; keyPos == 0 && skipped < stats.rows; ++skipped) {
+            if (!stmt.fetch()) {
+                throw std::runtime_error(fmt::format(
+                        "the query returned fewer rows than {} records", checkpoint->path()));
+            }
+        }
+    }
+
+    ObjectWriter objects{ObjectFormatter(stmt.context(), opts.temporal), stmt.context(), opts.temporal, {}};
+    auto lastCheckpoint = writer.bytesWritten();
+    while (stmt.fetch()) {
+        for (uint32_t pos = 1; pos <= numColumns; ++pos) {
+            writeValue(writer, pos - 1, stmt.getColumnValue(pos), columns[pos - 1], objects);
+        }
+        writer.endRow();
+        ++stats.rows;
+
+        if (checkpoint && writer.bytesWritten() + writer.buffer().size() - lastCheckpoint >= kCheckpointInterval) {
+            if (keyPos != 0) {
+                const auto key = stmt.getColumnValue(keyPos);
+                if (key.isNull()) {
+                    throw std::runtime_error(fmt::format("key column {} has a null value", opts.keyColumn));
+                }
+                checkpoint->set("lastkey", std::string(key.as<std::string_view>()));
+            }
+            writer.sync();
+            lastCheckpoint = writer.bytesWritten();
+            checkpoint->set("bytes", lastCheckpoint);
+            checkpoint->set("rows", stats.rows);
+            checkpoint->save();
+        }
+    }
+    writer.close();
+    if (checkpoint) {
+        checkpoint->remove();
+    }
+
+    stats.bytes = writer.bytesWritten();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+uint64_t currentScn(OracleConnection& conn) {
+    auto query = [&conn](std::string_view sql) {
+        auto stmt = conn.prepareStatement(sql);
+        stmt.execute();
+        stmt.defineValue(1, DPI_ORACLE_TYPE_NUMBER, DPI_NATIVE_TYPE_UINT64, 0, false);
+        stmt.fetch();
+        return stmt.getColumnValue(1).as<uint64_t>();
+    };
+    try {
+        return query("select dbms_flashback.get_system_change_number from dual");
+    } catch (const OracleException&) {
+        return query("select timestamp_to_scn(systimestamp) from dual");
+    }
+}
+
+DeltaExportStats exportDelta(OracleConnection& conn,
+                             std::string_view table,
+                             const std::string& path,
+                             const std::string& statePath,
+                             bool versions,
+                             const TextExportOptions& opts) {
+    // The state is a checkpoint that is kept rather than removed at the end.
+    Checkpoint state(statePath);
+    state.expect("table", table);
+
+    DeltaExportStats stats;
+    stats.fromScn = state.getNumber("scn");
+
+    stats.toScn = currentScn(conn);
+    if (stats.toScn < stats.fromScn) {
+        throw std::runtime_error(fmt::format("the current SCN {} is older than the SCN {} in {}",
+                                             stats.toScn, stats.fromScn, statePath));
+    }
+
+    std::string query;
+    if (stats.fromScn == 0) {
+        query = fmt::format("select t.* from {} as of scn {} t", table, stats.toScn);
+    } else if (versions) {
+        query = fmt::format("select t.versions_operation as dml_operation, t.versions_startscn as dml_scn, t.* "
+                            "from {} versions between scn {} and {} t "
+                            "where t.versions_operation is not null and t.versions_startscn > {} "
+                            "order by t.versions_startscn",
+                            table, stats.fromScn, stats.toScn, stats.fromScn);
+    } else {
+        query = fmt::format("select t.* from {} as of scn {} t where t.ora_rowscn > {}",
+                            table, stats.toScn, stats.fromScn);
+    }
+
+    stats.rows = exportQuery(conn, query, path, opts);
+    state.set("scn", stats.toScn);
+    state.save();
+    return stats;
+}
+
+} // namespace sqlplusplus
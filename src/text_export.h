@@ -0,0 +1,74 @@
+#pragma once
+
+#include "oracle_helpers.h"
+#include "value_format.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+struct TextExportOptions {
+    char delimiter = ',';
+    bool header = true;
+    // Fetch NUMBER columns as exact decimal text and have the server hex encode RAW
+    // columns, instead of converting them to native types and formatting them on the
+    // client. The session's NLS settings are left alone.
+    bool rawText = false;
+    uint32_t fetchArraySize = 1000;
+    TemporalFormatSettings temporal;
+    // Record progress in a checkpoint file next to the output (see Checkpoint) and, when
+    // an earlier run left one, truncate the output to the last checkpoint and append the
+    // remaining rows. Without keyColumn the rows already written are fetched again and
+    // skipped, so the query must have an ORDER BY, on columns that make the order unique.
+    bool checkpoint = false;
+    // A unique, non-null NUMBER or character column of the query. The rows are exported
+    // in its order and a resumed export only queries the rows after the last key written.
+    std::string keyColumn;
+};
+
+struct TextExportStats {
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+    // Rows written by earlier runs, when resuming from a checkpoint.
+    uint64_t resumedRows = 0;
+    double seconds = 0;
+};
+
+// Runs the query and writes its results as delimited text to path.
+TextExportStats exportQuery(OracleConnection& conn,
+                            std::string_view sql,
+                            const std::string& path,
+                            const TextExportOptions& opts);
+
+// The database's current SCN. Exact when DBMS_FLASHBACK is granted, otherwise from
+// TIMESTAMP_TO_SCN, which may be a few seconds behind.
+uint64_t currentScn(OracleConnection& conn);
+
+struct DeltaExportStats {
+    TextExportStats rows;
+    // The export covers changes committed after fromScn up to toScn. fromScn is 0 for
+    // the first, full export.
+    uint64_t fromScn = 0;
+    uint64_t toScn = 0;
+};
+
+// Exports the rows of table changed since the SCN recorded in statePath by the previous
+// call, reading as of the current SCN, and records that SCN once the export succeeds.
+// Without a state file the whole table is exported.
+//
+// By default changed rows are found with ORA_ROWSCN. Unless the table was created with
+// ROWDEPENDENCIES that is tracked per block, so unchanged rows sharing a block with a
+// changed one are exported too, and deleted rows aren't seen at all. With versions the
+// flashback versions of the table are exported instead, each with its DML_OPERATION
+// (I, U or D) and DML_SCN, which includes deletes but only reaches back as far as the
+// undo retention.
+DeltaExportStats exportDelta(OracleConnection& conn,
+                             std::string_view table,
+                             const std::string& path,
+                             const std::string& statePath,
+                             bool versions,
+                             const TextExportOptions& opts);
+
+} // namespace sqlplusplus
@@ -0,0 +1,241 @@
+#include "value_format.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+
+#include "fmt/format.h"
+
+namespace sqlplusplus {
+
+namespace {
+constexpr char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+constexpr uint32_t kPowersOfTen[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+inline char* writeTwoDigits(char* out, uint32_t value) noexcept {
+    const auto* pair = &kDigitPairs[(value % 100) * 2];
+    out[0] = pair[0];
+    out[1] = pair[1];
+    return out + 2;
+}
+
+inline char* writeFourDigits(char* out, uint32_t value) noexcept {
+    out = writeTwoDigits(out, (value / 100) % 100);
+    return writeTwoDigits(out, value % 100);
+}
+
+// Writes exactly `digits` digits of value, zero padded on the left.
+inline char* writeFixedDigits(char* out, uint32_t value, uint8_t digits) noexcept {
+    for (auto pos = digits; pos > 0; --pos) {
+        out[pos - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + digits;
+}
+
+// Writes value with as many digits as it needs.
+inline char* writeUnsigned(char* out, uint32_t value) noexcept {
+    uint8_t digits = 1;
+    while (digits < 10 && value >= kPowersOfTen[digits]) {
+        ++digits;
+    }
+    return writeFixedDigits(out, value, digits);
+}
+
+// Writes "." followed by the first `digits` digits of a nanosecond fraction.
+inline char* writeFraction(char* out, uint32_t nanoseconds, uint8_t digits) noexcept {
+    if (digits == 0) {
+        return out;
+    }
+    *out++ = '.';
+    return writeFixedDigits(out, nanoseconds / kPowersOfTen[kMaxFractionalDigits - digits], digits);
+}
+} // namespace
+
+size_t formatTimestamp(char* out, const dpiTimestamp& ts, TemporalFormat format) noexcept {
+    auto* pos = out;
+    if (ts.year < 0) {
+        *pos++ = '-';
+    }
+    pos = writeFourDigits(pos, static_cast<uint32_t>(std::abs(ts.year)));
+    *pos++ = '-';
+    pos = writeTwoDigits(pos, ts.month);
+    *pos++ = '-';
+    pos = writeTwoDigits(pos, ts.day);
+    *pos++ = 'T';
+    pos = writeTwoDigits(pos, ts.hour);
+    *pos++ = ':';
+    pos = writeTwoDigits(pos, ts.minute);
+    *pos++ = ':';
+    pos = writeTwoDigits(pos, ts.second);
+    pos = writeFraction(pos, ts.fsecond, std::min(format.fractionalDigits, kMaxFractionalDigits));
+
+    if (format.showTimezone) {
+        const bool negative = ts.tzHourOffset < 0 || ts.tzMinuteOffset < 0;
+        *pos++ = negative ? '-' : '+';
+        pos = writeTwoDigits(pos, static_cast<uint32_t>(std::abs(ts.tzHourOffset)));
+        *pos++ = ':';
+        pos = writeTwoDigits(pos, static_cast<uint32_t>(std::abs(ts.tzMinuteOffset)));
+    }
+    return static_cast<size_t>(pos - out);
+}
+
+size_t formatIntervalDS(char* out, const dpiIntervalDS& interval, uint8_t fractionalDigits) noexcept {
+    // Oracle gives every field of a negative interval a negative sign.
+    const bool negative = interval.days < 0 || interval.hours < 0 || interval.minutes < 0 ||
+        interval.seconds < 0 || interval.fseconds < 0;
+    auto* pos = out;
+    if (negative) {
+        *pos++ = '-';
+    }
+    *pos++ = 'P';
+    pos = writeUnsigned(pos, static_cast<uint32_t>(std::abs(interval.days)));
+    *pos++ = 'D';
+    *pos++ = 'T';
+    pos = writeTwoDigits(pos, static_cast<uint32_t>(std::abs(interval.hours)));
+    *pos++ = 'H';
+    pos = writeTwoDigits(pos, static_cast<uint32_t>(std::abs(interval.minutes)));
+    *pos++ = 'M';
+    pos = writeTwoDigits(pos, static_cast<uint32_t>(std::abs(interval.seconds)));
+    pos = writeFraction(pos,
+                        static_cast<uint32_t>(std::abs(interval.fseconds)),
+                        std::min(fractionalDigits, kMaxFractionalDigits));
+    *pos++ = 'S';
+    return static_cast<size_t>(pos - out);
+}
+
+size_t formatIntervalYM(char* out, const dpiIntervalYM& interval) noexcept {
+    const bool negative = interval.years < 0 || interval.months < 0;
+    auto* pos = out;
+    if (negative) {
+        *pos++ = '-';
+    }
+    *pos++ = 'P';
+    pos = writeUnsigned(pos, static_cast<uint32_t>(std::abs(interval.years)));
+    *pos++ = 'Y';
+    pos = writeTwoDigits(pos, static_cast<uint32_t>(std::abs(interval.months)));
+    *pos++ = 'M';
+    return static_cast<size_t>(pos - out);
+}
+
+void appendEscaped(std::string& out, std::string_view value, ControlCharSet keep) {
+    size_t copiedUpTo = 0;
+    for (auto pos = findEscapeChar(value); pos != std::string_view::npos; pos = findEscapeChar(value, pos + 1)) {
+        const auto ch = static_cast<unsigned char>(value[pos]);
+        if (ch < 0x20 && (keep & (1u << ch)) != 0) {
+            continue;
+        }
+
+        out.append(value.substr(copiedUpTo, pos - copiedUpTo));
+        copiedUpTo = pos + 1;
+        switch (ch) {
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        default: {
+            constexpr char kHexDigits[] = "0123456789ABCDEF";
+            const char escape[] = {'\\', 'x', kHexDigits[ch >> 4], kHexDigits[ch & 0x0f]};
+            out.append(escape, sizeof(escape));
+        }
+        }
+    }
+    out.append(value.substr(copiedUpTo));
+}
+
+void appendHex(std::string& out, std::string_view bytes) {
+    const auto start = out.size();
+    out.resize(start + bytes.size() * 2);
+    hexEncode(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), &out[start]);
+}
+
+void appendJsonString(std::string& out, std::string_view value) {
+    out.push_back('"');
+    size_t copiedUpTo = 0;
+    for (size_t pos = 0; pos < value.size(); ++pos) {
+        const auto ch = static_cast<unsigned char>(value[pos]);
+        if (ch >= 0x20 && ch != '"' && ch != '\\') {
+            continue;
+        }
+        out.append(value.substr(copiedUpTo, pos - copiedUpTo));
+        copiedUpTo = pos + 1;
+        switch (ch) {
+        case '"':
+            out.append("\\\"");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        default: {
+            constexpr char kHexDigits[] = "0123456789abcdef";
+            const char escape[] = {'\\', 'u', '0', '0', kHexDigits[ch >> 4], kHexDigits[ch & 0x0f]};
+            out.append(escape, sizeof(escape));
+        }
+        }
+    }
+    out.append(value.substr(copiedUpTo));
+    out.push_back('"');
+}
+
+void appendJsonNumber(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out.append(std::isnan(value) ? "\"NaN\"" : value > 0 ? "\"Infinity\"" : "\"-Infinity\"");
+        return;
+    }
+    fmt::format_to(std::back_inserter(out), "{}", value);
+}
+
+TemporalFormat TemporalFormatSettings::resolve(const dpiDataTypeInfo& typeInfo) const noexcept {
+    TemporalFormat format;
+    format.fractionalDigits = fractionalDigits < 0
+        ? typeInfo.fsPrecision
+        : static_cast<uint8_t>(std::min<int>(fractionalDigits, kMaxFractionalDigits));
+
+    switch (timezone) {
+    case Timezone::Auto:
+        format.showTimezone = typeInfo.oracleTypeNum == DPI_ORACLE_TYPE_TIMESTAMP_TZ ||
+            typeInfo.oracleTypeNum == DPI_ORACLE_TYPE_TIMESTAMP_LTZ;
+        break;
+    case Timezone::Always:
+        format.showTimezone = true;
+        break;
+    case Timezone::Never:
+        format.showTimezone = false;
+        break;
+    }
+    return format;
+}
+
+} // namespace sqlplusplus
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "dpi.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sqlplusplus {
+
+// Longest possible output of formatTimestamp: -YYYY-MM-DDTHH:MM:SS.fffffffff+HH:MM
+constexpr size_t kMaxTimestampLength = 36;
+// Longest possible output of formatIntervalDS/formatIntervalYM.
+constexpr size_t kMaxIntervalLength = 48;
+constexpr uint8_t kMaxFractionalDigits = 9;
+
+struct TemporalFormat {
+    uint8_t fractionalDigits = 6;
+    bool showTimezone = false;
+};
+
+// Writes the timestamp as ISO-8601 (e.g. 2021-03-05T04:07:09.000000+05:30) to out, which
+// must have room for kMaxTimestampLength characters. Returns the number of characters written.
+size_t formatTimestamp(char* out, const dpiTimestamp& ts, TemporalFormat format) noexcept;
+
+// Writes day/second intervals as ISO-8601 durations (e.g. P3DT04H05M06.500S, -P1DT00H00M00S).
+size_t formatIntervalDS(char* out, const dpiIntervalDS& interval, uint8_t fractionalDigits) noexcept;
+
+// Writes year/month intervals as ISO-8601 durations (e.g. P2Y03M).
+size_t formatIntervalYM(char* out, const dpiIntervalYM& interval) noexcept;
+
+// Bit N set means control character N is copied as-is by appendEscaped.
+using ControlCharSet = uint32_t;
+constexpr ControlCharSet kKeepNewlines = 1u << '\n';
+constexpr ControlCharSet kKeepLineBreaksAndTabs = (1u << '\n') | (1u << '\r') | (1u << '\t');
+
+// Appends value to out, replacing control characters that aren't in keep with escapes
+// (\t, \r, \n or \xNN) so they can't corrupt the terminal or the output file. Backslashes
+// are doubled so the result can be unescaped unambiguously.
+void appendEscaped(std::string& out, std::string_view value, ControlCharSet keep);
+
+// Appends the bytes as upper-case hex, which is how Oracle renders RAW values.
+void appendHex(std::string& out, std::string_view bytes);
+
+// Appends value as a quoted JSON string, escaping quotes, backslashes and control characters.
+void appendJsonString(std::string& out, std::string_view value);
+
+// Appends value as a JSON number. NaN and infinities, which JSON can't represent, are
+// written as the strings Oracle's JSON_SERIALIZE uses.
+void appendJsonNumber(std::string& out, double value);
+
+// The user-configurable (via .set) parts of how temporal values are displayed.
+struct TemporalFormatSettings {
+    enum class Timezone { Auto, Always, Never };
+
+    // Number of fractional second digits to show, or -1 to use the column's own precision.
+    int fractionalDigits = -1;
+    // Auto only shows the offset for TIMESTAMP WITH (LOCAL) TIME ZONE columns.
+    Timezone timezone = Timezone::Auto;
+
+    TemporalFormat resolve(const dpiDataTypeInfo& typeInfo) const noexcept;
+};
+
+} // namespace sqlplusplus